@@ -0,0 +1,653 @@
+/**
+ * @file glbs_bench.c
+ * @author wdfk-prog
+ * @brief Throughput benchmark of the Grubbs' test engines.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Times every engine over a grid of window sizes, input distributions and
+ * outlier contaminations, and prints the results as JSON. The data depends
+ * only on the seed and the case, so runs are comparable across machines.
+ *
+ * Build, from a directory holding the library sources:
+ *
+ *     cc -O2 -I. bench/glbs_bench.c glbs.c glbs_simd.c glbs_stream.c glbs_fixed.c -lm -o glbs_bench
+ *
+ * Usage: glbs_bench [-s seed] [-t seconds] [-n max_n] [-e engine] [-o file]
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "glbs.h"
+
+/**
+ * @brief Upper bound on the samples generated per case.
+ */
+#define BENCH_POOL_SAMPLES (1u << 22)
+
+/**
+ * @brief Upper bound on the windows generated per case.
+ */
+#define BENCH_POOL_WINDOWS 4096
+
+/**
+ * @brief Largest outlier bound used by the generalized ESD engine.
+ */
+#define BENCH_ESD_MAX_OUTLIERS 1000
+
+/**
+ * @brief Largest masked window. A removal costs a pass over the window, so the
+ *        10% contaminations would make larger windows quadratic.
+ */
+#define BENCH_MASKED_MAX_NUM 1000
+
+/**
+ * @brief Largest stream window. A push costs O(k log N) for k outliers in the
+ *        window, so filling larger contaminated windows would dominate the run.
+ */
+#define BENCH_STREAM_MAX_NUM 1000
+
+/**
+ * @brief Location and scale of the generated samples.
+ */
+#define BENCH_MEAN  100.0
+#define BENCH_SIGMA 1.0
+
+/**
+ * @brief Input distributions.
+ */
+typedef enum bench_dist_e {
+    BENCH_DIST_NORMAL = 0, /*!< Normal samples in random order. */
+    BENCH_DIST_HEAVY,      /*!< Student-t samples with 3 degrees of freedom. */
+    BENCH_DIST_SORTED,     /*!< Normal samples, each window in ascending order. */
+    BENCH_DIST_REVERSE,    /*!< Normal samples, each window in descending order. */
+    BENCH_DIST_NUM,
+} bench_dist_t;
+
+/**
+ * @brief Outlier contaminations.
+ */
+typedef enum bench_contam_e {
+    BENCH_CONTAM_NONE = 0, /*!< No outliers. */
+    BENCH_CONTAM_SINGLE,   /*!< One point at +10 sigma. */
+    BENCH_CONTAM_TEN_PCT,  /*!< 10% of the points at +-10 sigma, random signs. */
+    BENCH_CONTAM_CLUSTER,  /*!< 10% of the points clustered around +8 sigma. */
+    BENCH_CONTAM_NUM,
+} bench_contam_t;
+
+static const char *const s_dist_names[BENCH_DIST_NUM]     = {"normal", "heavy_tailed", "sorted", "reverse_sorted"};
+static const char *const s_contam_names[BENCH_CONTAM_NUM] = {"none", "single", "10pct", "cluster"};
+
+/**
+ * @brief Window sizes of the grid.
+ */
+static const size_t s_sizes[] = {3, 5, 8, 12, 16, 20, 64, 1000, 100000, 1000000};
+
+/**
+ * @brief Data and engine state of one benchmark case.
+ */
+typedef struct bench_case_s {
+    size_t        num;     /**< Samples per window. */
+    size_t        windows; /**< Number of windows in the pool. */
+    float        *data;    /**< Windows back to back, windows * num samples. */
+    float        *soa;     /**< The same windows in structure-of-arrays layout. */
+    int16_t      *codes;   /**< The same windows as 16-bit codes. */
+    glbs_ctx_t    ctx;     /**< Context of the engine under test. */
+    void         *scratch; /**< Scratch buffer attached to ctx. */
+    glbs_fix_t    fix;     /**< Integer engine. */
+    uint32_t     *fix_kn;  /**< Critical values of the integer engine. */
+    float        *lambda;  /**< ESD critical values. */
+    size_t        esd_r;   /**< ESD outlier bound. */
+    uint32_t     *mask;    /**< Output mask of the extended engine, validity mask of the masked one. */
+    size_t       *order;   /**< Output order of the extended engine. */
+    glbs_stream_t stream;  /**< Sliding-window filter. */
+    void         *nodes;   /**< Node pool of the stream. */
+    size_t        cursor;  /**< Next sample pushed into the stream. */
+} bench_case_t;
+
+/**
+ * @brief An engine under test.
+ */
+typedef struct bench_engine_s {
+    const char *name;                              /**< Name in the output. */
+    size_t      max_n;                             /**< Largest window size it accepts. */
+    bool        per_sample;                        /**< Whether a call consumes one sample, not a window. */
+    bool        (*setup)(bench_case_t *bc);        /**< Prepares the case, or NULL. */
+    size_t      (*run)(bench_case_t *bc, size_t w); /**< Runs on window w, returns the number of calls made. */
+} bench_engine_t;
+
+/**
+ * @brief Keeps results alive so the calls are not optimized away.
+ */
+static volatile float s_sink;
+
+static uint64_t s_rng;
+
+/**
+ * @brief Returns the next output of the xorshift64* generator.
+ */
+static uint64_t bench_rand(void)
+{
+    s_rng ^= s_rng >> 12;
+    s_rng ^= s_rng << 25;
+    s_rng ^= s_rng >> 27;
+    return s_rng * UINT64_C(2685821657736338717);
+}
+
+/**
+ * @brief Returns a uniform double in the open interval (0, 1).
+ */
+static double bench_uniform(void)
+{
+    return ((bench_rand() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Returns a standard normal deviate (Box-Muller).
+ */
+static double bench_normal(void)
+{
+    return sqrt(-2.0 * log(bench_uniform())) * cos(6.283185307179586 * bench_uniform());
+}
+
+/**
+ * @brief Returns a Student-t deviate with 3 degrees of freedom.
+ */
+static double bench_heavy(void)
+{
+    double z = bench_normal();
+    double c = 0.0;
+
+    for (int i = 0; i < 3; i++) {
+        double g = bench_normal();
+        c += g * g;
+    }
+    return z / sqrt(c / 3.0);
+}
+
+/**
+ * @brief Seeds the generator from the run seed and the case parameters.
+ */
+static void bench_seed(uint64_t seed, size_t num, bench_dist_t dist, bench_contam_t contam)
+{
+    // splitmix64 of the combined key, so every case has its own stream.
+    uint64_t z = seed + UINT64_C(0x9E3779B97F4A7C15) * (num * 16 + dist * 4 + contam + 1);
+
+    z     = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z     = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    s_rng = (z ^ (z >> 31)) | 1;
+}
+
+static int bench_cmp_up(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static int bench_cmp_down(const void *a, const void *b)
+{
+    return bench_cmp_up(b, a);
+}
+
+/**
+ * @brief Fills one window with the given distribution and contamination.
+ */
+static void bench_fill(float *window, size_t num, bench_dist_t dist, bench_contam_t contam)
+{
+    size_t outliers = (num + 9) / 10;
+
+    for (size_t i = 0; i < num; i++) {
+        window[i] = (float)(BENCH_MEAN + BENCH_SIGMA * (dist == BENCH_DIST_HEAVY ? bench_heavy() : bench_normal()));
+    }
+
+    switch (contam) {
+    case BENCH_CONTAM_SINGLE:
+        window[bench_rand() % num] = (float)(BENCH_MEAN + 10.0 * BENCH_SIGMA);
+        break;
+    case BENCH_CONTAM_TEN_PCT:
+        for (size_t k = 0; k < outliers; k++) {
+            window[bench_rand() % num] =
+                (float)(BENCH_MEAN + ((bench_rand() & 1) ? 10.0 : -10.0) * BENCH_SIGMA);
+        }
+        break;
+    case BENCH_CONTAM_CLUSTER:
+        for (size_t k = 0; k < outliers; k++) {
+            window[bench_rand() % num] = (float)(BENCH_MEAN + (8.0 + 0.5 * bench_normal()) * BENCH_SIGMA);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (dist == BENCH_DIST_SORTED) {
+        qsort(window, num, sizeof(float), bench_cmp_up);
+    } else if (dist == BENCH_DIST_REVERSE) {
+        qsort(window, num, sizeof(float), bench_cmp_down);
+    }
+}
+
+/**
+ * @brief Generates the data of a case.
+ */
+static bool bench_case_init(bench_case_t *bc, size_t num, bench_dist_t dist, bench_contam_t contam, uint64_t seed)
+{
+    memset(bc, 0, sizeof(*bc));
+    bc->num     = num;
+    bc->windows = BENCH_POOL_SAMPLES / num;
+    if (bc->windows > BENCH_POOL_WINDOWS) {
+        bc->windows = BENCH_POOL_WINDOWS;
+    }
+    if (bc->windows == 0) {
+        bc->windows = 1;
+    }
+
+    bc->data = malloc(bc->windows * num * sizeof(float));
+    if (bc->data == NULL) {
+        return false;
+    }
+
+    bench_seed(seed, num, dist, contam);
+    for (size_t w = 0; w < bc->windows; w++) {
+        bench_fill(bc->data + w * num, num, dist, contam);
+    }
+    return true;
+}
+
+/**
+ * @brief Releases a case and the engine state attached to it.
+ */
+static void bench_case_free(bench_case_t *bc)
+{
+    free(bc->data);
+    free(bc->soa);
+    free(bc->codes);
+    free(bc->scratch);
+    free(bc->fix_kn);
+    free(bc->lambda);
+    free(bc->mask);
+    free(bc->order);
+    free(bc->nodes);
+    memset(bc, 0, sizeof(*bc));
+}
+
+/**
+ * @brief Resets the engine state of a case, keeping its data.
+ */
+static void bench_case_reset(bench_case_t *bc)
+{
+    bench_case_t keep = *bc;
+
+    free(bc->soa);
+    free(bc->codes);
+    free(bc->scratch);
+    free(bc->fix_kn);
+    free(bc->lambda);
+    free(bc->mask);
+    free(bc->order);
+    free(bc->nodes);
+    memset(bc, 0, sizeof(*bc));
+    bc->num     = keep.num;
+    bc->windows = keep.windows;
+    bc->data    = keep.data;
+}
+
+static bool bench_setup_ctx(bench_case_t *bc)
+{
+    glbs_ctx_init(&bc->ctx, GPN_95);
+    bc->scratch = malloc(GLBS_SCRATCH_SIZE(bc->num));
+    if (bc->scratch == NULL) {
+        return false;
+    }
+    glbs_ctx_set_scratch(&bc->ctx, bc->scratch, GLBS_SCRATCH_SIZE(bc->num));
+    return true;
+}
+
+static bool bench_setup_squared(bench_case_t *bc)
+{
+    if (!bench_setup_ctx(bc)) {
+        return false;
+    }
+    glbs_ctx_set_engine(&bc->ctx, GLBS_ENGINE_SQUARED);
+    return true;
+}
+
+static bool bench_setup_partial(bench_case_t *bc)
+{
+    if (!bench_setup_ctx(bc)) {
+        return false;
+    }
+    // Enough ordered samples per end for the two-sided 10% contamination.
+    glbs_ctx_set_partial(&bc->ctx, bc->num / 16 + 1);
+    return true;
+}
+
+static bool bench_setup_process(bench_case_t *bc)
+{
+    (void)bc;
+    glbs_init(GPN_95);
+    return true;
+}
+
+static bool bench_setup_batch(bench_case_t *bc)
+{
+    glbs_ctx_init(&bc->ctx, GPN_95);
+    bc->soa = malloc(bc->windows * bc->num * sizeof(float));
+    if (bc->soa == NULL) {
+        return false;
+    }
+    for (size_t w = 0; w < bc->windows; w++) {
+        for (size_t i = 0; i < bc->num; i++) {
+            bc->soa[i * bc->windows + w] = bc->data[w * bc->num + i];
+        }
+    }
+    return true;
+}
+
+static bool bench_setup_ex(bench_case_t *bc)
+{
+    if (!bench_setup_ctx(bc)) {
+        return false;
+    }
+    bc->mask  = malloc(GLBS_MASK_WORDS(bc->num) * sizeof(uint32_t));
+    bc->order = malloc(bc->num * sizeof(size_t));
+    return bc->mask != NULL && bc->order != NULL;
+}
+
+static bool bench_setup_masked(bench_case_t *bc)
+{
+    glbs_ctx_init(&bc->ctx, GPN_95);
+    bc->mask = malloc(GLBS_MASK_WORDS(bc->num) * sizeof(uint32_t));
+    return bc->mask != NULL;
+}
+
+static bool bench_setup_esd(bench_case_t *bc)
+{
+    if (!bench_setup_ctx(bc)) {
+        return false;
+    }
+    bc->esd_r = bc->num / 10;
+    if (bc->esd_r == 0) {
+        bc->esd_r = 1;
+    }
+    if (bc->esd_r > BENCH_ESD_MAX_OUTLIERS) {
+        bc->esd_r = BENCH_ESD_MAX_OUTLIERS;
+    }
+    bc->lambda = malloc(bc->esd_r * sizeof(float));
+    return bc->lambda != NULL && glbs_esd_lambda(bc->lambda, bc->num, bc->esd_r, bc->ctx.alpha);
+}
+
+static bool bench_setup_fixed(bench_case_t *bc)
+{
+    glbs_ctx_init(&bc->ctx, GPN_95);
+    bc->fix_kn = malloc(GLBS_GCRIT_TABLE_LEN(GLBS_FIX_MAX_NUM) * sizeof(uint32_t));
+    bc->codes  = malloc(bc->windows * bc->num * sizeof(int16_t));
+    if (bc->fix_kn == NULL || bc->codes == NULL) {
+        return false;
+    }
+
+    // 1/256 sample units per code, centered on the mean.
+    for (size_t k = 0; k < bc->windows * bc->num; k++) {
+        double code = floor((bc->data[k] - BENCH_MEAN) * 256.0 + 0.5);
+        bc->codes[k] = (int16_t)(code > INT16_MAX ? INT16_MAX : (code < INT16_MIN ? INT16_MIN : code));
+    }
+    return glbs_fix_init_ctx(&bc->fix, bc->fix_kn, &bc->ctx, GLBS_FIX_MAX_NUM);
+}
+
+static bool bench_setup_stream(bench_case_t *bc)
+{
+    float result = 0.0f;
+
+    if (!bench_setup_ctx(bc)) {
+        return false;
+    }
+    bc->nodes = malloc(GLBS_STREAM_BUFFER_SIZE(bc->num));
+    if (bc->nodes == NULL || !glbs_stream_init(&bc->stream, &bc->ctx, bc->nodes, bc->num)) {
+        return false;
+    }
+
+    // Start from a full window, as in steady state.
+    for (size_t i = 0; i < bc->num; i++) {
+        glbs_stream_push(&bc->stream, bc->data[i], &result);
+    }
+    bc->cursor = bc->num % (bc->windows * bc->num);
+    return true;
+}
+
+static size_t bench_run_process(bench_case_t *bc, size_t w)
+{
+    float result = 0.0f;
+
+    glbs_process(bc->data + w * bc->num, bc->num, &result);
+    s_sink = result;
+    return 1;
+}
+
+static size_t bench_run_ctx(bench_case_t *bc, size_t w)
+{
+    float result = 0.0f;
+
+    glbs_ctx_process(&bc->ctx, bc->data + w * bc->num, bc->num, &result);
+    s_sink = result;
+    return 1;
+}
+
+static size_t bench_run_batch(bench_case_t *bc, size_t w)
+{
+    static float results[BENCH_POOL_WINDOWS];
+
+    (void)w;
+    glbs_ctx_process_batch(&bc->ctx, bc->soa, bc->num, bc->windows, results);
+    s_sink = results[0];
+    return bc->windows;
+}
+
+static size_t bench_run_ex(bench_case_t *bc, size_t w)
+{
+    glbs_stats_t stats;
+
+    glbs_ctx_process_ex(&bc->ctx, bc->data + w * bc->num, bc->num, bc->mask, bc->order, &stats);
+    s_sink = stats.mean;
+    return 1;
+}
+
+static size_t bench_run_masked(bench_case_t *bc, size_t w)
+{
+    float result = 0.0f;
+
+    memset(bc->mask, 0xFF, GLBS_MASK_WORDS(bc->num) * sizeof(uint32_t));
+    glbs_ctx_process_masked(&bc->ctx, bc->data + w * bc->num, bc->num, bc->mask, &result);
+    s_sink = result;
+    return 1;
+}
+
+static size_t bench_run_esd(bench_case_t *bc, size_t w)
+{
+    float  result   = 0.0f;
+    size_t outliers = 0;
+
+    glbs_ctx_process_esd(&bc->ctx, bc->data + w * bc->num, bc->num, bc->esd_r, bc->lambda, &result, &outliers);
+    s_sink = result;
+    return 1;
+}
+
+static size_t bench_run_fixed(bench_case_t *bc, size_t w)
+{
+    int32_t result = 0;
+
+    glbs_fix_process_i16(&bc->fix, bc->codes + w * bc->num, bc->num, &result);
+    s_sink = (float)result;
+    return 1;
+}
+
+static size_t bench_run_stream(bench_case_t *bc, size_t w)
+{
+    float result = 0.0f;
+
+    (void)w;
+    glbs_stream_push(&bc->stream, bc->data[bc->cursor], &result);
+    bc->cursor = (bc->cursor + 1 == bc->windows * bc->num) ? 0 : bc->cursor + 1;
+    s_sink     = result;
+    return 1;
+}
+
+/**
+ * @brief Engines under test. New engines are added here.
+ */
+static const bench_engine_t s_engines[] = {
+    {"process", MAX_SAMPLE_NUM, false, bench_setup_process, bench_run_process},
+    {"ctx", SIZE_MAX, false, bench_setup_ctx, bench_run_ctx},
+    {"ctx_squared", SIZE_MAX, false, bench_setup_squared, bench_run_ctx},
+    {"ctx_partial", SIZE_MAX, false, bench_setup_partial, bench_run_ctx},
+    {"batch", MAX_SAMPLE_NUM, false, bench_setup_batch, bench_run_batch},
+    {"ex", SIZE_MAX, false, bench_setup_ex, bench_run_ex},
+    {"masked", BENCH_MASKED_MAX_NUM, false, bench_setup_masked, bench_run_masked},
+    {"esd", SIZE_MAX, false, bench_setup_esd, bench_run_esd},
+    {"fixed_i16", GLBS_FIX_MAX_NUM, false, bench_setup_fixed, bench_run_fixed},
+    {"stream", BENCH_STREAM_MAX_NUM, true, bench_setup_stream, bench_run_stream},
+};
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Times an engine on a case for at least min_time seconds.
+ *
+ * Calls run in chunks that double until a chunk takes a millisecond, so the
+ * clock reads do not weigh on short calls.
+ *
+ * @return double Nanoseconds per call; *calls receives the number of calls.
+ */
+static double bench_time(const bench_engine_t *engine, bench_case_t *bc, double min_time, size_t *calls)
+{
+    size_t chunk   = 1;
+    size_t window  = 0;
+    double start   = 0.0;
+    double elapsed = 0.0;
+
+    // One untimed call warms caches and branch predictors.
+    engine->run(bc, 0);
+
+    *calls = 0;
+    start  = bench_now();
+    do {
+        for (size_t k = 0; k < chunk; k++) {
+            *calls += engine->run(bc, window);
+            window = (window + 1 == bc->windows) ? 0 : window + 1;
+        }
+        elapsed = bench_now() - start;
+        if (elapsed < 1e-3 * chunk && chunk < ((size_t)1 << 20)) {
+            chunk *= 2;
+        }
+    } while (elapsed < min_time);
+
+    return elapsed * 1e9 / *calls;
+}
+
+static void bench_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-s seed] [-t seconds] [-n max_n] [-e engine] [-o file]\n"
+            "  -s seed     Data seed (default 1)\n"
+            "  -t seconds  Minimum time per case (default 0.05)\n"
+            "  -n max_n    Largest window size (default 1000000)\n"
+            "  -e engine   Only run this engine\n"
+            "  -o file     Write JSON to file instead of stdout\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t     seed     = 1;
+    double       min_time = 0.05;
+    size_t       max_n    = 1000000;
+    const char  *only     = NULL;
+    const char  *path     = NULL;
+    FILE        *out      = stdout;
+    bench_case_t bc;
+    bool         first    = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+            min_time = strtod(argv[++i], NULL);
+        } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            max_n = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-e") == 0) {
+            only = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+            path = argv[++i];
+        } else {
+            bench_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (path != NULL) {
+        out = fopen(path, "w");
+        if (out == NULL) {
+            perror(path);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"glbs\",\n  \"seed\": %llu,\n  \"min_time\": %g,\n  \"isa\": \"%s\",\n",
+            (unsigned long long)seed, min_time, glbs_kernels()->name);
+    fprintf(out, "  \"results\": [");
+
+    for (size_t s = 0; s < sizeof(s_sizes) / sizeof(s_sizes[0]) && s_sizes[s] <= max_n; s++) {
+        for (int d = 0; d < BENCH_DIST_NUM; d++) {
+            for (int c = 0; c < BENCH_CONTAM_NUM; c++) {
+                if (!bench_case_init(&bc, s_sizes[s], (bench_dist_t)d, (bench_contam_t)c, seed)) {
+                    fprintf(stderr, "out of memory at n=%zu\n", s_sizes[s]);
+                    return 1;
+                }
+
+                for (size_t e = 0; e < sizeof(s_engines) / sizeof(s_engines[0]); e++) {
+                    const bench_engine_t *engine = &s_engines[e];
+                    size_t                calls  = 0;
+                    double                ns     = 0.0;
+
+                    if (bc.num > engine->max_n || (only != NULL && strcmp(only, engine->name) != 0)) {
+                        continue;
+                    }
+                    if (engine->setup != NULL && !engine->setup(&bc)) {
+                        fprintf(stderr, "%s: setup failed at n=%zu\n", engine->name, bc.num);
+                        bench_case_reset(&bc);
+                        continue;
+                    }
+
+                    ns = bench_time(engine, &bc, min_time, &calls);
+                    fprintf(out,
+                            "%s\n    {\"engine\": \"%s\", \"n\": %zu, \"distribution\": \"%s\", "
+                            "\"contamination\": \"%s\", \"calls\": %zu, \"ns_per_call\": %.2f, "
+                            "\"ns_per_sample\": %.3f, \"calls_per_sec\": %.1f}",
+                            first ? "" : ",", engine->name, bc.num, s_dist_names[d], s_contam_names[c], calls, ns,
+                            engine->per_sample ? ns : ns / bc.num, 1e9 / ns);
+                    fflush(out);
+                    first = false;
+                    bench_case_reset(&bc);
+                }
+                bench_case_free(&bc);
+            }
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
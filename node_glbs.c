@@ -9,17 +9,25 @@
  *
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "glbs.h"
+#include "glbs_internal.h"
+#include "glbs_network.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 /**
- * @brief Internal data structure to hold a sample value and its validity status.
+ * @brief Below this size, introsort finishes a partition with a direct sort.
  */
-typedef struct glbs_data_s {
-    float value; /**< The floating point value of the sample. */
-    bool  valid; /**< Flag indicating if the sample is considered valid (not an outlier). */
-} glbs_data_t;
+#define GLBS_INSERTION_SORT_NUM 16
+
+#if MAX_SAMPLE_NUM != 20
+#error "glbs_network.h provides sorting networks for up to 20 elements"
+#endif
 
 /**
  * @brief Grubbs' test critical values table G_p(n).
@@ -46,9 +54,341 @@ static float gpn_data[][MAX_SAMPLE_NUM] = {
 };
 
 /**
- * @brief Static variable to store the currently configured confidence mode.
+ * @brief Squared critical values G_p(n)^2, entry by entry the square of gpn_data.
+ *
+ * Used by GLBS_ENGINE_SQUARED, which compares squared deviations and so never
+ * needs a square root.
+ */
+static const float gpn_sq_data[][MAX_SAMPLE_NUM] = {
+    /* P=99% (alpha=0.01) */
+    {1.334025, 1.334025, 1.334025, 2.226064, 3.059001, 3.779136, 4.397409, 4.928400, 5.396329, 5.808100,
+     6.175224, 6.502500, 6.796450, 7.070281, 7.317025, 7.546009, 7.756225, 7.958042, 8.726116, 8.317456},
+    /* P=95% (alpha=0.05) */
+    {1.329409, 1.329409, 1.329409, 2.140369, 2.795584, 3.319684, 3.755844, 4.129024, 4.452100, 4.734977,
+     4.990756, 5.221225, 5.433561, 5.621641, 5.803281, 5.968249, 6.125625, 6.255001, 6.411024, 6.538249},
+    /* P=90% (alpha=0.10) */
+    {1.317904, 1.317904, 1.317904, 2.030625, 2.566404, 2.989441, 3.341584, 3.644281, 3.908529, 4.145296,
+     4.359744, 4.553956, 4.730625, 4.897369, 5.049009, 5.193841, 5.331481, 5.452225, 5.574321, 5.688225},
+    /* P=80% (alpha=0.20) */
+    {1.317904, 1.317904, 1.317904, 1.336336, 1.567504, 1.766241, 2.039184, 2.277081, 2.486929, 2.676496,
+     2.849344, 3.006756, 3.150625, 3.286969, 3.411409, 3.530641, 3.644281, 3.744225, 3.845521, 3.940225},
+};
+
+/**
+ * @brief Significance level alpha of each row of gpn_data.
+ */
+static const double gpn_alpha[] = {0.01, 0.05, 0.10, 0.20};
+
+/**
+ * @brief Default context behind glbs_init() and glbs_process().
+ */
+static glbs_ctx_t s_default_ctx = {GPN_80, 0.20, true, GLBS_ENGINE_SORTED, NULL, NULL, 0, 0};
+
+/**
+ * @brief Upper-tail quantile of the standard normal distribution.
+ *
+ * Acklam's rational approximation, relative error below 1.15e-9.
+ *
+ * @param[in] p The upper-tail probability, in the open interval (0, 1).
+ *
+ * @return double x such that P(Z > x) = p.
+ */
+static double glbs_norm_quantile(double p)
+{
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double p_low = 0.02425;
+    double       q     = 0.0;
+    double       r     = 0.0;
+
+    // Tail regions, evaluated on the smaller of p and 1 - p.
+    if (p < p_low || p > 1.0 - p_low) {
+        q = sqrt(-2.0 * log(p < 0.5 ? p : 1.0 - p));
+        r = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        return p < 0.5 ? -r : r;
+    }
+
+    // Central region.
+    q = p - 0.5;
+    r = q * q;
+    return -(((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+/**
+ * @brief Hill's approximation of the upper-tail t quantile (ACM Algorithm 396).
+ *
+ * @param[in] p  The upper-tail probability, in the open interval (0, 0.5].
+ * @param[in] df The degrees of freedom, at least 1.
+ *
+ * @return double The approximate quantile.
+ */
+static double glbs_t_quantile_hill(double p, double df)
+{
+    double prob = 2.0 * p; // Algorithm 396 works on the two-tailed probability.
+    double a    = 0.0;
+    double b    = 0.0;
+    double c    = 0.0;
+    double d    = 0.0;
+    double x    = 0.0;
+    double y    = 0.0;
+
+    // Closed forms for one and two degrees of freedom.
+    if (df == 1.0) {
+        return 1.0 / tan(prob * M_PI / 2.0);
+    }
+    if (df == 2.0) {
+        return sqrt(2.0 / (prob * (2.0 - prob)) - 2.0);
+    }
+
+    a = 1.0 / (df - 0.5);
+    b = 48.0 / (a * a);
+    c = ((20700.0 * a / b - 98.0) * a - 16.0) * a + 96.36;
+    d = ((94.5 / (b + c) - 3.0) / b + 1.0) * sqrt(a * M_PI / 2.0) * df;
+    y = pow(d * prob, 2.0 / df);
+
+    if (y > 0.05 + a) {
+        // Asymptotic inverse expansion about the normal quantile.
+        x = -glbs_norm_quantile(0.5 * prob);
+        y = x * x;
+        if (df < 5.0) {
+            c += 0.3 * (df - 4.5) * (x + 0.6);
+        }
+        c = (((0.05 * d * x - 5.0) * x - 7.0) * x - 2.0) * x + b + c;
+        y = (((((0.4 * y + 6.3) * y + 36.0) * y + 94.5) / c - y - 3.0) / b + 1.0) * x;
+        y = expm1(a * y * y);
+    } else {
+        y = ((1.0 / (((df + 6.0) / (df * y) - 0.089 * d - 0.822) * (df + 2.0) * 3.0) + 0.5 / (df + 4.0)) * y - 1.0) *
+                (df + 1.0) / (df + 2.0) +
+            1.0 / y;
+    }
+
+    return sqrt(df * y);
+}
+
+/**
+ * @brief Continued fraction for the regularized incomplete beta function (Lentz).
+ *
+ * @param[in] a The first shape parameter.
+ * @param[in] b The second shape parameter.
+ * @param[in] x The evaluation point, below (a + 1) / (a + b + 2) for fast convergence.
+ *
+ * @return double The continued fraction value.
+ */
+static double glbs_beta_cf(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double       c    = 1.0;
+    double       d    = 1.0 - (a + b) * x / (a + 1.0);
+    double       h    = 0.0;
+    double       aa   = 0.0;
+    double       del  = 0.0;
+
+    if (fabs(d) < tiny) {
+        d = tiny;
+    }
+    d = 1.0 / d;
+    h = d;
+
+    for (int m = 1; m <= 400; m++) {
+        // Even step.
+        aa = m * (b - m) * x / ((a + 2 * m - 1.0) * (a + 2 * m));
+        d  = 1.0 + aa * d;
+        c  = 1.0 + aa / c;
+        d  = 1.0 / (fabs(d) < tiny ? tiny : d);
+        c  = fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+
+        // Odd step.
+        aa  = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1.0));
+        d   = 1.0 + aa * d;
+        c   = 1.0 + aa / c;
+        d   = 1.0 / (fabs(d) < tiny ? tiny : d);
+        c   = fabs(c) < tiny ? tiny : c;
+        del = d * c;
+        h *= del;
+
+        if (fabs(del - 1.0) < 1e-13) {
+            break;
+        }
+    }
+
+    return h;
+}
+
+/**
+ * @brief Upper-tail probability P(T > t) of Student's t distribution, for t >= 0.
+ *
+ * @param[in] t  The quantile, non-negative.
+ * @param[in] df The degrees of freedom.
+ *
+ * @return double The upper-tail probability.
+ */
+static double glbs_t_upper(double t, double df)
+{
+    // P(T > t) = I_x(df / 2, 1 / 2) / 2 with x = df / (df + t^2).
+    double a      = 0.5 * df;
+    double b      = 0.5;
+    double x      = df / (df + t * t);
+    double y      = t * t / (df + t * t);
+    double front  = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(y));
+
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return 0.5 * front * glbs_beta_cf(a, b, x) / a;
+    }
+    return 0.5 * (1.0 - front * glbs_beta_cf(b, a, y) / b);
+}
+
+/**
+ * @brief Probability density of Student's t distribution.
+ *
+ * @param[in] t  The quantile.
+ * @param[in] df The degrees of freedom.
+ *
+ * @return double The density at t.
+ */
+static double glbs_t_pdf(double t, double df)
+{
+    return exp(lgamma(0.5 * (df + 1.0)) - lgamma(0.5 * df) - 0.5 * log(df * M_PI) -
+               0.5 * (df + 1.0) * log1p(t * t / df));
+}
+
+/**
+ * @brief Converts a t quantile into the Grubbs' critical value for n samples.
+ *
+ * @param[in] t The upper alpha / n quantile with n - 2 degrees of freedom.
+ * @param[in] n The number of samples.
+ *
+ * @return double The critical value.
+ */
+static double glbs_gcrit_from_t(double t, double n)
+{
+    return (n - 1.0) / sqrt(n) * sqrt(t * t / (n - 2.0 + t * t));
+}
+
+/**
+ * @brief Initializes a context with a specific confidence level.
+ *
+ * @param[out] ctx  The context to initialize.
+ * @param[in]  mode The desired confidence level from gpn_mode_t.
+ */
+void glbs_ctx_init(glbs_ctx_t *ctx, gpn_mode_t mode)
+{
+    ctx->mode         = mode;
+    ctx->alpha        = glbs_mode_alpha(mode);
+    ctx->use_gpn_data = true;
+    ctx->engine       = GLBS_ENGINE_SORTED;
+    ctx->table        = NULL;
+    ctx->scratch      = NULL;
+    ctx->scratch_size = 0;
+    ctx->max_outliers = 0;
+}
+
+/**
+ * @brief Switches a context to an arbitrary significance level.
+ *
+ * @param[in,out] ctx   The context.
+ * @param[in]     alpha The significance level, in the open interval (0, 1).
+ */
+void glbs_ctx_set_alpha(glbs_ctx_t *ctx, double alpha)
+{
+    ctx->alpha        = alpha;
+    ctx->use_gpn_data = false;
+}
+
+/**
+ * @brief Attaches a precomputed critical value cache to a context.
+ *
+ * @param[in,out] ctx   The context.
+ * @param[in]     table The cache built by glbs_gcrit_table_init(), or NULL.
+ */
+void glbs_ctx_set_table(glbs_ctx_t *ctx, const glbs_gcrit_table_t *table)
+{
+    ctx->table = table;
+}
+
+/**
+ * @brief Attaches a caller-owned working buffer to a context.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     scratch The buffer, or NULL to detach.
+ * @param[in]     size    The size of the buffer in bytes.
+ */
+void glbs_ctx_set_scratch(glbs_ctx_t *ctx, void *scratch, size_t size)
+{
+    ctx->scratch      = scratch;
+    ctx->scratch_size = (scratch != NULL) ? size : 0;
+}
+
+/**
+ * @brief Selects the outlier test arithmetic of a context.
+ *
+ * @param[in,out] ctx    The context.
+ * @param[in]     engine The engine from glbs_engine_t.
+ */
+void glbs_ctx_set_engine(glbs_ctx_t *ctx, glbs_engine_t engine)
+{
+    ctx->engine = engine;
+}
+
+/**
+ * @brief Selects the partial-order engine for windows above MAX_SAMPLE_NUM.
+ *
+ * @param[in,out] ctx          The context.
+ * @param[in]     max_outliers The number of samples to order at each end, or 0.
+ */
+void glbs_ctx_set_partial(glbs_ctx_t *ctx, size_t max_outliers)
+{
+    ctx->max_outliers = max_outliers;
+}
+
+/**
+ * @brief Returns the critical value G_p(n) used by a context.
+ *
+ * @param[in] ctx The context.
+ * @param[in] n   The number of valid samples, at least MIN_SAMPLE_NUM.
+ *
+ * @return float The critical value.
+ */
+float glbs_ctx_gcrit(const glbs_ctx_t *ctx, size_t n)
+{
+    if (ctx->table != NULL && n <= ctx->table->max_n) {
+        return ctx->table->values[n];
+    }
+    if (ctx->use_gpn_data && n <= MAX_SAMPLE_NUM) {
+        return gpn_data[ctx->mode][n - 1];
+    }
+    return (float)glbs_gcrit(n, ctx->alpha);
+}
+
+/**
+ * @brief Returns the squared critical value G_p(n)^2 used by a context.
+ *
+ * Follows the same lookup order as glbs_ctx_gcrit(), reading the built-in
+ * table from gpn_sq_data.
+ *
+ * @param[in] ctx The context.
+ * @param[in] n   The number of valid samples, at least MIN_SAMPLE_NUM.
+ *
+ * @return double The squared critical value.
  */
-static gpn_mode_t s_gpn_mode = GPN_80;
+static double glbs_ctx_gcrit_sq(const glbs_ctx_t *ctx, size_t n)
+{
+    double gcrit = 0.0;
+
+    if ((ctx->table == NULL || n > ctx->table->max_n) && ctx->use_gpn_data && n <= MAX_SAMPLE_NUM) {
+        return gpn_sq_data[ctx->mode][n - 1];
+    }
+    gcrit = glbs_ctx_gcrit(ctx, n);
+    return gcrit * gcrit;
+}
 
 /**
  * @brief Initializes the Grubbs' test module with a specific confidence level.
@@ -57,122 +397,1803 @@ static gpn_mode_t s_gpn_mode = GPN_80;
  */
 void glbs_init(gpn_mode_t mode)
 {
-    s_gpn_mode = mode;
+    glbs_ctx_init(&s_default_ctx, mode);
 }
 
 /**
- * @brief Processes a set of samples to remove outliers using Grubbs' test.
+ * @brief Initializes the Grubbs' test module with an arbitrary significance level.
  *
- * @param[in]  samples Pointer to the input array of sample data.
- * @param[in]  num     The number of samples in the input array.
- * @param[out] result  Pointer to a float where the calculated average of the valid
- *                     samples will be stored.
+ * @param[in] alpha The significance level, in the open interval (0, 1).
+ */
+void glbs_init_alpha(double alpha)
+{
+    glbs_ctx_set_alpha(&s_default_ctx, alpha);
+}
+
+/**
+ * @brief Attaches a precomputed critical value cache to the module.
  *
- * @return bool Returns true on success, false on failure.
+ * @param[in] table The cache built by glbs_gcrit_table_init(), or NULL.
+ */
+void glbs_init_table(const glbs_gcrit_table_t *table)
+{
+    glbs_ctx_set_table(&s_default_ctx, table);
+}
+
+/**
+ * @brief Returns the significance level alpha of a confidence mode.
+ *
+ * @param[in] mode The confidence level from gpn_mode_t.
+ *
+ * @return double The significance level.
+ */
+double glbs_mode_alpha(gpn_mode_t mode)
+{
+    return gpn_alpha[mode];
+}
+
+/**
+ * @brief Computes the upper-tail quantile of Student's t distribution.
+ *
+ * @param[in] p  The upper-tail probability, in the open interval (0, 0.5].
+ * @param[in] df The degrees of freedom, at least 1.
+ *
+ * @return double The quantile, or 0 if the parameters are invalid.
  */
-bool glbs_process(const float *samples, uint8_t num, float *result)
+double glbs_t_quantile(double p, double df)
 {
-    glbs_data_t glbs_data[MAX_SAMPLE_NUM] = {0};
-    float       average                   = 0.0f;
-    float       std_deviation             = 0.0f;
-    float       sum                       = 0.0f;
-    float       temp                      = 0.0f;
-    float       gpi                       = 0.0f;
-    uint8_t     left_num                  = 0;
+    double t = 0.0;
+    double u = 0.0;
 
-    if (num < MIN_SAMPLE_NUM || num > MAX_SAMPLE_NUM) {
+    if (!(p > 0.0 && p <= 0.5) || !(df >= 1.0)) {
+        return 0.0;
+    }
+
+    t = glbs_t_quantile_hill(p, df);
+
+    // Newton steps on log P(T > t), which stays well conditioned far in the tail.
+    for (int i = 0; i < 2 && t > 0.0; i++) {
+        u = glbs_t_upper(t, df);
+        t += (log(u) - log(p)) * u / glbs_t_pdf(t, df);
+    }
+
+    return t;
+}
+
+/**
+ * @brief Computes the one-sided Grubbs' critical value G_crit(n, alpha).
+ *
+ * @param[in] n     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in] alpha The significance level, in the open interval (0, 1).
+ *
+ * @return double The critical value, or 0 if the parameters are invalid.
+ */
+double glbs_gcrit(size_t n, double alpha)
+{
+    if (n < MIN_SAMPLE_NUM || !(alpha > 0.0 && alpha < 1.0)) {
+        return 0.0;
+    }
+    return glbs_gcrit_from_t(glbs_t_quantile(alpha / n, (double)(n - 2)), (double)n);
+}
+
+/**
+ * @brief Computes G_crit(n, alpha) with Hill's approximation only.
+ *
+ * @param[in] n     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in] alpha The significance level, in the open interval (0, 1).
+ *
+ * @return double The critical value, or 0 if the parameters are invalid.
+ */
+double glbs_gcrit_fast(size_t n, double alpha)
+{
+    if (n < MIN_SAMPLE_NUM || !(alpha > 0.0 && alpha < 1.0)) {
+        return 0.0;
+    }
+    return glbs_gcrit_from_t(glbs_t_quantile_hill(alpha / n, (double)(n - 2)), (double)n);
+}
+
+/**
+ * @brief Fills a critical value cache for n = 0..max_n.
+ *
+ * @param[out] table  The cache descriptor to initialize.
+ * @param[in]  buffer Caller-owned storage of GLBS_GCRIT_TABLE_LEN(max_n) floats.
+ * @param[in]  max_n  The largest sample count to precompute.
+ * @param[in]  alpha  The significance level, in the open interval (0, 1).
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_gcrit_table_init(glbs_gcrit_table_t *table, float *buffer, size_t max_n, double alpha)
+{
+    if (table == NULL || buffer == NULL || !(alpha > 0.0 && alpha < 1.0)) {
         return false;
     }
 
-    // Initialize the working data array.
-    memset(glbs_data, 0, sizeof(glbs_data));
-    for (uint8_t i = 0; i < num; i++) {
-        glbs_data[i].value = samples[i];
-        glbs_data[i].valid = true;
+    for (size_t n = 0; n <= max_n; n++) {
+        buffer[n] = (n < MIN_SAMPLE_NUM) ? 0.0f : (float)glbs_gcrit(n, alpha);
     }
 
-    // Sort the data in ascending order using a simple bubble sort.
-    // An outlier, if it exists, will be either the minimum or maximum value.
-    for (uint8_t i = num - 1; i > 0; i--) {
-        for (uint8_t j = 0; j < i; j++) {
-            if (glbs_data[j].value > glbs_data[j + 1].value) {
-                temp                   = glbs_data[j].value;
-                glbs_data[j].value     = glbs_data[j + 1].value;
-                glbs_data[j + 1].value = temp;
-            }
-        }
+    table->values = buffer;
+    table->max_n  = max_n;
+    table->alpha  = alpha;
+    return true;
+}
+
+/**
+ * @brief Looks up G_crit(n) in a cache, computing it when n exceeds the cache.
+ *
+ * @param[in] table The cache built by glbs_gcrit_table_init().
+ * @param[in] n     The number of samples, at least MIN_SAMPLE_NUM.
+ *
+ * @return float The critical value.
+ */
+float glbs_gcrit_table_get(const glbs_gcrit_table_t *table, size_t n)
+{
+    if (n <= table->max_n) {
+        return table->values[n];
     }
+    return (float)glbs_gcrit(n, table->alpha);
+}
 
-    // Iteratively find and remove outliers.
-    while (1) {
-        sum      = 0.0f;
-        left_num = 0;
-        for (uint8_t i = 0; i < num; i++) {
-            if (glbs_data[i].valid) {
-                sum += glbs_data[i].value;
-                left_num++;
-            }
-        }
+/**
+ * @brief Compare-exchanges two elements so that *a <= *b, without branches.
+ */
+static void glbs_cmpx(float *a, float *b)
+{
+    float lo = (*b < *a) ? *b : *a;
+    float hi = (*b < *a) ? *a : *b;
 
-        // Stop if the number of remaining samples is too small.
-        if (left_num < MIN_SAMPLE_NUM) {
-            break;
-        }
+    *a = lo;
+    *b = hi;
+}
 
-        // Step 1: Calculate the average (mean) of the current valid data set.
-        average = sum / left_num;
+#define GLBS_NETWORK_CMPX(i, j) glbs_cmpx(&data[i], &data[j]);
 
-        // Step 2: Calculate the standard deviation of the current valid data set.
-        sum = 0.0f;
-        for (uint8_t i = 0; i < num; i++) {
-            if (glbs_data[i].valid) {
-                sum += (glbs_data[i].value - average) * (glbs_data[i].value - average);
-            }
+/**
+ * @brief Defines glbs_network_<n>(), which sorts n elements with GLBS_NETWORK_<n>.
+ */
+#define GLBS_NETWORK_DEFINE(n)                                                                                         \
+    static void glbs_network_##n(float *data)                                                                          \
+    {                                                                                                                  \
+        GLBS_NETWORK_##n(GLBS_NETWORK_CMPX)                                                                            \
+    }
+
+/**
+ * @brief Sorts zero or one element, i.e. does nothing.
+ */
+static void glbs_network_none(float *data)
+{
+    (void)data;
+}
+
+GLBS_NETWORK_DEFINE(2)
+GLBS_NETWORK_DEFINE(3)
+GLBS_NETWORK_DEFINE(4)
+GLBS_NETWORK_DEFINE(5)
+GLBS_NETWORK_DEFINE(6)
+GLBS_NETWORK_DEFINE(7)
+GLBS_NETWORK_DEFINE(8)
+GLBS_NETWORK_DEFINE(9)
+GLBS_NETWORK_DEFINE(10)
+GLBS_NETWORK_DEFINE(11)
+GLBS_NETWORK_DEFINE(12)
+GLBS_NETWORK_DEFINE(13)
+GLBS_NETWORK_DEFINE(14)
+GLBS_NETWORK_DEFINE(15)
+GLBS_NETWORK_DEFINE(16)
+GLBS_NETWORK_DEFINE(17)
+GLBS_NETWORK_DEFINE(18)
+GLBS_NETWORK_DEFINE(19)
+GLBS_NETWORK_DEFINE(20)
+
+/**
+ * @brief Sorting network of every size up to MAX_SAMPLE_NUM, indexed by size.
+ */
+static void (*const s_networks[MAX_SAMPLE_NUM + 1])(float *data) = {
+    glbs_network_none, glbs_network_none, glbs_network_2,  glbs_network_3,  glbs_network_4,  glbs_network_5,
+    glbs_network_6,    glbs_network_7,    glbs_network_8,  glbs_network_9,  glbs_network_10, glbs_network_11,
+    glbs_network_12,   glbs_network_13,   glbs_network_14, glbs_network_15, glbs_network_16, glbs_network_17,
+    glbs_network_18,   glbs_network_19,   glbs_network_20,
+};
+
+/**
+ * @brief Sorts an array in ascending order with heapsort.
+ *
+ * Used by glbs_sort() when the quicksort recursion degenerates.
+ *
+ * @param[in,out] data The array to sort.
+ * @param[in]     num  The number of elements.
+ */
+static void glbs_heap_sort(float *data, size_t num)
+{
+    for (size_t end = num, start = num / 2; end > 1;) {
+        size_t root  = 0;
+        float  value = 0.0f;
+
+        // Build the heap first, then repeatedly move the maximum to the end.
+        if (start > 0) {
+            root  = --start;
+            value = data[root];
+        } else {
+            end--;
+            value     = data[end];
+            data[end] = data[0];
         }
-        std_deviation = sqrt(sum / (left_num - 1));
-
-        // Step 3: Calculate the Grubbs' test statistic (Gi) for each point.
-        // Gi = |value - average| / std_deviation
-        uint8_t i = 0;
-        for (i = 0; i < num; i++) {
-            if (glbs_data[i].valid) {
-                // Since the data is sorted, we only need to check the min and max,
-                // but this implementation checks all points for simplicity.
-                gpi = fabs(glbs_data[i].value - average) / std_deviation;
-
-                // Step 4: Compare Gi with the critical value G_p(n) from the table.
-                // If Gi > G_p(n), the data point is an outlier.
-                if (gpi > gpn_data[s_gpn_mode][left_num - 1]) {
-                    glbs_data[i].valid = false;
-                    // Break and restart the loop with the smaller data set.
-                    break;
-                }
+
+        // Sift the value down from root.
+        for (size_t child = 2 * root + 1; child < end; child = 2 * root + 1) {
+            if (child + 1 < end && data[child + 1] > data[child]) {
+                child++;
             }
+            if (!(data[child] > value)) {
+                break;
+            }
+            data[root] = data[child];
+            root       = child;
         }
+        data[root] = value;
+    }
+}
+
+/**
+ * @brief Partitions an array about the median of its first, middle and last elements.
+ *
+ * @param[in,out] data The array, at least 3 elements.
+ * @param[in]     num  The number of elements.
+ *
+ * @return size_t The split s, with [0, s) <= pivot <= [s, num) and 0 < s < num.
+ */
+static size_t glbs_partition(float *data, size_t num)
+{
+    size_t i     = 0;
+    size_t j     = num - 1;
+    size_t mid   = num / 2;
+    float  pivot = 0.0f;
+    float  temp  = 0.0f;
+
+    // Order the first, middle and last elements and pivot on the median.
+    if (data[mid] < data[0]) {
+        temp = data[mid], data[mid] = data[0], data[0] = temp;
+    }
+    if (data[j] < data[0]) {
+        temp = data[j], data[j] = data[0], data[0] = temp;
+    }
+    if (data[j] < data[mid]) {
+        temp = data[j], data[j] = data[mid], data[mid] = temp;
+    }
+    pivot = data[mid];
 
-        // If the inner loop completed without finding any outliers, we are done.
-        if (i == num) {
+    // Hoare partition: [0, j] <= pivot <= [j + 1, num).
+    while (1) {
+        while (data[i] < pivot) {
+            i++;
+        }
+        while (pivot < data[j]) {
+            j--;
+        }
+        if (i >= j) {
             break;
         }
+        temp = data[i], data[i] = data[j], data[j] = temp;
+        i++;
+        j--;
     }
+    return j + 1;
+}
+
+/**
+ * @brief Sorts an array in ascending order with introsort.
+ *
+ * Median-of-three quicksort that switches to heapsort once the recursion depth
+ * budget is spent, and to a sorting network for short partitions.
+ *
+ * @param[in,out] data  The array to sort.
+ * @param[in]     num   The number of elements.
+ * @param[in]     depth The remaining recursion depth budget.
+ */
+static void glbs_intro_sort(float *data, size_t num, unsigned depth)
+{
+    while (num > GLBS_INSERTION_SORT_NUM) {
+        size_t split = 0;
 
-    // Calculate the final average from the remaining valid data points.
-    sum      = 0.0f;
-    left_num = 0;
-    for (uint8_t i = 0; i < num; i++) {
-        if (glbs_data[i].valid) {
-            sum += glbs_data[i].value;
-            left_num++;
+        if (depth == 0) {
+            glbs_heap_sort(data, num);
+            return;
         }
-    }
+        depth--;
+
+        // Recurse into the smaller side, loop on the larger one.
+        split = glbs_partition(data, num);
+        if (split < num - split) {
+            glbs_intro_sort(data, split, depth);
+            data += split;
+            num -= split;
+        } else {
+            glbs_intro_sort(data + split, num - split, depth);
+            num = split;
+        }
+    }
+
+    s_networks[num](data);
+}
+
+/**
+ * @brief Sorts an array in ascending order in O(n log n).
+ *
+ * Windows of up to MAX_SAMPLE_NUM samples are dispatched straight to the
+ * network of their size: a fixed sequence of branchless compare-exchanges with
+ * nothing data-dependent to mispredict. Longer arrays use introsort.
+ *
+ * @param[in,out] data The array to sort.
+ * @param[in]     num  The number of elements.
+ */
+static void glbs_sort(float *data, size_t num)
+{
+    unsigned depth = 0;
+
+    if (num <= MAX_SAMPLE_NUM) {
+        s_networks[num](data);
+        return;
+    }
+
+    for (size_t n = num; n > 1; n >>= 1) {
+        depth += 2;
+    }
+    glbs_intro_sort(data, num, depth);
+}
+
+/**
+ * @brief Moves the element of rank nth into place with introselect.
+ *
+ * Afterwards data[nth] holds the value it would have after sorting, with no
+ * larger value before it and no smaller one after it. Runs in O(n) on average
+ * and falls back to sorting once the depth budget of glbs_sort() is spent.
+ *
+ * @param[in,out] data The array.
+ * @param[in]     num  The number of elements.
+ * @param[in]     nth  The rank to select, less than num.
+ */
+static void glbs_select(float *data, size_t num, size_t nth)
+{
+    unsigned depth = 0;
+    size_t   split = 0;
+
+    for (size_t n = num; n > 1; n >>= 1) {
+        depth += 2;
+    }
+
+    while (num > GLBS_INSERTION_SORT_NUM) {
+        if (depth == 0) {
+            glbs_heap_sort(data, num);
+            return;
+        }
+        depth--;
+
+        // Only the side holding rank nth is kept.
+        split = glbs_partition(data, num);
+        if (nth < split) {
+            num = split;
+        } else {
+            data += split;
+            nth -= split;
+            num -= split;
+        }
+    }
+    s_networks[num](data);
+}
+
+/**
+ * @brief Orders the ends of a window for the trimming loop.
+ *
+ * With k = ctx->max_outliers, the k smallest samples are moved to [0, k) and
+ * the k largest to [num - k, num), both in ascending order, and the median to
+ * num / 2, leaving the rest of the middle unsorted. Small windows, or a bound
+ * too large to save work, get a full sort instead.
+ *
+ * @param[in]     ctx  The context.
+ * @param[in,out] data The working copy.
+ * @param[in]     num  The number of samples.
+ *
+ * @return size_t The number of samples in order at each end, num if sorted.
+ */
+size_t glbs_order(const glbs_ctx_t *ctx, float *data, size_t num)
+{
+    size_t k = ctx->max_outliers;
+
+    if (num <= MAX_SAMPLE_NUM || k == 0 || k >= num / 4) {
+        glbs_sort(data, num);
+        return num;
+    }
+
+    glbs_select(data, num, k);
+    glbs_sort(data, k);
+    glbs_select(data + k, num - k, num - 2 * k);
+    glbs_sort(data + num - k, k);
+
+    // glbs_trim_init() takes its reference from the median.
+    glbs_select(data + k, num - 2 * k, num / 2 - k);
+    return k;
+}
+
+/**
+ * @brief Orders (value, index) entries by value, then by index.
+ */
+#define GLBS_ENTRY_LESS(va, ia, vb, ib) ((va) < (vb) || ((va) == (vb) && (ia) < (ib)))
+
+/**
+ * @brief Swaps entries i and j of a value array and its index array.
+ */
+#define GLBS_ENTRY_SWAP(data, index, i, j)                                                                             \
+    do {                                                                                                               \
+        float    swap_value_ = (data)[i];                                                                              \
+        uint32_t swap_index_ = (index)[i];                                                                             \
+        (data)[i]            = (data)[j];                                                                              \
+        (index)[i]           = (index)[j];                                                                             \
+        (data)[j]            = swap_value_;                                                                            \
+        (index)[j]           = swap_index_;                                                                            \
+    } while (0)
+
+/**
+ * @brief Sorts a value array and its index array by value with insertion sort.
+ *
+ * @param[in,out] data  The values.
+ * @param[in,out] index The input index of each value, permuted alongside.
+ * @param[in]     num   The number of elements.
+ */
+static void glbs_insertion_sort_indexed(float *data, uint32_t *index, size_t num)
+{
+    for (size_t i = 1; i < num; i++) {
+        float    value = data[i];
+        uint32_t idx   = index[i];
+        size_t   j     = i;
+        while (j > 0 && GLBS_ENTRY_LESS(value, idx, data[j - 1], index[j - 1])) {
+            data[j]  = data[j - 1];
+            index[j] = index[j - 1];
+            j--;
+        }
+        data[j]  = value;
+        index[j] = idx;
+    }
+}
+
+/**
+ * @brief Sorts a value array and its index array by value with heapsort.
+ *
+ * @param[in,out] data  The values.
+ * @param[in,out] index The input index of each value, permuted alongside.
+ * @param[in]     num   The number of elements.
+ */
+static void glbs_heap_sort_indexed(float *data, uint32_t *index, size_t num)
+{
+    for (size_t end = num, start = num / 2; end > 1;) {
+        size_t root = 0;
+
+        // Build the heap first, then repeatedly move the maximum to the end.
+        if (start > 0) {
+            root = --start;
+        } else {
+            end--;
+            GLBS_ENTRY_SWAP(data, index, 0, end);
+        }
+
+        // Sift the entry down from root.
+        for (size_t child = 2 * root + 1; child < end; child = 2 * root + 1) {
+            if (child + 1 < end && GLBS_ENTRY_LESS(data[child], index[child], data[child + 1], index[child + 1])) {
+                child++;
+            }
+            if (!GLBS_ENTRY_LESS(data[root], index[root], data[child], index[child])) {
+                break;
+            }
+            GLBS_ENTRY_SWAP(data, index, root, child);
+            root = child;
+        }
+    }
+}
+
+/**
+ * @brief Sorts a value array and its index array by value with introsort.
+ *
+ * Same scheme as glbs_intro_sort(). Ties are broken by index, which makes the
+ * order, and so the reported removals, independent of the partitioning.
+ *
+ * @param[in,out] data  The values.
+ * @param[in,out] index The input index of each value, permuted alongside.
+ * @param[in]     num   The number of elements.
+ * @param[in]     depth The remaining recursion depth budget.
+ */
+static void glbs_intro_sort_indexed(float *data, uint32_t *index, size_t num, unsigned depth)
+{
+    while (num > GLBS_INSERTION_SORT_NUM) {
+        size_t   i           = 0;
+        size_t   j           = num - 1;
+        size_t   mid         = num / 2;
+        float    pivot       = 0.0f;
+        uint32_t pivot_index = 0;
+
+        if (depth == 0) {
+            glbs_heap_sort_indexed(data, index, num);
+            return;
+        }
+        depth--;
+
+        // Order the first, middle and last entries and pivot on the median.
+        if (GLBS_ENTRY_LESS(data[mid], index[mid], data[0], index[0])) {
+            GLBS_ENTRY_SWAP(data, index, mid, 0);
+        }
+        if (GLBS_ENTRY_LESS(data[j], index[j], data[0], index[0])) {
+            GLBS_ENTRY_SWAP(data, index, j, 0);
+        }
+        if (GLBS_ENTRY_LESS(data[j], index[j], data[mid], index[mid])) {
+            GLBS_ENTRY_SWAP(data, index, j, mid);
+        }
+        pivot       = data[mid];
+        pivot_index = index[mid];
+
+        // Hoare partition: [0, j] <= pivot <= [j + 1, num).
+        while (1) {
+            while (GLBS_ENTRY_LESS(data[i], index[i], pivot, pivot_index)) {
+                i++;
+            }
+            while (GLBS_ENTRY_LESS(pivot, pivot_index, data[j], index[j])) {
+                j--;
+            }
+            if (i >= j) {
+                break;
+            }
+            GLBS_ENTRY_SWAP(data, index, i, j);
+            i++;
+            j--;
+        }
+
+        // Recurse into the smaller side, loop on the larger one.
+        if (j + 1 < num - j - 1) {
+            glbs_intro_sort_indexed(data, index, j + 1, depth);
+            data += j + 1;
+            index += j + 1;
+            num -= j + 1;
+        } else {
+            glbs_intro_sort_indexed(data + j + 1, index + j + 1, num - j - 1, depth);
+            num = j + 1;
+        }
+    }
+
+    glbs_insertion_sort_indexed(data, index, num);
+}
+
+/**
+ * @brief Sorts a value array and its index array by value in O(n log n).
+ *
+ * @param[in,out] data  The values.
+ * @param[in,out] index The input index of each value, permuted alongside.
+ * @param[in]     num   The number of elements.
+ */
+static void glbs_sort_indexed(float *data, uint32_t *index, size_t num)
+{
+    unsigned depth = 0;
+
+    for (size_t n = num; n > 1; n >>= 1) {
+        depth += 2;
+    }
+    glbs_intro_sort_indexed(data, index, num, depth);
+}
+
+/**
+ * @brief Tells whether an end of a sorted window lies far outside its middle.
+ *
+ * Once such an end is dropped, what is left of the running sums is far smaller
+ * than the rounding error they picked up from it. An end counts as far when it
+ * lies over 1024 times farther from the median than ranks num / 4 and
+ * num - 1 - num / 4 are apart; those ranks lie on either side of the median
+ * even when glbs_order() only ordered the ends.
+ *
+ * @param[in] sorted The samples in ascending order.
+ * @param[in] num    The number of samples, at least 1.
+ * @param[in] stride The distance between consecutive samples, in floats.
+ *
+ * @return bool Returns true if the sums must carry their rounding error.
+ */
+bool glbs_trim_wild(const float *sorted, size_t num, size_t stride)
+{
+    double ref    = sorted[num / 2 * stride];
+    double spread = (double)sorted[(num - 1 - num / 4) * stride] - sorted[num / 4 * stride];
+    double reach  = ref - sorted[0];
+
+    reach = ((double)sorted[(num - 1) * stride] - ref > reach) ? (double)sorted[(num - 1) * stride] - ref : reach;
+    return reach > 1024.0 * spread;
+}
+
+/**
+ * @brief Sums the deviations of a sorted window, carrying the rounding error.
+ *
+ * @param[in,out] trim   The trim state, with ref set; its sums are replaced.
+ * @param[in]     sorted The samples in ascending order.
+ * @param[in]     num    The number of samples.
+ * @param[in]     stride The distance between consecutive samples, in floats.
+ */
+static void glbs_trim_sum_exact(glbs_trim_t *trim, const float *sorted, size_t num, size_t stride)
+{
+    trim->sum         = 0.0;
+    trim->sum_sq      = 0.0;
+    trim->sum_err     = 0.0;
+    trim->sum_sq_err  = 0.0;
+    trim->sum_sq_peak = 0.0;
+    for (size_t i = 0; i < num; i++) {
+        glbs_trim_add(trim, sorted[i * stride] - trim->ref);
+    }
+    glbs_sum_fold(&trim->sum, &trim->sum_err);
+    glbs_sum_fold(&trim->sum_sq, &trim->sum_sq_err);
+}
+
+/**
+ * @brief Initializes the running statistics over a whole sorted window.
+ *
+ * @param[out] trim   The trim state to initialize.
+ * @param[in]  sorted The samples in ascending order.
+ * @param[in]  num    The number of samples, at least 1.
+ */
+static void glbs_trim_init(glbs_trim_t *trim, const float *sorted, size_t num)
+{
+    const glbs_kernels_t *kernels = NULL;
+    double                delta   = 0.0;
+
+    trim->lo         = 0;
+    trim->hi         = num - 1;
+    trim->ref        = sorted[num / 2];
+    trim->sum        = 0.0;
+    trim->sum_sq     = 0.0;
+    trim->sum_err    = 0.0;
+    trim->sum_sq_err = 0.0;
+    trim->sorted     = sorted;
+    trim->stride     = 1;
+
+    if (glbs_trim_wild(sorted, num, 1)) {
+        glbs_trim_sum_exact(trim, sorted, num, 1);
+        return;
+    }
+
+    // Large windows go through the vector kernels; small ones keep the plain
+    // loop, which the batched path reproduces lane by lane.
+    if (num > MAX_SAMPLE_NUM) {
+        kernels      = glbs_kernels();
+        trim->sum    = kernels->sum(sorted, NULL, num, trim->ref);
+        trim->sum_sq = kernels->sum_sq(sorted, NULL, num, trim->ref);
+    } else {
+        for (size_t i = 0; i < num; i++) {
+            delta = sorted[i] - trim->ref;
+            trim->sum += delta;
+            trim->sum_sq += delta * delta;
+        }
+    }
+    trim->sum_sq_peak = trim->sum_sq;
+}
+
+/**
+ * @brief Computes the Grubbs' statistic of the more extreme end of the kept range.
+ *
+ * @param[in]  trim   The trim state.
+ * @param[in]  lo_val The value at index trim->lo.
+ * @param[in]  hi_val The value at index trim->hi.
+ * @param[out] high   Set to true if the maximum is the more extreme end.
+ *
+ * @return double Gi = |value - average| / std_deviation, or 0 if the kept range
+ *                has no spread.
+ */
+static double glbs_trim_stat(const glbs_trim_t *trim, float lo_val, float hi_val, bool *high)
+{
+    size_t n        = trim->hi - trim->lo + 1;
+    double offset   = trim->sum / n;
+    double variance = (trim->sum_sq - trim->sum * offset) / (n - 1);
+    double lo_dev   = offset - (lo_val - trim->ref);
+    double hi_dev   = (hi_val - trim->ref) - offset;
+
+    // Only the minimum or the maximum can carry the largest Gi.
+    *high = hi_dev > lo_dev;
+    if (!(variance > 0.0)) {
+        return 0.0;
+    }
+    return (*high ? hi_dev : lo_dev) / sqrt(variance);
+}
+
+/**
+ * @brief Tests the more extreme end of the kept range with multiplies only.
+ *
+ * With A = n * (value - ref) - sum and B = n * sum_sq - sum^2 = n * SS, the
+ * test Gi > G_p(n) is equivalent to A^2 * (n - 1) > G_p(n)^2 * n * B, which
+ * needs neither the standard deviation nor a division.
+ *
+ * @param[in]  trim     The trim state.
+ * @param[in]  gcrit_sq The squared critical value G_p(n)^2.
+ * @param[in]  lo_val   The value at index trim->lo.
+ * @param[in]  hi_val   The value at index trim->hi.
+ * @param[out] high     Set to true if the maximum is the more extreme end.
+ *
+ * @return bool Returns true if that end is an outlier.
+ */
+static bool glbs_trim_exceeds_sq(const glbs_trim_t *trim, double gcrit_sq, float lo_val, float hi_val, bool *high)
+{
+    double n    = (double)(trim->hi - trim->lo + 1);
+    double lo_a = trim->sum - n * (lo_val - trim->ref);
+    double hi_a = n * (hi_val - trim->ref) - trim->sum;
+    double b    = n * trim->sum_sq - trim->sum * trim->sum;
+    double a    = 0.0;
+
+    *high = hi_a > lo_a;
+    a     = *high ? hi_a : lo_a;
+    return b > 0.0 && a * a * (n - 1.0) > gcrit_sq * n * b;
+}
+
+/**
+ * @brief Drops one end of the kept range with an O(1) downdate of the sums.
+ *
+ * The rounding error carried since glbs_trim_init() is folded back in, so the
+ * sums stay exact to double precision even when the dropped term was most of
+ * them. If the spread fell far below the magnitude they are accurate relative
+ * to, the kept range is summed again about its middle from trim->sorted, when
+ * set.
+ *
+ * @param[in,out] trim   The trim state.
+ * @param[in]     high   Whether to drop the maximum rather than the minimum.
+ * @param[in]     lo_val The value at index trim->lo.
+ * @param[in]     hi_val The value at index trim->hi.
+ */
+static void glbs_trim_drop(glbs_trim_t *trim, bool high, float lo_val, float hi_val)
+{
+    double delta = (high ? hi_val : lo_val) - trim->ref;
+
+    glbs_sum_add(&trim->sum, &trim->sum_err, -delta);
+    glbs_sum_add(&trim->sum_sq, &trim->sum_sq_err, -(delta * delta));
+    glbs_sum_fold(&trim->sum, &trim->sum_err);
+    glbs_sum_fold(&trim->sum_sq, &trim->sum_sq_err);
+    if (high) {
+        trim->hi--;
+    } else {
+        trim->lo++;
+    }
+
+    // Far glitches of different magnitudes can leave only rounding error.
+    if (trim->sorted != NULL && glbs_trim_lossy(trim)) {
+        trim->ref = trim->sorted[(trim->lo + (trim->hi - trim->lo) / 2) * trim->stride];
+        glbs_trim_sum_exact(trim, trim->sorted + trim->lo * trim->stride, trim->hi - trim->lo + 1, trim->stride);
+    }
+}
+
+/**
+ * @brief Runs one Grubbs' test on the extremes of the kept range.
+ *
+ * The end with the larger deviation from the mean is tested and, if it is an
+ * outlier, dropped with an O(1) downdate of the running sums.
+ *
+ * @param[in,out] trim   The trim state.
+ * @param[in]     ctx    The context supplying the critical values.
+ * @param[in]     lo_val The value at index trim->lo.
+ * @param[in]     hi_val The value at index trim->hi.
+ *
+ * @return bool Returns true if a sample was removed, false when the test stops.
+ */
+bool glbs_trim_step(glbs_trim_t *trim, const glbs_ctx_t *ctx, float lo_val, float hi_val)
+{
+    size_t n    = trim->hi - trim->lo + 1;
+    bool   high = false;
+
+    // Stop if the number of remaining samples is too small.
+    if (n < MIN_SAMPLE_NUM) {
+        GLBS_COUNT(exhausted, 1);
+        return false;
+    }
+
+    GLBS_COUNT(iterations, 1);
+    if (ctx->engine == GLBS_ENGINE_SQUARED) {
+        if (!glbs_trim_exceeds_sq(trim, glbs_ctx_gcrit_sq(ctx, n), lo_val, hi_val, &high)) {
+            return false;
+        }
+    } else if (!(glbs_trim_stat(trim, lo_val, hi_val, &high) > glbs_ctx_gcrit(ctx, n))) {
+        // Compare Gi with G_p(n); if Gi > G_p(n), the data point is an outlier.
+        return false;
+    }
+
+    glbs_trim_drop(trim, high, lo_val, hi_val);
+    GLBS_COUNT(outliers, 1);
+    return true;
+}
+
+/**
+ * @brief Picks the working buffer for a window of num floats.
+ *
+ * Small windows use the caller's stack array, larger ones the context scratch
+ * buffer if it is big enough, and the heap otherwise.
+ *
+ * @param[in] ctx   The context.
+ * @param[in] local The stack array of MAX_SAMPLE_NUM floats.
+ * @param[in] num   The number of samples.
+ *
+ * @return float* The working buffer, or NULL if the allocation failed.
+ */
+static float *glbs_ctx_buffer(glbs_ctx_t *ctx, float *local, size_t num)
+{
+    if (num <= MAX_SAMPLE_NUM) {
+        return local;
+    }
+    if (ctx->scratch != NULL && ctx->scratch_size >= num * sizeof(float)) {
+        return ctx->scratch;
+    }
+    return malloc(num * sizeof(float));
+}
+
+/**
+ * @brief Releases a working buffer obtained from glbs_ctx_buffer().
+ *
+ * @param[in] ctx    The context.
+ * @param[in] local  The stack array passed to glbs_ctx_buffer().
+ * @param[in] buffer The working buffer.
+ */
+static void glbs_ctx_release(glbs_ctx_t *ctx, float *local, float *buffer)
+{
+    if (buffer != local && buffer != ctx->scratch) {
+        free(buffer);
+    }
+}
+
+/**
+ * @brief Returns the average of the kept range.
+ *
+ * @param[in] trim The trim state after the last step.
+ *
+ * @return float The average of the remaining valid samples.
+ */
+float glbs_trim_mean(const glbs_trim_t *trim)
+{
+    size_t left_num = trim->hi - trim->lo + 1;
 
     // Prevent division by zero if all points were discarded.
     if (left_num > 0) {
-        *result = sum / left_num;
-    } else {
-        *result = 0.0f; // Or handle as an error case.
+        return (float)(trim->ref + trim->sum / left_num);
+    }
+    return 0.0f; // Or handle as an error case.
+}
+
+/**
+ * @brief Sorts a working copy of a window and removes its outliers.
+ *
+ * @param[in]     ctx    The context.
+ * @param[in,out] data   The working copy, sorted in place.
+ * @param[in]     num    The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[out]    trim   Receives the trim state after the last step.
+ */
+static void glbs_process_trim(const glbs_ctx_t *ctx, float *data, size_t num, glbs_trim_t *trim)
+{
+    size_t ends = 0;
+
+    // Sort the data in ascending order, or at least its ends.
+    // An outlier, if it exists, will be either the minimum or maximum value.
+    ends = glbs_order(ctx, data, num);
+
+    // Iteratively find and remove outliers from either end of the sorted data.
+    glbs_trim_init(trim, data, num);
+    do {
+        // More outliers than ordered at one end: sort the middle and go on.
+        if (trim->lo >= ends || trim->hi < num - ends) {
+            glbs_sort(data + ends, num - 2 * ends);
+            ends = num;
+        }
+    } while (glbs_trim_step(trim, ctx, data[trim->lo], data[trim->hi]));
+}
+
+/**
+ * @brief Sorts a working copy of a window and removes its outliers.
+ *
+ * @param[in]     ctx    The context.
+ * @param[in,out] data   The working copy, sorted in place.
+ * @param[in]     num    The number of samples, at least MIN_SAMPLE_NUM.
+ *
+ * @return float The average of the remaining valid samples.
+ */
+static float glbs_process_data(const glbs_ctx_t *ctx, float *data, size_t num)
+{
+    glbs_trim_t trim = {0};
+
+    glbs_process_trim(ctx, data, num, &trim);
+    return glbs_trim_mean(&trim);
+}
+
+#ifdef GLBS_PROFILE
+/**
+ * @brief Sorting stage of glbs_process_data(), for the profiling driver.
+ *
+ * @param[in,out] data The working copy, sorted in place.
+ * @param[in]     num  The number of samples.
+ */
+void glbs_profile_sort(float *data, size_t num)
+{
+    glbs_sort(data, num);
+}
+
+/**
+ * @brief Summation stage of glbs_process_data(), for the profiling driver.
+ *
+ * @param[out] trim   The trim state to initialize.
+ * @param[in]  sorted The samples in ascending order.
+ * @param[in]  num    The number of samples.
+ */
+void glbs_profile_sums(glbs_trim_t *trim, const float *sorted, size_t num)
+{
+    glbs_trim_init(trim, sorted, num);
+}
+
+/**
+ * @brief Test stage of glbs_process_data(), for the profiling driver.
+ *
+ * @param[in,out] trim   The trim state from glbs_profile_sums().
+ * @param[in]     ctx    The context.
+ * @param[in]     sorted The samples in ascending order.
+ *
+ * @return float The average of the remaining valid samples.
+ */
+float glbs_profile_test(glbs_trim_t *trim, const glbs_ctx_t *ctx, const float *sorted)
+{
+    while (glbs_trim_step(trim, ctx, sorted[trim->lo], sorted[trim->hi])) {
+    }
+    return glbs_trim_mean(trim);
+}
+#endif /* GLBS_PROFILE */
+
+/**
+ * @brief Processes a set of samples to remove outliers using a context.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples in the input array.
+ * @param[out]    result  Pointer to a float where the calculated average of the
+ *                        valid samples will be stored.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process(glbs_ctx_t *ctx, const float *samples, size_t num, float *result)
+{
+    float  local_data[MAX_SAMPLE_NUM];
+    float *data = NULL;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM) {
+        GLBS_TRACE_REJECT(start);
+        return false;
     }
 
+    data = glbs_ctx_buffer(ctx, local_data, num);
+    if (data == NULL) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
 
+    GLBS_COUNT(samples, num);
+    memcpy(data, samples, num * sizeof(float));
+    *result = glbs_process_data(ctx, data, num);
+
+    glbs_ctx_release(ctx, local_data, data);
+    GLBS_TRACE_END(start);
     return true;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Removes outliers from the caller's buffer without copying it.
+ *
+ * @param[in]     ctx     The context.
+ * @param[in,out] samples Pointer to the samples, reordered in place.
+ * @param[in]     num     The number of samples.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_inplace(const glbs_ctx_t *ctx, float *samples, size_t num, float *result)
+{
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    GLBS_COUNT(samples, num);
+    *result = glbs_process_data(ctx, samples, num);
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Removes outliers and reports which samples were rejected.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples.
+ * @param[out]    mask    Packed bitmask of kept samples, or NULL.
+ * @param[out]    order   Input indices in removal order, or NULL.
+ * @param[out]    stats   Summary of the kept samples, or NULL.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_ex(glbs_ctx_t *ctx, const float *samples, size_t num, uint32_t *mask, size_t *order,
+                         glbs_stats_t *stats)
+{
+    float       local_data[MAX_SAMPLE_NUM];
+    uint32_t    local_index[MAX_SAMPLE_NUM];
+    float      *data       = local_data;
+    uint32_t   *index      = local_index;
+    glbs_trim_t trim       = {0};
+    size_t      lo         = 0;
+    size_t      hi         = 0;
+    size_t      removed    = 0;
+    size_t      iterations = 0;
+    size_t      kept       = 0;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM || num > UINT32_MAX) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    // Never allocate: larger windows need the context scratch buffer.
+    if (num > MAX_SAMPLE_NUM) {
+        if (ctx->scratch == NULL || ctx->scratch_size < GLBS_SCRATCH_SIZE(num)) {
+            GLBS_TRACE_REJECT(start);
+            return false;
+        }
+        data  = ctx->scratch;
+        index = (uint32_t *)(data + num);
+    }
+
+    GLBS_COUNT(samples, num);
+    memcpy(data, samples, num * sizeof(float));
+    for (size_t i = 0; i < num; i++) {
+        index[i] = (uint32_t)i;
+    }
+    glbs_sort_indexed(data, index, num);
+
+    // The same trim as glbs_ctx_process(), recording each dropped end.
+    glbs_trim_init(&trim, data, num);
+    while (1) {
+        lo = trim.lo;
+        hi = trim.hi;
+        if (hi - lo + 1 >= MIN_SAMPLE_NUM) {
+            iterations++;
+        }
+        if (!glbs_trim_step(&trim, ctx, data[lo], data[hi])) {
+            break;
+        }
+        if (order != NULL) {
+            order[removed] = (trim.lo != lo) ? index[lo] : index[hi];
+        }
+        removed++;
+    }
+
+    kept = trim.hi - trim.lo + 1;
+    if (mask != NULL) {
+        memset(mask, 0, GLBS_MASK_WORDS(num) * sizeof(uint32_t));
+        for (size_t i = trim.lo; i <= trim.hi; i++) {
+            mask[index[i] / 32] |= UINT32_C(1) << (index[i] % 32);
+        }
+    }
+    if (stats != NULL) {
+        stats->kept       = kept;
+        stats->mean       = glbs_trim_mean(&trim);
+        stats->std_dev    = (kept > 1) ? (float)sqrt((trim.sum_sq - trim.sum * trim.sum / kept) / (kept - 1)) : 0.0f;
+        stats->min        = data[trim.lo];
+        stats->max        = data[trim.hi];
+        stats->iterations = iterations;
+    }
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Removes outliers at several confidence levels with one sort and one trim.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples.
+ * @param[in]     modes   The confidence levels.
+ * @param[in]     count   The number of levels.
+ * @param[out]    means   Pointer to count floats receiving the averages.
+ * @param[out]    removed Pointer to count outlier counts, or NULL.
+ * @param[out]    order   Input indices in removal order, or NULL.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_levels(glbs_ctx_t *ctx, const float *samples, size_t num, const gpn_mode_t *modes,
+                             size_t count, float *means, size_t *removed, size_t *order)
+{
+    float       local_data[MAX_SAMPLE_NUM];
+    uint32_t    local_index[MAX_SAMPLE_NUM];
+    float      *data = local_data;
+    uint32_t   *index = local_index;
+    glbs_ctx_t  level[GPN_80 + 1];
+    float       level_mean[GPN_80 + 1];
+    size_t      level_removed[GPN_80 + 1];
+    unsigned    pending = 0;
+    glbs_trim_t trim    = {0};
+    size_t      n       = 0;
+    size_t      drops   = 0;
+    double      stat    = 0.0;
+    bool        high    = false;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM || num > UINT32_MAX) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+    for (size_t l = 0; l < count; l++) {
+        if ((unsigned)modes[l] > GPN_80) {
+            GLBS_TRACE_REJECT(start);
+            return false;
+        }
+        pending |= 1u << modes[l];
+    }
+
+    // The index array is only needed to report the removal order.
+    if (order == NULL) {
+        data = glbs_ctx_buffer(ctx, local_data, num);
+        if (data == NULL) {
+            GLBS_TRACE_REJECT(start);
+            return false;
+        }
+    } else if (num > MAX_SAMPLE_NUM) {
+        if (ctx->scratch == NULL || ctx->scratch_size < GLBS_SCRATCH_SIZE(num)) {
+            GLBS_TRACE_REJECT(start);
+            return false;
+        }
+        data  = ctx->scratch;
+        index = (uint32_t *)(data + num);
+    }
+
+    GLBS_COUNT(samples, num);
+    memcpy(data, samples, num * sizeof(float));
+    if (order == NULL) {
+        glbs_sort(data, num);
+    } else {
+        for (size_t i = 0; i < num; i++) {
+            index[i] = (uint32_t)i;
+        }
+        glbs_sort_indexed(data, index, num);
+    }
+
+    for (unsigned m = 0; m <= GPN_80; m++) {
+        glbs_ctx_init(&level[m], (gpn_mode_t)m);
+    }
+
+    // One test per step; every level whose critical value the statistic does
+    // not exceed stops here, and the trim goes on for the looser ones.
+    glbs_trim_init(&trim, data, num);
+    while (1) {
+        n    = trim.hi - trim.lo + 1;
+        stat = 0.0;
+        if (n >= MIN_SAMPLE_NUM) {
+            GLBS_COUNT(iterations, 1);
+            stat = glbs_trim_stat(&trim, data[trim.lo], data[trim.hi], &high);
+        } else {
+            GLBS_COUNT(exhausted, 1);
+        }
+        for (unsigned m = 0; m <= GPN_80; m++) {
+            if ((pending & (1u << m)) && (n < MIN_SAMPLE_NUM || !(stat > glbs_ctx_gcrit(&level[m], n)))) {
+                pending &= ~(1u << m);
+                level_mean[m]    = glbs_trim_mean(&trim);
+                level_removed[m] = drops;
+            }
+        }
+        if (pending == 0) {
+            break;
+        }
+
+        if (order != NULL) {
+            order[drops] = high ? index[trim.hi] : index[trim.lo];
+        }
+        glbs_trim_drop(&trim, high, data[trim.lo], data[trim.hi]);
+        GLBS_COUNT(outliers, 1);
+        drops++;
+    }
+
+    for (size_t l = 0; l < count; l++) {
+        means[l] = level_mean[modes[l]];
+        if (removed != NULL) {
+            removed[l] = level_removed[modes[l]];
+        }
+    }
+
+    if (order == NULL) {
+        glbs_ctx_release(ctx, local_data, data);
+    }
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Counts the set bits of a packed mask of num samples.
+ *
+ * @param[in] mask The mask, GLBS_MASK_WORDS(num) words.
+ * @param[in] num  The number of samples.
+ *
+ * @return size_t The number of set bits below num.
+ */
+static size_t glbs_mask_count(const uint32_t *mask, size_t num)
+{
+    size_t   count = 0;
+    uint32_t word  = 0;
+
+    for (size_t w = 0; w < GLBS_MASK_WORDS(num); w++) {
+        word = mask[w];
+        // Bits past num are not part of the mask.
+        if (w == num / 32) {
+            word &= (UINT32_C(1) << (num % 32)) - 1;
+        }
+        word = word - ((word >> 1) & UINT32_C(0x55555555));
+        word = (word & UINT32_C(0x33333333)) + ((word >> 2) & UINT32_C(0x33333333));
+        count += (((word + (word >> 4)) & UINT32_C(0x0F0F0F0F)) * UINT32_C(0x01010101)) >> 24;
+    }
+    return count;
+}
+
+/**
+ * @brief Sums the valid samples of a mask about their mean.
+ *
+ * Without a sort there is no median, so the sums are taken about the mean.
+ *
+ * @param[in,out] trim    The trim state; trim->lo and trim->hi count the valid samples.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples.
+ * @param[in]     valid   The packed validity mask, GLBS_MASK_WORDS(num) words.
+ */
+static void glbs_masked_sums(glbs_trim_t *trim, const float *samples, size_t num, const uint32_t *valid)
+{
+    const glbs_kernels_t *kernels = glbs_kernels();
+
+    trim->ref         = kernels->sum(samples, valid, num, 0.0) / (trim->hi - trim->lo + 1);
+    trim->sum         = kernels->sum(samples, valid, num, trim->ref);
+    trim->sum_sq      = kernels->sum_sq(samples, valid, num, trim->ref);
+    trim->sum_err     = 0.0;
+    trim->sum_sq_err  = 0.0;
+    trim->sum_sq_peak = trim->sum_sq;
+}
+
+/**
+ * @brief Removes outliers in a packed validity mask, leaving the samples untouched.
+ *
+ * @param[in]     ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples.
+ * @param[in,out] valid   The packed validity mask, GLBS_MASK_WORDS(num) words.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_masked(const glbs_ctx_t *ctx, const float *samples, size_t num, uint32_t *valid,
+                             float *result)
+{
+    const glbs_kernels_t *kernels = glbs_kernels();
+    glbs_trim_t           trim    = {0};
+    size_t                kept    = 0;
+    size_t                worst   = 0;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    kept = glbs_mask_count(valid, num);
+    if (kept < MIN_SAMPLE_NUM) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    // Here trim.lo and trim.hi only count the kept samples.
+    GLBS_COUNT(samples, kept);
+    trim.hi = kept - 1;
+    glbs_masked_sums(&trim, samples, num, valid);
+
+    // The sample farthest from the mean is the more extreme end, so it is
+    // passed to the test as both the minimum and the maximum. A far glitch
+    // drags the mean with it, so the sums are taken again once it is gone.
+    while (1) {
+        worst = kernels->max_dev(samples, valid, num, trim.ref + trim.sum / (trim.hi - trim.lo + 1), NULL);
+        if (!glbs_trim_step(&trim, ctx, samples[worst], samples[worst])) {
+            break;
+        }
+        valid[worst / 32] &= ~(UINT32_C(1) << (worst % 32));
+        if (glbs_trim_lossy(&trim)) {
+            glbs_masked_sums(&trim, samples, num, valid);
+        }
+    }
+
+    *result = glbs_trim_mean(&trim);
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Computes the critical values lambda_1..lambda_r of the generalized ESD test.
+ *
+ * @param[out] lambda       Caller-owned array of max_outliers floats.
+ * @param[in]  num          The number of samples per window.
+ * @param[in]  max_outliers The upper bound r on outliers.
+ * @param[in]  alpha        The significance level.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_esd_lambda(float *lambda, size_t num, size_t max_outliers, double alpha)
+{
+    if (lambda == NULL || num < MIN_SAMPLE_NUM || max_outliers > num - 2 || !(alpha > 0.0 && alpha < 1.0)) {
+        return false;
+    }
+
+    for (size_t i = 1; i <= max_outliers; i++) {
+        lambda[i - 1] = (float)glbs_gcrit(num - i + 1, alpha / 2.0);
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the critical value lambda_i of the generalized ESD test for m samples.
+ *
+ * The test is two-sided, so lambda_i is G_crit(m, alpha / 2). The context's
+ * cache is used when it was built for that level; the built-in table, which
+ * is one-sided, never applies.
+ *
+ * @param[in] ctx The context.
+ * @param[in] m   The number of samples before the removal, at least MIN_SAMPLE_NUM.
+ *
+ * @return double The critical value.
+ */
+static double glbs_ctx_esd_crit(const glbs_ctx_t *ctx, size_t m)
+{
+    double alpha = ctx->alpha / 2.0;
+
+    if (ctx->table != NULL && m <= ctx->table->max_n && ctx->table->alpha == alpha) {
+        return ctx->table->values[m];
+    }
+    return glbs_gcrit(m, alpha);
+}
+
+/**
+ * @brief Removes outliers with Rosner's generalized ESD test.
+ *
+ * @param[in,out] ctx          The context.
+ * @param[in]     samples      Pointer to the input array of sample data.
+ * @param[in]     num          The number of samples.
+ * @param[in]     max_outliers The upper bound r on outliers.
+ * @param[in]     lambda       Precomputed critical values, or NULL.
+ * @param[out]    result       Pointer to a float receiving the average.
+ * @param[out]    outliers     Pointer receiving the number of outliers, or NULL.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_esd(glbs_ctx_t *ctx, const float *samples, size_t num, size_t max_outliers,
+                          const float *lambda, float *result, size_t *outliers)
+{
+    float       local_data[MAX_SAMPLE_NUM];
+    float      *data      = NULL;
+    glbs_trim_t trim      = {0};
+    glbs_trim_t best_trim = {0};
+    size_t      best      = 0;
+    double      crit      = 0.0;
+    bool        exceeds   = false;
+    bool        high      = false;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+    if (max_outliers > num - 2) {
+        max_outliers = num - 2;
+    }
+
+    data = glbs_ctx_buffer(ctx, local_data, num);
+    if (data == NULL) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    GLBS_COUNT(samples, num);
+    memcpy(data, samples, num * sizeof(float));
+    glbs_sort(data, num);
+    glbs_trim_init(&trim, data, num);
+    best_trim = trim;
+
+    // R_i for i = 1..r, each computed after the previous extreme was removed.
+    // The answer is the largest i with R_i > lambda_i, so only the state after
+    // the latest such removal has to be kept.
+    for (size_t i = 1; i <= max_outliers; i++) {
+        crit = (lambda != NULL) ? lambda[i - 1] : glbs_ctx_esd_crit(ctx, num - i + 1);
+        if (ctx->engine == GLBS_ENGINE_SQUARED) {
+            exceeds = glbs_trim_exceeds_sq(&trim, crit * crit, data[trim.lo], data[trim.hi], &high);
+        } else {
+            exceeds = glbs_trim_stat(&trim, data[trim.lo], data[trim.hi], &high) > crit;
+        }
+        glbs_trim_drop(&trim, high, data[trim.lo], data[trim.hi]);
+        if (exceeds) {
+            best      = i;
+            best_trim = trim;
+        }
+    }
+    GLBS_COUNT(iterations, max_outliers);
+    GLBS_COUNT(outliers, best);
+
+    *result = glbs_trim_mean(&best_trim);
+    if (outliers != NULL) {
+        *outliers = best;
+    }
+
+    glbs_ctx_release(ctx, local_data, data);
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Compare-exchanges two rows of a batch tile lane by lane.
+ *
+ * Afterwards a[l] <= b[l] for every lane. The loop is branchless and has a
+ * constant trip count, so it compiles to vector min/max instructions.
+ *
+ * @param[in,out] a The row that receives the smaller values.
+ * @param[in,out] b The row that receives the larger values.
+ */
+static void glbs_lanes_cmpx(float *restrict a, float *restrict b)
+{
+    for (size_t l = 0; l < GLBS_BATCH_LANES; l++) {
+        float lo = (b[l] < a[l]) ? b[l] : a[l];
+        float hi = (b[l] < a[l]) ? a[l] : b[l];
+        a[l]     = lo;
+        b[l]     = hi;
+    }
+}
+
+#define GLBS_NETWORK_PAIR(i, j) {i, j},
+
+/**
+ * @brief Defines s_network_pairs_<n>, the comparators of GLBS_NETWORK_<n> as data.
+ */
+#define GLBS_NETWORK_PAIRS(n) static const uint8_t s_network_pairs_##n[][2] = {GLBS_NETWORK_##n(GLBS_NETWORK_PAIR)};
+
+GLBS_NETWORK_PAIRS(2)
+GLBS_NETWORK_PAIRS(3)
+GLBS_NETWORK_PAIRS(4)
+GLBS_NETWORK_PAIRS(5)
+GLBS_NETWORK_PAIRS(6)
+GLBS_NETWORK_PAIRS(7)
+GLBS_NETWORK_PAIRS(8)
+GLBS_NETWORK_PAIRS(9)
+GLBS_NETWORK_PAIRS(10)
+GLBS_NETWORK_PAIRS(11)
+GLBS_NETWORK_PAIRS(12)
+GLBS_NETWORK_PAIRS(13)
+GLBS_NETWORK_PAIRS(14)
+GLBS_NETWORK_PAIRS(15)
+GLBS_NETWORK_PAIRS(16)
+GLBS_NETWORK_PAIRS(17)
+GLBS_NETWORK_PAIRS(18)
+GLBS_NETWORK_PAIRS(19)
+GLBS_NETWORK_PAIRS(20)
+
+/**
+ * @brief Comparator list of a sorting network.
+ */
+typedef struct {
+    const uint8_t (*pairs)[2];
+    size_t num;
+} glbs_network_pairs_t;
+
+#define GLBS_NETWORK_ENTRY(n) {s_network_pairs_##n, sizeof(s_network_pairs_##n) / sizeof(s_network_pairs_##n[0])}
+
+/**
+ * @brief Comparator lists of every size up to MAX_SAMPLE_NUM, indexed by size.
+ */
+static const glbs_network_pairs_t s_network_pairs[MAX_SAMPLE_NUM + 1] = {
+    {NULL, 0},              {NULL, 0},              GLBS_NETWORK_ENTRY(2),  GLBS_NETWORK_ENTRY(3),
+    GLBS_NETWORK_ENTRY(4),  GLBS_NETWORK_ENTRY(5),  GLBS_NETWORK_ENTRY(6),  GLBS_NETWORK_ENTRY(7),
+    GLBS_NETWORK_ENTRY(8),  GLBS_NETWORK_ENTRY(9),  GLBS_NETWORK_ENTRY(10), GLBS_NETWORK_ENTRY(11),
+    GLBS_NETWORK_ENTRY(12), GLBS_NETWORK_ENTRY(13), GLBS_NETWORK_ENTRY(14), GLBS_NETWORK_ENTRY(15),
+    GLBS_NETWORK_ENTRY(16), GLBS_NETWORK_ENTRY(17), GLBS_NETWORK_ENTRY(18), GLBS_NETWORK_ENTRY(19),
+    GLBS_NETWORK_ENTRY(20),
+};
+
+/**
+ * @brief Sorts every lane of a batch tile with the sorting network of its size.
+ *
+ * @param[in,out] tile The tile, num rows of GLBS_BATCH_LANES lanes.
+ * @param[in]     num  The number of rows, at most MAX_SAMPLE_NUM.
+ */
+static void glbs_lanes_sort(float (*tile)[GLBS_BATCH_LANES], size_t num)
+{
+    const glbs_network_pairs_t *network = &s_network_pairs[num];
+
+    for (size_t k = 0; k < network->num; k++) {
+        glbs_lanes_cmpx(tile[network->pairs[k][0]], tile[network->pairs[k][1]]);
+    }
+}
+
+/**
+ * @brief Processes up to GLBS_BATCH_LANES small windows side by side.
+ *
+ * @param[in]  ctx     The context.
+ * @param[in]  samples Pointer to the first window of the group in SoA layout.
+ * @param[in]  num     The number of samples per window, at most MAX_SAMPLE_NUM.
+ * @param[in]  stride  The distance between consecutive rows, in floats.
+ * @param[in]  lanes   The number of windows in the group.
+ * @param[out] results Pointer to lanes floats receiving the averages.
+ */
+static void glbs_process_lanes(const glbs_ctx_t *ctx, const float *samples, size_t num, size_t stride,
+                               size_t lanes, float *results)
+{
+    float       tile[MAX_SAMPLE_NUM][GLBS_BATCH_LANES];
+    double      ref[GLBS_BATCH_LANES];
+    double      sum[GLBS_BATCH_LANES];
+    double      sum_sq[GLBS_BATCH_LANES];
+    glbs_trim_t trim = {0};
+
+    // Transpose the group into the tile; unused lanes are zero-filled.
+    for (size_t i = 0; i < num; i++) {
+        for (size_t l = 0; l < GLBS_BATCH_LANES; l++) {
+            tile[i][l] = (l < lanes) ? samples[i * stride + l] : 0.0f;
+        }
+    }
+
+    glbs_lanes_sort(tile, num);
+
+    // Running sums about the median of each lane, in the same order as glbs_trim_init().
+    for (size_t l = 0; l < GLBS_BATCH_LANES; l++) {
+        ref[l]    = tile[num / 2][l];
+        sum[l]    = 0.0;
+        sum_sq[l] = 0.0;
+    }
+    for (size_t i = 0; i < num; i++) {
+        for (size_t l = 0; l < GLBS_BATCH_LANES; l++) {
+            double delta = tile[i][l] - ref[l];
+            sum[l] += delta;
+            sum_sq[l] += delta * delta;
+        }
+    }
+
+    // Outlier removal only touches the ends of each lane, O(k) per window.
+    for (size_t l = 0; l < lanes; l++) {
+        trim.lo          = 0;
+        trim.hi          = num - 1;
+        trim.ref         = ref[l];
+        trim.sum         = sum[l];
+        trim.sum_sq      = sum_sq[l];
+        trim.sum_err     = 0.0;
+        trim.sum_sq_err  = 0.0;
+        trim.sum_sq_peak = sum_sq[l];
+        trim.sorted      = &tile[0][l];
+        trim.stride      = GLBS_BATCH_LANES;
+        if (glbs_trim_wild(&tile[0][l], num, GLBS_BATCH_LANES)) {
+            glbs_trim_sum_exact(&trim, &tile[0][l], num, GLBS_BATCH_LANES);
+        }
+        while (glbs_trim_step(&trim, ctx, tile[trim.lo][l], tile[trim.hi][l])) {
+        }
+        results[l] = glbs_trim_mean(&trim);
+    }
+}
+
+/**
+ * @brief Processes count windows stored side by side in rows of stride floats.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the first sample of the first window.
+ * @param[in]     num     The number of samples per window.
+ * @param[in]     stride  The distance between consecutive rows, in floats.
+ * @param[in]     count   The number of windows, at most stride.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+static bool glbs_process_rows(glbs_ctx_t *ctx, const float *samples, size_t num, size_t stride, size_t count,
+                              float *results)
+{
+    float  local_data[MAX_SAMPLE_NUM];
+    float *data = NULL;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    GLBS_COUNT(samples, num * count);
+    if (num <= MAX_SAMPLE_NUM) {
+        for (size_t w = 0; w < count; w += GLBS_BATCH_LANES) {
+            size_t lanes = (count - w < GLBS_BATCH_LANES) ? count - w : GLBS_BATCH_LANES;
+            glbs_process_lanes(ctx, samples + w, num, stride, lanes, results + w);
+        }
+        GLBS_TRACE_END(start);
+        return true;
+    }
+
+    // Large windows gain nothing from lanes; gather each one and process it alone.
+    data = glbs_ctx_buffer(ctx, local_data, num);
+    if (data == NULL) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+    for (size_t w = 0; w < count; w++) {
+        for (size_t i = 0; i < num; i++) {
+            data[i] = samples[i * stride + w];
+        }
+        results[w] = glbs_process_data(ctx, data, num);
+    }
+    glbs_ctx_release(ctx, local_data, data);
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Processes many windows of equal size in structure-of-arrays layout.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to num * count samples in SoA layout.
+ * @param[in]     num     The number of samples per window.
+ * @param[in]     count   The number of windows.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_batch(glbs_ctx_t *ctx, const float *samples, size_t num, size_t count, float *results)
+{
+    return glbs_process_rows(ctx, samples, num, count, count, results);
+}
+
+/**
+ * @brief Processes every channel of an interleaved multi-channel buffer.
+ *
+ * @param[in,out] ctx      The context.
+ * @param[in]     frames   Pointer to num frames of stride floats.
+ * @param[in]     num      The number of frames, i.e. samples per channel.
+ * @param[in]     channels The number of channels, the first floats of each frame.
+ * @param[in]     stride   The distance between consecutive frames, in floats.
+ * @param[out]    results  Pointer to channels floats receiving the averages.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_interleaved(glbs_ctx_t *ctx, const float *frames, size_t num, size_t channels, size_t stride,
+                                  float *results)
+{
+    if (stride < channels) {
+        GLBS_TRACE_BEGIN(start);
+        GLBS_COUNT(calls, 1);
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+    return glbs_process_rows(ctx, frames, num, stride, channels, results);
+}
+
+/**
+ * @brief Processes one channel read every stride floats.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the first sample.
+ * @param[in]     num     The number of samples.
+ * @param[in]     stride  The distance between consecutive samples, in floats.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_ctx_process_strided(glbs_ctx_t *ctx, const float *samples, size_t num, size_t stride, float *result)
+{
+    float  local_data[MAX_SAMPLE_NUM];
+    float *data = NULL;
+    GLBS_TRACE_BEGIN(start);
+
+    GLBS_COUNT(calls, 1);
+    if (num < MIN_SAMPLE_NUM || stride == 0) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    data = glbs_ctx_buffer(ctx, local_data, num);
+    if (data == NULL) {
+        GLBS_TRACE_REJECT(start);
+        return false;
+    }
+
+    // The gather takes the place of the copy glbs_ctx_process() makes anyway.
+    GLBS_COUNT(samples, num);
+    for (size_t i = 0; i < num; i++) {
+        data[i] = samples[i * stride];
+    }
+    *result = glbs_process_data(ctx, data, num);
+
+    glbs_ctx_release(ctx, local_data, data);
+    GLBS_TRACE_END(start);
+    return true;
+}
+
+/**
+ * @brief Defines glbs_ctx_process_<suffix>() for samples of type type.
+ *
+ * Each sample is stored as its offset from a base sample, computed in the
+ * wider type wide so that the subtraction is exact. A first pass takes the
+ * offsets from the first sample only to find the median: rounding keeps their
+ * order, so the sample whose offset has median rank is the median itself. The
+ * offsets are then taken again from it, so that a glitch in the first slot
+ * cannot set the scale at which the rest is rounded. The mean is rebuilt in
+ * double from the median and the double sums of the trim, not from the float
+ * mean of the offsets.
+ */
+#define GLBS_PROCESS_TYPED_DEFINE(suffix, type, wide)                                                                  \
+    bool glbs_ctx_process_##suffix(glbs_ctx_t *ctx, const type *samples, size_t num, double scale, double offset,      \
+                                   double *result)                                                                     \
+    {                                                                                                                  \
+        float       local_data[MAX_SAMPLE_NUM];                                                                        \
+        float      *data   = NULL;                                                                                     \
+        glbs_trim_t trim   = {0};                                                                                      \
+        wide        base   = 0;                                                                                        \
+        float       median = 0.0f;                                                                                     \
+        size_t      pivot  = 0;                                                                                        \
+        GLBS_TRACE_BEGIN(start);                                                                                       \
+                                                                                                                       \
+        GLBS_COUNT(calls, 1);                                                                                          \
+        if (num < MIN_SAMPLE_NUM) {                                                                                    \
+            GLBS_TRACE_REJECT(start);                                                                                  \
+            return false;                                                                                              \
+        }                                                                                                              \
+                                                                                                                       \
+        data = glbs_ctx_buffer(ctx, local_data, num);                                                                  \
+        if (data == NULL) {                                                                                            \
+            GLBS_TRACE_REJECT(start);                                                                                  \
+            return false;                                                                                              \
+        }                                                                                                              \
+                                                                                                                       \
+        GLBS_COUNT(samples, num);                                                                                      \
+        base = samples[0];                                                                                             \
+        for (size_t i = 0; i < num; i++) {                                                                             \
+            data[i] = (float)((wide)samples[i] - base);                                                                \
+        }                                                                                                              \
+        glbs_select(data, num, num / 2);                                                                               \
+        median = data[num / 2];                                                                                        \
+        while (pivot < num - 1 && (float)((wide)samples[pivot] - base) != median) {                                    \
+            pivot++;                                                                                                   \
+        }                                                                                                              \
+                                                                                                                       \
+        base = samples[pivot];                                                                                         \
+        for (size_t i = 0; i < num; i++) {                                                                             \
+            data[i] = (float)((wide)samples[i] - base);                                                                \
+        }                                                                                                              \
+        glbs_process_trim(ctx, data, num, &trim);                                                                      \
+        *result = ((double)base + (trim.ref + trim.sum / (trim.hi - trim.lo + 1))) * scale + offset;                   \
+                                                                                                                       \
+        glbs_ctx_release(ctx, local_data, data);                                                                       \
+        GLBS_TRACE_END(start);                                                                                         \
+        return true;                                                                                                   \
+    }
+
+GLBS_PROCESS_TYPED_DEFINE(i16, int16_t, int32_t)
+GLBS_PROCESS_TYPED_DEFINE(u16, uint16_t, int32_t)
+GLBS_PROCESS_TYPED_DEFINE(i32, int32_t, int64_t)
+GLBS_PROCESS_TYPED_DEFINE(f64, double, double)
+
+/**
+ * @brief Processes a set of samples to remove outliers using Grubbs' test.
+ *
+ * @param[in]  samples Pointer to the input array of sample data.
+ * @param[in]  num     The number of samples in the input array.
+ * @param[out] result  Pointer to a float where the calculated average of the valid
+ *                     samples will be stored.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_process(const float *samples, size_t num, float *result)
+{
+    return glbs_ctx_process(&s_default_ctx, samples, num, result);
+}
+
+/**
+ * @brief Processes many windows of equal size with the default context.
+ *
+ * @param[in]  samples Pointer to num * count samples in SoA layout.
+ * @param[in]  num     The number of samples per window.
+ * @param[in]  count   The number of windows.
+ * @param[out] results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_process_batch(const float *samples, size_t num, size_t count, float *results)
+{
+    return glbs_ctx_process_batch(&s_default_ctx, samples, num, count, results);
+}
@@ -12,18 +12,31 @@
 #define __GLBS_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief The minimum number of samples required for the Grubbs' test.
  */
 #define MIN_SAMPLE_NUM 3
 
 /**
- * @brief The maximum number of samples supported by the Grubbs' test implementation.
+ * @brief The largest sample count covered by the built-in critical value table.
+ *
+ * Larger sample counts are supported; their critical values are computed from
+ * the Student-t quantile (see glbs_gcrit()).
  */
 #define MAX_SAMPLE_NUM 20
 
+/**
+ * @brief Number of entries needed by a critical value cache covering n = 0..max_n.
+ */
+#define GLBS_GCRIT_TABLE_LEN(max_n) ((size_t)(max_n) + 1)
+
 /**
  * @brief Defines the confidence level for the Grubbs' test.
  *
@@ -38,15 +51,1157 @@ typedef enum gpn_mode_e {
     GPN_80,     /*!< 80% confidence level (alpha = 0.20) */
 } gpn_mode_t;
 
+/**
+ * @brief Precomputed critical value cache for a fixed significance level.
+ *
+ * The cache stores G_crit(n, alpha) for n = 0..max_n in a caller-provided buffer
+ * of GLBS_GCRIT_TABLE_LEN(max_n) floats. Entries below MIN_SAMPLE_NUM are zero.
+ */
+typedef struct glbs_gcrit_table_s {
+    float *values; /**< Critical values indexed by sample count n. */
+    size_t max_n;  /**< Largest sample count held by the cache. */
+    double alpha;  /**< Significance level the cache was built for. */
+} glbs_gcrit_table_t;
+
+/**
+ * @brief Scratch bytes a context needs to process num samples without allocating.
+ *
+ * Covers the working copy of the samples and the index array of
+ * glbs_ctx_process_ex().
+ */
+#define GLBS_SCRATCH_SIZE(num) ((size_t)(num) * (sizeof(float) + sizeof(uint32_t)))
+
+/**
+ * @brief Number of 32-bit words in a packed mask of num samples, one bit per sample.
+ *
+ * Bit (i % 32) of word (i / 32) refers to sample i.
+ */
+#define GLBS_MASK_WORDS(num) (((size_t)(num) + 31) / 32)
+
+/**
+ * @brief Number of windows processed side by side by the batched API.
+ *
+ * Each window occupies one lane of the working tile, so the sorting network and
+ * the sums run as element-wise loops over this many lanes.
+ */
+#define GLBS_BATCH_LANES 16
+
+/**
+ * @brief Instruction sets the reduction kernels are built for.
+ */
+typedef enum glbs_isa_e {
+    GLBS_ISA_SCALAR = 0, /*!< Portable C, always available. */
+    GLBS_ISA_SSE2,       /*!< x86 SSE2. */
+    GLBS_ISA_AVX2,       /*!< x86 AVX2. */
+    GLBS_ISA_AVX512,     /*!< x86 AVX-512F. */
+    GLBS_ISA_NEON,       /*!< AArch64 Advanced SIMD. */
+} glbs_isa_t;
+
+/**
+ * @brief Reduction kernels over a sample array with an optional validity mask.
+ *
+ * Every kernel takes a packed mask of GLBS_MASK_WORDS(num) words in which a set
+ * bit marks a valid sample, or NULL when all samples are valid. Invalid samples
+ * are masked out of the vector lanes instead of branched around.
+ *
+ * All kernels work in double precision. max_dev returns exactly the scalar
+ * result. sum and sum_sq differ from the scalar kernels only by summation
+ * order: the difference is at most 2 * num * DBL_EPSILON times the sum of the
+ * absolute values of the terms.
+ */
+typedef struct glbs_kernels_s {
+    glbs_isa_t  isa;  /**< Instruction set of this kernel set. */
+    const char *name; /**< Printable name of the instruction set. */
+
+    /** Sum of (data[i] - center) over the valid samples. */
+    double (*sum)(const float *data, const uint32_t *valid, size_t num, double center);
+
+    /** Sum of (data[i] - center)^2 over the valid samples. */
+    double (*sum_sq)(const float *data, const uint32_t *valid, size_t num, double center);
+
+    /**
+     * Index of the valid sample with the largest |data[i] - center|, the lowest
+     * index on ties, or num if no sample is valid. The deviation is stored in
+     * *deviation when it is not NULL.
+     */
+    size_t (*max_dev)(const float *data, const uint32_t *valid, size_t num, double center, double *deviation);
+} glbs_kernels_t;
+
+/**
+ * @brief Returns the kernels for the best instruction set of the running CPU.
+ *
+ * The CPU is probed on the first call; later calls return the cached choice.
+ *
+ * @return const glbs_kernels_t* The selected kernel set, never NULL.
+ */
+const glbs_kernels_t *glbs_kernels(void);
+
+/**
+ * @brief Returns the kernels for a specific instruction set.
+ *
+ * @param[in] isa The instruction set.
+ *
+ * @return const glbs_kernels_t* The kernel set, or NULL if it was not built in
+ *                               or the running CPU does not support it.
+ */
+const glbs_kernels_t *glbs_kernels_isa(glbs_isa_t isa);
+
+/**
+ * @brief Overrides the kernel set returned by glbs_kernels().
+ *
+ * Intended for testing and benchmarking the individual instruction sets.
+ *
+ * @param[in] isa The instruction set.
+ *
+ * @return bool Returns true on success, false if the set is unavailable.
+ */
+bool glbs_kernels_select(glbs_isa_t isa);
+
+/**
+ * @brief Arithmetic used by the outlier test.
+ */
+typedef enum glbs_engine_e {
+    GLBS_ENGINE_SORTED = 0, /*!< G = |x - mean| / s compared with G_p(n): one sqrt and division per step. */
+    GLBS_ENGINE_SQUARED,    /*!< (x - mean)^2 * (n - 1) > G_p(n)^2 * SS, scaled to multiplies only. */
+} glbs_engine_t;
+
+/**
+ * @brief Per-instance state of the Grubbs' test.
+ *
+ * A context holds everything a call depends on, so independent contexts can be
+ * used concurrently from different threads without locking. Give each thread
+ * its own context and scratch buffer. Initialize with glbs_ctx_init() before use.
+ */
+typedef struct glbs_ctx_s {
+    gpn_mode_t                mode;         /**< Confidence level of the built-in table. */
+    double                    alpha;        /**< Significance level for computed critical values. */
+    bool                      use_gpn_data; /**< Whether the built-in table applies for n <= MAX_SAMPLE_NUM. */
+    glbs_engine_t             engine;       /**< Arithmetic of the outlier test. */
+    const glbs_gcrit_table_t *table;        /**< Optional critical value cache, or NULL. */
+    void                     *scratch;      /**< Optional caller-owned working buffer, or NULL. */
+    size_t                    scratch_size; /**< Size of the scratch buffer in bytes. */
+    size_t                    max_outliers; /**< Ends ordered by the partial-order engine, 0 to sort fully. */
+} glbs_ctx_t;
+
+/**
+ * @brief Initializes a context with a specific confidence level.
+ *
+ * The context starts without a critical value cache or scratch buffer.
+ *
+ * @param[out] ctx  The context to initialize.
+ * @param[in]  mode The desired confidence level from gpn_mode_t.
+ */
+void glbs_ctx_init(glbs_ctx_t *ctx, gpn_mode_t mode);
+
+/**
+ * @brief Switches a context to an arbitrary significance level.
+ *
+ * @param[in,out] ctx   The context.
+ * @param[in]     alpha The significance level, in the open interval (0, 1).
+ */
+void glbs_ctx_set_alpha(glbs_ctx_t *ctx, double alpha);
+
+/**
+ * @brief Attaches a precomputed critical value cache to a context.
+ *
+ * @param[in,out] ctx   The context.
+ * @param[in]     table The cache built by glbs_gcrit_table_init(), or NULL to detach.
+ */
+void glbs_ctx_set_table(glbs_ctx_t *ctx, const glbs_gcrit_table_t *table);
+
+/**
+ * @brief Attaches a caller-owned working buffer to a context.
+ *
+ * Windows above MAX_SAMPLE_NUM use this buffer when it holds at least
+ * GLBS_SCRATCH_SIZE(num) bytes, and fall back to the heap otherwise.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     scratch The buffer, suitably aligned for float, or NULL to detach.
+ * @param[in]     size    The size of the buffer in bytes.
+ */
+void glbs_ctx_set_scratch(glbs_ctx_t *ctx, void *scratch, size_t size);
+
+/**
+ * @brief Selects the outlier test arithmetic of a context.
+ *
+ * GLBS_ENGINE_SQUARED reads squared critical values and compares squared,
+ * scaled deviations, so a removal step costs only multiplies. Its decisions
+ * can differ from GLBS_ENGINE_SORTED only when Gi is within rounding of G_p(n).
+ * The choice applies to glbs_ctx_process(), the batched windows and streams.
+ *
+ * @param[in,out] ctx    The context.
+ * @param[in]     engine The engine from glbs_engine_t.
+ */
+void glbs_ctx_set_engine(glbs_ctx_t *ctx, glbs_engine_t engine);
+
+/**
+ * @brief Selects the partial-order engine for windows above MAX_SAMPLE_NUM.
+ *
+ * Instead of sorting the whole window, glbs_ctx_process() then only moves the
+ * max_outliers smallest and largest samples to the ends in order and selects
+ * the median, in O(n + k log k) rather than O(n log n). The middle is sorted
+ * only if more than max_outliers samples are removed from one end, so results
+ * never depend on the bound; they match the full sort up to the rounding of
+ * the sums, which are accumulated in a different order.
+ *
+ * @param[in,out] ctx          The context.
+ * @param[in]     max_outliers The expected largest number of outliers per end,
+ *                             or 0 to always sort fully.
+ */
+void glbs_ctx_set_partial(glbs_ctx_t *ctx, size_t max_outliers);
+
+/**
+ * @brief Returns the critical value G_p(n) used by a context.
+ *
+ * The lookup order is the attached cache, then the built-in table, then
+ * glbs_gcrit(). The refined quantile costs about a microsecond per removal
+ * step, so attach a cache with glbs_ctx_set_table() when windows above
+ * MAX_SAMPLE_NUM are processed often.
+ *
+ * @param[in] ctx The context.
+ * @param[in] n   The number of valid samples, at least MIN_SAMPLE_NUM.
+ *
+ * @return float The critical value.
+ */
+float glbs_ctx_gcrit(const glbs_ctx_t *ctx, size_t n);
+
+/**
+ * @brief Processes a set of samples to remove outliers using a context.
+ *
+ * Reentrant counterpart of glbs_process(): only ctx and its scratch buffer are
+ * touched, so concurrent calls on distinct contexts are safe.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[out]    result  Pointer to a float where the calculated average of the
+ *                        valid samples will be stored.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer cannot be allocated.
+ */
+bool glbs_ctx_process(glbs_ctx_t *ctx, const float *samples, size_t num, float *result);
+
+/**
+ * @brief Removes outliers from the caller's buffer without copying it.
+ *
+ * Same test and mean as glbs_ctx_process(), but the samples are sorted (or,
+ * with glbs_ctx_set_partial(), partially ordered) in place instead of in a
+ * working copy, so no window size needs the stack, the scratch buffer or the
+ * heap. On return the kept samples occupy a contiguous range of the buffer.
+ *
+ * @param[in]     ctx     The context.
+ * @param[in,out] samples Pointer to the samples, reordered in place.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false if num is invalid.
+ */
+bool glbs_ctx_process_inplace(const glbs_ctx_t *ctx, float *samples, size_t num, float *result);
+
+/**
+ * @brief Processes many windows of equal size in structure-of-arrays layout.
+ *
+ * Sample i of window w is read from samples[i * count + w], i.e. the input holds
+ * num rows of count values. Windows of up to MAX_SAMPLE_NUM samples are handled
+ * GLBS_BATCH_LANES at a time, one window per lane, with a branchless sorting
+ * network applied across the lanes. Each result equals what glbs_ctx_process()
+ * returns for the same window.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to num * count samples in SoA layout.
+ * @param[in]     num     The number of samples per window, at least MIN_SAMPLE_NUM.
+ * @param[in]     count   The number of windows.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer cannot be allocated.
+ */
+bool glbs_ctx_process_batch(glbs_ctx_t *ctx, const float *samples, size_t num, size_t count, float *results);
+
+/**
+ * @brief Processes every channel of an interleaved multi-channel buffer.
+ *
+ * Sample i of channel c is read from frames[i * stride + c], as written by a
+ * DMA controller that fills frames of stride values, the first channels of
+ * which are samples. Channels are handled like the windows of
+ * glbs_ctx_process_batch(), GLBS_BATCH_LANES at a time straight from the
+ * buffer, without de-interleaving first. With stride == channels this is
+ * exactly glbs_ctx_process_batch().
+ *
+ * @param[in,out] ctx      The context.
+ * @param[in]     frames   Pointer to num frames of stride floats.
+ * @param[in]     num      The number of frames, i.e. samples per channel, at
+ *                         least MIN_SAMPLE_NUM.
+ * @param[in]     channels The number of channels to process.
+ * @param[in]     stride   The distance between consecutive frames in floats,
+ *                         at least channels.
+ * @param[out]    results  Pointer to channels floats receiving the averages.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer cannot be allocated.
+ */
+bool glbs_ctx_process_interleaved(glbs_ctx_t *ctx, const float *frames, size_t num, size_t channels, size_t stride,
+                                  float *results);
+
+/**
+ * @brief Processes one channel read every stride floats.
+ *
+ * Same as glbs_ctx_process() on samples[0], samples[stride], ...; the samples
+ * are gathered straight into the working buffer.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the first sample.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in]     stride  The distance between consecutive samples in floats,
+ *                        at least 1.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer cannot be allocated.
+ */
+bool glbs_ctx_process_strided(glbs_ctx_t *ctx, const float *samples, size_t num, size_t stride, float *result);
+
+/**
+ * @brief Processes raw samples of a native type, without a float conversion pass.
+ *
+ * The samples are read straight into the working buffer as offsets from the
+ * median sample, so the float pipeline only has to resolve the spread of the
+ * window, not its magnitude, and a glitch anywhere in the window does not
+ * cost the other samples precision: 16-bit codes, and 32-bit codes within
+ * 2^24 of the median, are exact. Finding the median takes one extra
+ * conversion and selection pass. The mean is rebuilt in double from the
+ * median and the double sums of the trim, and mapped to physical units once,
+ * as result = mean * scale + offset; pass 1.0 and 0.0 for raw units.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of samples.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in]     scale   The factor applied to the mean.
+ * @param[in]     offset  The offset added to the scaled mean.
+ * @param[out]    result  Pointer receiving the scaled average of the valid samples.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer cannot be allocated.
+ */
+bool glbs_ctx_process_i16(glbs_ctx_t *ctx, const int16_t *samples, size_t num, double scale, double offset,
+                          double *result);
+
+/**
+ * @brief Processes unsigned 16-bit samples, see glbs_ctx_process_i16().
+ */
+bool glbs_ctx_process_u16(glbs_ctx_t *ctx, const uint16_t *samples, size_t num, double scale, double offset,
+                          double *result);
+
+/**
+ * @brief Processes signed 32-bit samples, see glbs_ctx_process_i16().
+ */
+bool glbs_ctx_process_i32(glbs_ctx_t *ctx, const int32_t *samples, size_t num, double scale, double offset,
+                          double *result);
+
+/**
+ * @brief Processes double samples, see glbs_ctx_process_i16().
+ */
+bool glbs_ctx_process_f64(glbs_ctx_t *ctx, const double *samples, size_t num, double scale, double offset,
+                          double *result);
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+/**
+ * @brief Selects the typed entry point from the type of samples (C11).
+ */
+#define glbs_ctx_process_typed(ctx, samples, num, scale, offset, result)                                             \
+    _Generic((samples),                                                                                              \
+        const int16_t *: glbs_ctx_process_i16,                                                                       \
+        int16_t *: glbs_ctx_process_i16,                                                                             \
+        const uint16_t *: glbs_ctx_process_u16,                                                                      \
+        uint16_t *: glbs_ctx_process_u16,                                                                            \
+        const int32_t *: glbs_ctx_process_i32,                                                                       \
+        int32_t *: glbs_ctx_process_i32,                                                                             \
+        const double *: glbs_ctx_process_f64,                                                                        \
+        double *: glbs_ctx_process_f64)(ctx, samples, num, scale, offset, result)
+#endif
+
+/**
+ * @brief Summary of the samples kept by glbs_ctx_process_ex().
+ */
+typedef struct glbs_stats_s {
+    size_t kept;       /**< Number of kept samples; num - kept were removed. */
+    float  mean;       /**< Average of the kept samples, as returned by glbs_ctx_process(). */
+    float  std_dev;    /**< Sample standard deviation of the kept samples. */
+    float  min;        /**< Smallest kept sample. */
+    float  max;        /**< Largest kept sample. */
+    size_t iterations; /**< Number of Grubbs' tests run, including the final non-significant one. */
+} glbs_stats_t;
+
+/**
+ * @brief Removes outliers and reports which samples were rejected.
+ *
+ * Same test and mean as glbs_ctx_process(), with the decisions mapped back to
+ * the caller's indices in the same pass. Among equal values, the one with the
+ * lower index sorts first. Nothing is allocated: windows above MAX_SAMPLE_NUM
+ * need a context scratch buffer of at least GLBS_SCRATCH_SIZE(num) bytes.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[out]    mask    Caller-owned array of GLBS_MASK_WORDS(num) words receiving
+ *                        a set bit for every kept sample (bit i % 32 of word
+ *                        i / 32), or NULL.
+ * @param[out]    order   Caller-owned array of num entries receiving the input
+ *                        indices of the removed samples in removal order (the
+ *                        first num - stats->kept entries), or NULL.
+ * @param[out]    stats   Pointer receiving the summary of the kept samples, or NULL.
+ *
+ * @return bool Returns true on success, false if num is invalid or the scratch
+ *              buffer is missing.
+ */
+bool glbs_ctx_process_ex(glbs_ctx_t *ctx, const float *samples, size_t num, uint32_t *mask, size_t *order,
+                         glbs_stats_t *stats);
+
+/**
+ * @brief Removes outliers in a packed validity mask, leaving the samples untouched.
+ *
+ * No sort and no working copy: each step finds the valid sample farthest from
+ * the mean with the max_dev kernel and, if the test rejects it, clears its bit
+ * and downdates the sums. The cost is O(num) per removal, against the
+ * O(num log num) sort of the other engines, and the memory used is exactly
+ * the caller's mask. Samples already cleared on entry, e.g. known-bad readings,
+ * are ignored. Ties between equally distant samples go to the lower index.
+ *
+ * @param[in]     ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples.
+ * @param[in,out] valid   Caller-owned array of GLBS_MASK_WORDS(num) words with a
+ *                        set bit for every candidate sample on entry and every
+ *                        kept sample on return.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false if fewer than MIN_SAMPLE_NUM
+ *              samples are valid on entry.
+ */
+bool glbs_ctx_process_masked(const glbs_ctx_t *ctx, const float *samples, size_t num, uint32_t *valid,
+                             float *result);
+
+/**
+ * @brief Removes outliers at several confidence levels with one sort and one trim.
+ *
+ * The candidate of every step is the current extreme whatever the level; a
+ * level only decides when to stop. A stricter level has larger critical values
+ * and stops no later, so the outliers of each level are a prefix of a single
+ * removal order. The trim runs until the loosest requested level stops and
+ * records the mean and prefix length of each level as it stops. Each result
+ * equals glbs_process() after glbs_init() with that level. The level of ctx is
+ * not used; ctx only supplies the working buffer, which for windows above
+ * MAX_SAMPLE_NUM must be its scratch buffer when order is requested.
+ *
+ * @param[in,out] ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in]     modes   The confidence levels, count entries in any order.
+ * @param[in]     count   The number of levels.
+ * @param[out]    means   Pointer to count floats receiving the average of the
+ *                        valid samples at each level.
+ * @param[out]    removed Pointer to count entries receiving the number of
+ *                        outliers at each level, or NULL.
+ * @param[out]    order   Caller-owned array of num entries receiving the input
+ *                        indices of the removed samples in removal order, or
+ *                        NULL. The outliers of level l are order[0..removed[l]).
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer is unavailable.
+ */
+bool glbs_ctx_process_levels(glbs_ctx_t *ctx, const float *samples, size_t num, const gpn_mode_t *modes,
+                             size_t count, float *means, size_t *removed, size_t *order);
+
+/**
+ * @brief Computes the critical values lambda_1..lambda_r of the generalized ESD test.
+ *
+ * lambda[i - 1] belongs to the i-th removal, made from m = num - i + 1 samples:
+ * lambda_i = (m - 1) t / sqrt((m - 2 + t^2) m), where t is the upper
+ * alpha / (2 m) quantile of Student's t with m - 2 degrees of freedom, i.e.
+ * glbs_gcrit(m, alpha / 2).
+ *
+ * @param[out] lambda       Caller-owned array of max_outliers floats.
+ * @param[in]  num          The number of samples per window.
+ * @param[in]  max_outliers The upper bound r on outliers, at most num - 2.
+ * @param[in]  alpha        The significance level, in the open interval (0, 1).
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_esd_lambda(float *lambda, size_t num, size_t max_outliers, double alpha);
+
+/**
+ * @brief Removes outliers with Rosner's generalized ESD test.
+ *
+ * Unlike the iterative Grubbs' test, which stops at the first non-significant
+ * point, the generalized ESD test computes R_1..R_r for up to r removals and
+ * takes the largest i with R_i > lambda_i as the number of outliers. This avoids
+ * masking when several outliers sit on the same side. All r statistics come
+ * from one sorted pass with O(1) downdates per removal.
+ *
+ * The engine of ctx applies as in glbs_ctx_process(). The critical values are
+ * two-sided, G_crit(m, alpha / 2), so the built-in one-sided table is never
+ * used: without lambda they come from a cache attached to ctx if it was built
+ * with glbs_gcrit_table_init() for ctx->alpha / 2, and from glbs_gcrit()
+ * otherwise. Precompute lambda for repeated windows of one size.
+ *
+ * @param[in,out] ctx          The context; its alpha is used when lambda is NULL.
+ * @param[in]     samples      Pointer to the input array of sample data.
+ * @param[in]     num          The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in]     max_outliers The upper bound r on outliers; values above num - 2
+ *                             are clamped.
+ * @param[in]     lambda       Critical values from glbs_esd_lambda() for the same
+ *                             num and r, or NULL to compute them on the fly.
+ * @param[out]    result       Pointer to a float receiving the average of the
+ *                             samples that are not outliers.
+ * @param[out]    outliers     Pointer receiving the number of outliers, or NULL.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid or
+ *              the working buffer cannot be allocated.
+ */
+bool glbs_ctx_process_esd(glbs_ctx_t *ctx, const float *samples, size_t num, size_t max_outliers,
+                          const float *lambda, float *result, size_t *outliers);
+
+/**
+ * @brief Node of the order-statistic tree kept by a stream. Internal layout.
+ */
+typedef struct glbs_stream_node_s {
+    float    value;    /**< The sample value. */
+    uint32_t priority; /**< Random heap priority of the treap. */
+    uint32_t left;     /**< Left child index, or UINT32_MAX. */
+    uint32_t right;    /**< Right child index, or UINT32_MAX. */
+    uint32_t size;     /**< Number of nodes in this subtree. */
+} glbs_stream_node_t;
+
+/**
+ * @brief Bytes of working memory a stream needs for a window of the given size.
+ */
+#define GLBS_STREAM_BUFFER_SIZE(window) ((size_t)(window) * sizeof(glbs_stream_node_t))
+
+/**
+ * @brief Sliding-window Grubbs' filter.
+ *
+ * The window is held in an order-statistic treap plus running sums, so that a
+ * push or an eviction costs O(log N) and the outlier test reads the extremes by
+ * rank instead of sorting. Each sample occupies the node slot of its arrival
+ * time modulo the window size, which doubles as the eviction ring. The sums
+ * carry their rounding error, so a far glitch leaves them exact once evicted;
+ * after far glitches of very different magnitudes they are taken again.
+ */
+typedef struct glbs_stream_s {
+    const glbs_ctx_t   *ctx;         /**< Context supplying the critical values. */
+    glbs_stream_node_t *nodes;       /**< Node pool of window entries. */
+    size_t              window;      /**< Window size N. */
+    size_t              count;       /**< Number of samples currently in the window. */
+    size_t              head;        /**< Slot that receives the next sample. */
+    size_t              rebase;      /**< Pushes left before the sums are recomputed. */
+    uint32_t            root;        /**< Root node index, or UINT32_MAX when empty. */
+    uint32_t            seed;        /**< State of the priority generator. */
+    double              ref;         /**< Reference value the sums are taken about. */
+    double              sum;         /**< Sum of (value - ref) over the window. */
+    double              sum_sq;      /**< Sum of (value - ref)^2 over the window. */
+    double              sum_err;     /**< Rounding error of sum not yet folded into it. */
+    double              sum_sq_err;  /**< Rounding error of sum_sq not yet folded into it. */
+    double              sum_sq_peak; /**< Largest sum_sq_err reached since the sums were taken. */
+} glbs_stream_t;
+
+/**
+ * @brief Initializes a sliding-window filter.
+ *
+ * For O(1) critical value lookups, attach a cache covering the window size to
+ * ctx with glbs_ctx_set_table().
+ *
+ * @param[out] stream The stream to initialize.
+ * @param[in]  ctx    The context supplying the critical values; must outlive the stream.
+ * @param[in]  buffer Caller-owned memory of GLBS_STREAM_BUFFER_SIZE(window) bytes,
+ *                    suitably aligned for glbs_stream_node_t.
+ * @param[in]  window The window size N, at least MIN_SAMPLE_NUM.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_stream_init(glbs_stream_t *stream, const glbs_ctx_t *ctx, void *buffer, size_t window);
+
+/**
+ * @brief Empties the window of a stream.
+ *
+ * @param[in,out] stream The stream.
+ */
+void glbs_stream_reset(glbs_stream_t *stream);
+
+/**
+ * @brief Pushes a sample into the window and returns the cleaned average.
+ *
+ * Once the window is full, the oldest sample is evicted. The outlier test runs
+ * from the extremes of the window, O(log N) per removed outlier.
+ *
+ * @param[in,out] stream The stream.
+ * @param[in]     sample The new sample.
+ * @param[out]    result Pointer to a float receiving the average of the valid
+ *                       samples of the window.
+ *
+ * @return bool Returns true if a result was produced, false while the window
+ *              holds fewer than MIN_SAMPLE_NUM samples.
+ */
+bool glbs_stream_push(glbs_stream_t *stream, float sample, float *result);
+
+/**
+ * @brief Largest window the integer engine accepts.
+ *
+ * Bounds the stack copy and keeps every intermediate within 64-bit integers.
+ */
+#define GLBS_FIX_MAX_NUM 64
+
+/**
+ * @brief Fractional bits of the mean returned by glbs_fix_process_i16() (Q16.16).
+ */
+#define GLBS_FIX_I16_FRAC 16
+
+/**
+ * @brief Fractional bits of the mean returned by glbs_fix_process_i32() (Q24.8).
+ */
+#define GLBS_FIX_I32_FRAC 8
+
+/**
+ * @brief Integer Grubbs' test engine for raw ADC codes.
+ *
+ * Holds the scaled critical values K(n) = G_p(n)^2 * n / (n - 1) in Q16, so
+ * that the test compares squared deviations with integer multiplies only:
+ * no floating point, no sqrt and no division per removal step.
+ */
+typedef struct glbs_fix_s {
+    const uint32_t *kn;    /**< K(n) for n = 0..max_n; entries below MIN_SAMPLE_NUM are zero. */
+    size_t          max_n; /**< Largest supported window size. */
+} glbs_fix_t;
+
+/**
+ * @brief Initializes an integer engine with a built-in confidence level.
+ *
+ * Uses constant tables derived from the float critical values, so neither this
+ * call nor the processing pulls in floating-point code. Windows are limited to
+ * MAX_SAMPLE_NUM samples.
+ *
+ * @param[out] fix  The engine.
+ * @param[in]  mode The desired confidence level from gpn_mode_t.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_fix_init(glbs_fix_t *fix, gpn_mode_t mode);
+
+/**
+ * @brief Initializes an integer engine from the critical values of a context.
+ *
+ * Converts glbs_ctx_gcrit() for n = 0..max_n once, e.g. at startup or on a host
+ * to produce a constant table, to cover other significance levels or windows
+ * above MAX_SAMPLE_NUM.
+ *
+ * @param[out] fix    The engine.
+ * @param[out] buffer Caller-owned array of GLBS_GCRIT_TABLE_LEN(max_n) words;
+ *                    must outlive the engine.
+ * @param[in]  ctx    The context supplying the critical values.
+ * @param[in]  max_n  The largest window size, MIN_SAMPLE_NUM..GLBS_FIX_MAX_NUM.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_fix_init_ctx(glbs_fix_t *fix, uint32_t *buffer, const glbs_ctx_t *ctx, size_t max_n);
+
+/**
+ * @brief Removes outliers from a window of 16-bit samples using integer arithmetic.
+ *
+ * @param[in]  fix     The engine.
+ * @param[in]  samples Pointer to the input array of samples.
+ * @param[in]  num     The number of samples, MIN_SAMPLE_NUM..fix->max_n.
+ * @param[out] result  Pointer receiving the average of the valid samples in
+ *                     Q16.16 sample units, rounded to nearest.
+ *
+ * @return bool Returns true on success, false if num is out of range.
+ */
+bool glbs_fix_process_i16(const glbs_fix_t *fix, const int16_t *samples, size_t num, int32_t *result);
+
+/**
+ * @brief Removes outliers from a window of 32-bit samples using integer arithmetic.
+ *
+ * @param[in]  fix     The engine.
+ * @param[in]  samples Pointer to the input array of samples, each within
+ *                     [-2^23, 2^23) as produced by ADCs of up to 24 bits.
+ * @param[in]  num     The number of samples, MIN_SAMPLE_NUM..fix->max_n.
+ * @param[out] result  Pointer receiving the average of the valid samples in
+ *                     Q24.8 sample units, rounded to nearest.
+ *
+ * @return bool Returns true on success, false if num or a sample is out of range.
+ */
+bool glbs_fix_process_i32(const glbs_fix_t *fix, const int32_t *samples, size_t num, int32_t *result);
+
+/**
+ * @brief Cache line size the ring indices are padded to.
+ */
+#define GLBS_RING_LINE 64
+
+/**
+ * @brief Bytes of storage a ring of capacity items of item bytes needs.
+ */
+#define GLBS_RING_BUFFER_SIZE(capacity, item) ((size_t)(capacity) * (size_t)(item))
+
+#if defined(__GNUC__)
+#define GLBS_RING_ALIGNED __attribute__((aligned(GLBS_RING_LINE)))
+#else
+#define GLBS_RING_ALIGNED
+#endif
+
+/**
+ * @brief Index of one side of a ring, alone on its cache line. Internal layout.
+ */
+typedef struct glbs_ring_side_s {
+    size_t index;                                      /**< Items this side has passed, free-running. */
+    size_t cache;                                      /**< Last index read from the other side. */
+    char   pad[GLBS_RING_LINE - 2 * sizeof(size_t)];   /**< Fills the rest of the line. */
+} GLBS_RING_ALIGNED glbs_ring_side_t;
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring of fixed-size items.
+ *
+ * Each side owns one cache line holding its free-running index and a cached
+ * copy of the other side's index. A side publishes its index with a release
+ * store and reads the other one with an acquire load only when the cached copy
+ * shows too little room or data, so the fast path takes no lock, no syscall
+ * and, while the ring is neither full nor empty, no cache line of the other
+ * side. One thread or interrupt handler may write while one other thread
+ * reads. Rings allocated on the heap should be aligned to GLBS_RING_LINE.
+ */
+typedef struct glbs_ring_s {
+    glbs_ring_side_t producer; /**< Written by the producer only. */
+    glbs_ring_side_t consumer; /**< Written by the consumer only. */
+    struct {
+        void  *buffer;         /**< Caller-owned storage of capacity items. */
+        size_t mask;           /**< Capacity minus one; the capacity is a power of two. */
+        size_t item;           /**< Size of an item in bytes. */
+    } shared;                  /**< Read-only after glbs_ring_init(). */
+} glbs_ring_t;
+
+/**
+ * @brief Result of one window published by a consumer.
+ */
+typedef struct glbs_ring_result_s {
+    uint64_t window; /**< Number of the window, counting from 0. */
+    float    mean;   /**< Average of the valid samples, as from glbs_ctx_process(). */
+} glbs_ring_result_t;
+
+/**
+ * @brief Consumer loop that cuts windows from a sample ring and publishes the means.
+ */
+typedef struct glbs_consumer_s {
+    const glbs_ctx_t *ctx;     /**< Context supplying the critical values. */
+    glbs_ring_t      *samples; /**< Ring of float samples, read by the consumer. */
+    glbs_ring_t      *results; /**< Ring of glbs_ring_result_t, written by the consumer. */
+    float            *window;  /**< Working copy of the window. */
+    size_t            num;     /**< Samples per window. */
+    size_t            step;    /**< Samples between window starts. */
+    size_t            skip;    /**< Samples still to drop before the next window. */
+    uint64_t          count;   /**< Windows processed. */
+} glbs_consumer_t;
+
+/**
+ * @brief Initializes an empty ring.
+ *
+ * @param[out] ring     The ring.
+ * @param[in]  buffer   Caller-owned memory of GLBS_RING_BUFFER_SIZE(capacity, item) bytes.
+ * @param[in]  capacity The number of items, a power of two.
+ * @param[in]  item     The size of an item in bytes.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_ring_init(glbs_ring_t *ring, void *buffer, size_t capacity, size_t item);
+
+/**
+ * @brief Appends items to a ring. Producer side only.
+ *
+ * Never blocks: when the ring fills up, only the items that fit are appended.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[in]     items The items.
+ * @param[in]     count The number of items.
+ *
+ * @return size_t The number of items appended.
+ */
+size_t glbs_ring_write(glbs_ring_t *ring, const void *items, size_t count);
+
+/**
+ * @brief Removes the oldest items of a ring. Consumer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[out]    items Receives the items.
+ * @param[in]     count The number of items wanted.
+ *
+ * @return size_t The number of items read, less than count if the ring held fewer.
+ */
+size_t glbs_ring_read(glbs_ring_t *ring, void *items, size_t count);
+
+/**
+ * @brief Copies the oldest items of a ring without removing them. Consumer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[out]    items Receives the items.
+ * @param[in]     count The number of items wanted.
+ *
+ * @return size_t The number of items copied, less than count if the ring held fewer.
+ */
+size_t glbs_ring_peek(glbs_ring_t *ring, void *items, size_t count);
+
+/**
+ * @brief Drops the oldest items of a ring without copying them. Consumer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[in]     count The number of items to remove.
+ *
+ * @return size_t The number of items removed, less than count if the ring held fewer.
+ */
+size_t glbs_ring_discard(glbs_ring_t *ring, size_t count);
+
+/**
+ * @brief Returns the number of items a ring holds. Consumer side only.
+ *
+ * @param[in,out] ring The ring.
+ *
+ * @return size_t The number of items that can be read.
+ */
+size_t glbs_ring_count(glbs_ring_t *ring);
+
+/**
+ * @brief Initializes a consumer that cuts windows from a sample ring.
+ *
+ * Windows of num samples start every step samples: consecutive with step ==
+ * num, overlapping below, with gaps above. The sample ring must hold at least
+ * num items.
+ *
+ * @param[out] consumer The consumer.
+ * @param[in]  ctx      The context supplying the critical values; must outlive the consumer.
+ * @param[in]  samples  Ring of float samples; the consumer is its consumer side.
+ * @param[in]  results  Ring of glbs_ring_result_t; the consumer is its producer side.
+ * @param[in]  window   Caller-owned array of num floats.
+ * @param[in]  num      The number of samples per window, at least MIN_SAMPLE_NUM.
+ * @param[in]  step     The number of samples between window starts, at least 1.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_consumer_init(glbs_consumer_t *consumer, const glbs_ctx_t *ctx, glbs_ring_t *samples,
+                        glbs_ring_t *results, float *window, size_t num, size_t step);
+
+/**
+ * @brief Processes every window the sample ring holds, as far as results fit.
+ *
+ * Each window is copied out of the ring and processed with
+ * glbs_ctx_process_inplace(), so no scratch buffer or heap is needed for any
+ * window size. Never blocks: it returns when the samples run out or the result
+ * ring is full, leaving the samples queued.
+ *
+ * @param[in,out] consumer The consumer.
+ *
+ * @return size_t The number of windows processed.
+ */
+size_t glbs_consumer_poll(glbs_consumer_t *consumer);
+
+/**
+ * @brief Runs a consumer until stop is set, spinning while there is no work.
+ *
+ * Meant as the body of a dedicated consumer thread. Idle iterations issue a
+ * CPU pause hint instead of sleeping, so the loop makes no syscalls.
+ *
+ * @param[in,out] consumer The consumer.
+ * @param[in]     stop     Flag set by another thread to end the loop.
+ */
+void glbs_consumer_run(glbs_consumer_t *consumer, const bool *stop);
+
+#ifdef GLBS_THREADS
+/**
+ * @brief Thread pool for large batches of independent windows, available when
+ *        built with GLBS_THREADS. Opaque.
+ */
+typedef struct glbs_pool_s glbs_pool_t;
+
+/**
+ * @brief Work item callback of glbs_pool_run().
+ *
+ * @param[in,out] ctx   The context of the calling worker, a copy of the one
+ *                      passed to glbs_pool_run() with the worker's own scratch
+ *                      buffer. Never shared with another thread.
+ * @param[in]     arg   The argument passed to glbs_pool_run().
+ * @param[in]     begin The first item of the chunk.
+ * @param[in]     end   One past the last item of the chunk.
+ */
+typedef void (*glbs_pool_fn_t)(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end);
+
+/**
+ * @brief Descriptor of one window for glbs_pool_process_windows().
+ */
+typedef struct glbs_window_s {
+    const float *samples; /**< Pointer to the samples of the window. */
+    size_t       num;     /**< The number of samples. */
+} glbs_window_t;
+
+/**
+ * @brief Creates a thread pool.
+ *
+ * The calling thread of glbs_pool_run() is worker 0, so threads - 1 threads
+ * are started. They sleep between runs.
+ *
+ * @param[in] threads      The number of workers, or 0 for one per online processor.
+ * @param[in] scratch_size Bytes of scratch buffer allocated for each worker
+ *                         context, e.g. GLBS_SCRATCH_SIZE(num) for windows of
+ *                         num samples, or 0 for none.
+ *
+ * @return glbs_pool_t* The pool, or NULL if it could not be created.
+ */
+glbs_pool_t *glbs_pool_create(size_t threads, size_t scratch_size);
+
+/**
+ * @brief Stops the workers of a pool and releases it.
+ *
+ * @param[in] pool The pool, or NULL.
+ */
+void glbs_pool_destroy(glbs_pool_t *pool);
+
+/**
+ * @brief Returns the number of workers of a pool, the calling thread included.
+ *
+ * @param[in] pool The pool.
+ *
+ * @return size_t The number of workers.
+ */
+size_t glbs_pool_threads(const glbs_pool_t *pool);
+
+/**
+ * @brief Calls fn on chunks of the items [0, count) from every worker of the pool.
+ *
+ * The chunks are dealt out to the workers in contiguous equal shares. A worker
+ * takes chunks from the front of its share; once it is empty, it steals the
+ * back half of another worker's share. Both are a compare-and-swap on a packed
+ * range, so scheduling takes no locks; the pool only locks to start and join
+ * the run. Returns when every chunk has been processed.
+ *
+ * Runs on one pool must not overlap; use one pool per calling thread.
+ *
+ * @param[in,out] pool  The pool.
+ * @param[in]     ctx   The context copied into each worker context.
+ * @param[in]     count The number of items.
+ * @param[in]     chunk The number of items per call of fn, or 0 to pick one.
+ * @param[in]     fn    The callback.
+ * @param[in]     arg   The argument passed to fn.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_pool_run(glbs_pool_t *pool, const glbs_ctx_t *ctx, size_t count, size_t chunk, glbs_pool_fn_t fn,
+                   void *arg);
+
+/**
+ * @brief Processes many windows of equal size stored back to back.
+ *
+ * Window w is samples[w * num .. (w + 1) * num), and its result is what
+ * glbs_ctx_process() returns for it with ctx. Each result is written by one
+ * worker, so the output needs no locking.
+ *
+ * @param[in,out] pool    The pool.
+ * @param[in]     ctx     The context copied into each worker context.
+ * @param[in]     samples Pointer to count * num samples.
+ * @param[in]     num     The number of samples per window, at least MIN_SAMPLE_NUM.
+ * @param[in]     count   The number of windows.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false if any window failed; the
+ *              results of failed windows are NaN.
+ */
+bool glbs_pool_process(glbs_pool_t *pool, const glbs_ctx_t *ctx, const float *samples, size_t num, size_t count,
+                       float *results);
+
+/**
+ * @brief Processes many windows given by descriptors, e.g. of varying size.
+ *
+ * @param[in,out] pool    The pool.
+ * @param[in]     ctx     The context copied into each worker context.
+ * @param[in]     windows Pointer to count window descriptors.
+ * @param[in]     count   The number of windows.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false if any window failed; the
+ *              results of failed windows are NaN.
+ */
+bool glbs_pool_process_windows(glbs_pool_t *pool, const glbs_ctx_t *ctx, const glbs_window_t *windows, size_t count,
+                               float *results);
+
+/**
+ * @brief Removes outliers from one large window with every worker of the pool.
+ *
+ * The window is split into a few parts per worker. In parallel, each part is
+ * copied and has its k smallest and k largest samples moved into order, where
+ * k is ctx->max_outliers or 256 if that is 0, but at most a 32nd of a part.
+ * Each part is then summed about the median of the part medians, carrying the
+ * rounding error if it holds a far glitch. The part sums are merged pairwise
+ * and the ordered ends merged into the global extremes, so the removal loop
+ * only touches those.
+ * Should it run past them, the ends are ordered again with 4k, falling back to
+ * glbs_ctx_process() once k reaches an eighth of a part, or once dropping
+ * glitches of very different magnitudes leaves the sums with little more than
+ * rounding error. The result equals glbs_ctx_process() up to the rounding of
+ * the sums.
+ *
+ * The working copy uses the scratch buffer of ctx if it holds num floats and
+ * the heap otherwise. Windows below 65536 samples are processed by the calling
+ * thread alone.
+ *
+ * @param[in,out] pool    The pool.
+ * @param[in]     ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false if num is invalid or the working
+ *              memory cannot be allocated.
+ */
+bool glbs_pool_process_large(glbs_pool_t *pool, const glbs_ctx_t *ctx, const float *samples, size_t num,
+                             float *result);
+#endif /* GLBS_THREADS */
+
+#ifdef GLBS_INSTRUMENT
+/**
+ * @brief Number of latency histogram buckets.
+ */
+#define GLBS_LATENCY_BUCKETS 32
+
+/**
+ * @brief Instrumentation counters, available when built with GLBS_INSTRUMENT.
+ *
+ * Each thread updates its own copy without atomic read-modify-writes or locks;
+ * glbs_counters_read() sums them on demand. Counts of exited threads are kept.
+ * Every call adds one to calls and one to a latency bucket, whichever way it
+ * returns, so the histogram adds up to calls. When glbs_pool_process_large()
+ * restarts its trim with more ordered ends, the repeated tests count again.
+ */
+typedef struct glbs_counters_s {
+    uint64_t calls;      /**< Calls of the glbs_ctx_process*() entry points and glbs_pool_process_large(). */
+    uint64_t rejected;   /**< Calls that failed: parameters out of range or no working buffer. */
+    uint64_t samples;    /**< Samples processed. */
+    uint64_t outliers;   /**< Samples removed as outliers. */
+    uint64_t iterations; /**< Grubbs' tests evaluated. */
+    uint64_t exhausted;  /**< Trims stopped at MIN_SAMPLE_NUM - 1 kept samples, where no test is possible. */
+    uint64_t latency[GLBS_LATENCY_BUCKETS]; /**< Calls by duration: bucket b counts [2^b, 2^(b+1)) clock
+                                                 ticks, nanoseconds unless GLBS_INSTRUMENT_NOW() is
+                                                 redefined; bucket 0 also counts 0. */
+} glbs_counters_t;
+
+/**
+ * @brief Sums the counters of every thread.
+ *
+ * The result is a consistent total of each counter up to the updates that are
+ * in flight while it runs. Take differences of two reads to measure an interval.
+ *
+ * @param[out] counters Pointer receiving the totals.
+ */
+void glbs_counters_read(glbs_counters_t *counters);
+#endif /* GLBS_INSTRUMENT */
+
 /**
  * @brief Initializes the Grubbs' test module with a specific confidence level.
  *
- * This function must be called before using glbs_process().
+ * This function configures the default context used by glbs_process(). The
+ * default context is shared process-wide; use glbs_ctx_init() and
+ * glbs_ctx_process() for independent settings or concurrent callers.
  *
  * @param[in] mode The desired confidence level from gpn_mode_t.
  */
 void glbs_init(gpn_mode_t mode);
 
+/**
+ * @brief Initializes the Grubbs' test module with an arbitrary significance level.
+ *
+ * Critical values are computed from the Student-t quantile for every sample count
+ * instead of being taken from the built-in table.
+ *
+ * @param[in] alpha The significance level, in the open interval (0, 1).
+ */
+void glbs_init_alpha(double alpha);
+
+/**
+ * @brief Attaches a precomputed critical value cache to the module.
+ *
+ * While attached, glbs_process() takes critical values for n <= table->max_n from
+ * the cache. The cache must outlive its use; pass NULL to detach it.
+ *
+ * @param[in] table The cache built by glbs_gcrit_table_init(), or NULL.
+ */
+void glbs_init_table(const glbs_gcrit_table_t *table);
+
+/**
+ * @brief Returns the significance level alpha of a confidence mode.
+ *
+ * @param[in] mode The confidence level from gpn_mode_t.
+ *
+ * @return double The significance level (e.g. 0.05 for GPN_95).
+ */
+double glbs_mode_alpha(gpn_mode_t mode);
+
+/**
+ * @brief Computes the upper-tail quantile of Student's t distribution.
+ *
+ * Returns t such that P(T > t) = p for T with df degrees of freedom. The result
+ * starts from Hill's approximation (ACM Algorithm 396) and is refined with Newton
+ * steps on the exact distribution function.
+ *
+ * @param[in] p  The upper-tail probability, in the open interval (0, 0.5].
+ * @param[in] df The degrees of freedom, at least 1.
+ *
+ * @return double The quantile, or 0 if the parameters are invalid.
+ */
+double glbs_t_quantile(double p, double df);
+
+/**
+ * @brief Computes the one-sided Grubbs' critical value G_crit(n, alpha).
+ *
+ * G_crit = (n - 1) / sqrt(n) * sqrt(t^2 / (n - 2 + t^2)), where t is the upper
+ * alpha / n quantile of Student's t distribution with n - 2 degrees of freedom.
+ * This is the same convention as the built-in table.
+ *
+ * @param[in] n     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in] alpha The significance level, in the open interval (0, 1).
+ *
+ * @return double The critical value, or 0 if the parameters are invalid.
+ */
+double glbs_gcrit(size_t n, double alpha);
+
+/**
+ * @brief Computes G_crit(n, alpha) with Hill's approximation only.
+ *
+ * Skips the Newton refinement of glbs_gcrit(). Measured over alpha in (0, 1),
+ * the relative error is at most 6.2e-6 for n <= 5, 3.1e-6 for n <= 20 and
+ * 1e-8 above, so results can differ from glbs_gcrit() in the last few float
+ * digits.
+ *
+ * @param[in] n     The number of samples, at least MIN_SAMPLE_NUM.
+ * @param[in] alpha The significance level, in the open interval (0, 1).
+ *
+ * @return double The critical value, or 0 if the parameters are invalid.
+ */
+double glbs_gcrit_fast(size_t n, double alpha);
+
+/**
+ * @brief Fills a critical value cache for n = 0..max_n.
+ *
+ * @param[out] table  The cache descriptor to initialize.
+ * @param[in]  buffer Caller-owned storage of GLBS_GCRIT_TABLE_LEN(max_n) floats.
+ * @param[in]  max_n  The largest sample count to precompute.
+ * @param[in]  alpha  The significance level, in the open interval (0, 1).
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_gcrit_table_init(glbs_gcrit_table_t *table, float *buffer, size_t max_n, double alpha);
+
+/**
+ * @brief Looks up G_crit(n) in a cache, computing it when n exceeds the cache.
+ *
+ * @param[in] table The cache built by glbs_gcrit_table_init().
+ * @param[in] n     The number of samples, at least MIN_SAMPLE_NUM.
+ *
+ * @return float The critical value.
+ */
+float glbs_gcrit_table_get(const glbs_gcrit_table_t *table, size_t n);
+
 /**
  * @brief Processes a set of samples to remove outliers using Grubbs' test.
  *
@@ -55,14 +1210,34 @@ void glbs_init(gpn_mode_t mode);
  * the average of the remaining valid data points.
  *
  * @param[in]  samples Pointer to the input array of sample data.
- * @param[in]  num     The number of samples in the input array. Must be between
- *                     MIN_SAMPLE_NUM and MAX_SAMPLE_NUM.
+ * @param[in]  num     The number of samples in the input array. Must be at least
+ *                     MIN_SAMPLE_NUM. Counts above MAX_SAMPLE_NUM use computed
+ *                     critical values and a heap-allocated working buffer.
  * @param[out] result  Pointer to a float where the calculated average of the valid
  *                     samples will be stored.
  *
  * @return bool Returns true on successful processing, false if the input parameters
- *              are invalid (e.g., sample count is out of range).
+ *              are invalid (e.g., sample count is out of range) or the working
+ *              buffer cannot be allocated.
+ */
+bool glbs_process(const float *samples, size_t num, float *result);
+
+/**
+ * @brief Processes many windows of equal size with the default context.
+ *
+ * See glbs_ctx_process_batch() for the data layout.
+ *
+ * @param[in]  samples Pointer to num * count samples in SoA layout.
+ * @param[in]  num     The number of samples per window, at least MIN_SAMPLE_NUM.
+ * @param[in]  count   The number of windows.
+ * @param[out] results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false on failure.
  */
-bool glbs_process(const float *samples, uint8_t num, float *result);
+bool glbs_process_batch(const float *samples, size_t num, size_t count, float *results);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* __GLBS_H__ */
\ No newline at end of file
@@ -0,0 +1,538 @@
+/**
+ * @file glbs.hpp
+ * @author wdfk-prog
+ * @brief Header-only C++17 Grubbs' test with compile-time critical values.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * grubbs::detector<T, N, Alpha> removes outliers from windows of up to N
+ * samples of type T at the significance level Alpha, a std::ratio. Its critical
+ * values are computed by constexpr functions while compiling, so the test loop
+ * reads a constant table, and windows whose size is part of their type
+ * (std::array, fixed-extent std::span) are sorted by an unrolled network and
+ * summed with a constant trip count. The C API in glbs.h stays the stable ABI;
+ * this header only shares its constants and sorting networks.
+ */
+#ifndef __GLBS_HPP__
+#define __GLBS_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <ratio>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define GLBS_HPP_HAS_SPAN 1
+#endif
+#include "glbs.h"
+#include "glbs_network.h"
+
+namespace grubbs
+{
+
+/**
+ * @brief Significance levels of the built-in confidence levels of gpn_mode_t.
+ */
+using alpha_01 = std::ratio<1, 100>;
+using alpha_05 = std::ratio<5, 100>;
+using alpha_10 = std::ratio<10, 100>;
+using alpha_20 = std::ratio<20, 100>;
+
+namespace detail
+{
+
+constexpr double pi = 3.14159265358979323846;
+
+/**
+ * @brief Square root by Newton's method, usable in constant expressions.
+ */
+constexpr double sqrt(double x)
+{
+    double root = (x > 1.0) ? x : 1.0;
+    double next = 0.0;
+
+    if (!(x > 0.0)) {
+        return 0.0;
+    }
+
+    // Starting above the root, the iterates decrease until rounding stops them.
+    for (int i = 0; i < 128; i++) {
+        next = 0.5 * (root + x / root);
+        if (!(next < root)) {
+            break;
+        }
+        root = next;
+    }
+    return root;
+}
+
+/**
+ * @brief Returns x^(e / 2) for an integer e, by squaring.
+ */
+constexpr double half_power(double x, std::size_t e)
+{
+    double power = (e % 2 == 0) ? 1.0 : detail::sqrt(x);
+    double base  = x;
+
+    for (e /= 2; e > 0; e >>= 1) {
+        if (e & 1) {
+            power *= base;
+        }
+        base *= base;
+    }
+    return power;
+}
+
+/**
+ * @brief Continued fraction for the regularized incomplete beta function (Lentz),
+ *        as glbs_beta_cf() in glbs.c.
+ */
+constexpr double beta_cf(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double       c    = 1.0;
+    double       d    = 1.0 - (a + b) * x / (a + 1.0);
+    double       h    = 0.0;
+    double       aa   = 0.0;
+    double       del  = 0.0;
+
+    d = 1.0 / ((d < tiny && d > -tiny) ? tiny : d);
+    h = d;
+
+    for (int m = 1; m <= 400; m++) {
+        // Even step.
+        aa = m * (b - m) * x / ((a + 2 * m - 1.0) * (a + 2 * m));
+        d  = 1.0 + aa * d;
+        c  = 1.0 + aa / c;
+        d  = 1.0 / ((d < tiny && d > -tiny) ? tiny : d);
+        c  = (c < tiny && c > -tiny) ? tiny : c;
+        h *= d * c;
+
+        // Odd step.
+        aa  = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1.0));
+        d   = 1.0 + aa * d;
+        c   = 1.0 + aa / c;
+        d   = 1.0 / ((d < tiny && d > -tiny) ? tiny : d);
+        c   = (c < tiny && c > -tiny) ? tiny : c;
+        del = d * c;
+        h *= del;
+
+        if (del - 1.0 < 1e-13 && del - 1.0 > -1e-13) {
+            break;
+        }
+    }
+    return h;
+}
+
+/**
+ * @brief Upper-tail probability P(T > t) of Student's t distribution.
+ *
+ * Written in s = t / sqrt(df + t^2), with which P(T > t) = I_x(df / 2, 1 / 2) / 2
+ * for x = 1 - s^2, and 1 / B(df / 2, 1 / 2) = scale / 2 (see gcrit()), so the
+ * only transcendental left is a square root.
+ */
+constexpr double t_upper(double s, std::size_t df, double scale)
+{
+    const double a     = 0.5 * df;
+    const double b     = 0.5;
+    const double x     = 1.0 - s * s;
+    const double front = 0.5 * scale * half_power(x, df) * s;
+
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return 0.5 * front * beta_cf(a, b, x) / a;
+    }
+    return 0.5 * (1.0 - front * beta_cf(b, a, s * s) / b);
+}
+
+/**
+ * @brief Returns 2 * Gamma((df + 1) / 2) / (sqrt(pi) * Gamma(df / 2)) = 2 / B(df / 2, 1 / 2).
+ *
+ * From 2 / pi for df = 1 and 1 for df = 2 by scale(df + 2) = scale(df) * (df + 1) / df.
+ */
+constexpr double t_scale(std::size_t df)
+{
+    double scale = (df % 2 == 0) ? 1.0 : 2.0 / pi;
+
+    for (std::size_t k = (df % 2 == 0) ? 2 : 1; k < df; k += 2) {
+        scale *= (k + 1.0) / k;
+    }
+    return scale;
+}
+
+/**
+ * @brief Solves P(T > t) = alpha / n for s = t / sqrt(n - 2 + t^2).
+ *
+ * Newton steps on the slope -scale / 2 * (1 - s^2)^((df - 2) / 2), falling back
+ * to bisection whenever a step leaves the bracket.
+ *
+ * @param n     The number of samples.
+ * @param alpha The significance level.
+ * @param scale t_scale(n - 2).
+ * @param guess The starting point in (0, 1).
+ */
+constexpr double gcrit_sine(std::size_t n, double alpha, double scale, double guess)
+{
+    const std::size_t df     = n - 2;
+    const double      target = alpha / n;
+    double            lo     = 0.0;
+    double            hi     = 1.0;
+    double            s      = guess;
+    double            next   = 0.0;
+    double            f      = 0.0;
+    double            slope  = 0.0;
+
+    for (int i = 0; i < 200; i++) {
+        f = t_upper(s, df, scale) - target;
+        if (f > 0.0) {
+            lo = s;
+        } else {
+            hi = s;
+        }
+        slope = (df == 1) ? 0.5 * scale / detail::sqrt(1.0 - s * s) : 0.5 * scale * half_power(1.0 - s * s, df - 2);
+        next  = s + f / slope;
+        if (!(next > lo && next < hi)) {
+            next = 0.5 * (lo + hi);
+        }
+        if (next == s || hi - lo < 1e-16) {
+            break;
+        }
+        s = next;
+    }
+    return s;
+}
+
+/**
+ * @brief One-sided Grubbs' critical value G_crit(n, alpha), as glbs_gcrit().
+ *
+ * G = (n - 1) / sqrt(n) * sqrt(t^2 / (n - 2 + t^2)) for the upper alpha / n
+ * quantile t with n - 2 degrees of freedom, and the square root is exactly the
+ * s of t_upper(), so solving for s yields G without ever forming t.
+ */
+constexpr double gcrit(std::size_t n, double alpha)
+{
+    return (n - 1) / detail::sqrt((double)n) * gcrit_sine(n, alpha, t_scale(n - 2), 0.5);
+}
+
+/**
+ * @brief Critical values G_crit(n, alpha) for n = 0..N, zero below MIN_SAMPLE_NUM.
+ *
+ * Each n starts from the solution for n - 1 and updates the scale of its
+ * parity, so building the table costs O(N) solver steps rather than O(N^2).
+ */
+template <std::size_t N>
+constexpr std::array<double, N + 1> gcrit_table(double alpha)
+{
+    std::array<double, N + 1> table{};
+    double                    scales[2] = {t_scale(2), t_scale(1)};
+    double                    s         = 0.5;
+
+    for (std::size_t n = MIN_SAMPLE_NUM; n <= N; n++) {
+        const std::size_t df = n - 2;
+
+        if (df > 2) {
+            scales[df % 2] *= (df - 1.0) / (df - 2.0);
+        }
+        s        = gcrit_sine(n, alpha, scales[df % 2], s);
+        table[n] = (n - 1) / detail::sqrt((double)n) * s;
+    }
+    return table;
+}
+
+/**
+ * @brief Scaled squared critical values K(n) = G_crit(n)^2 * n / (n - 1).
+ */
+template <std::size_t N>
+constexpr std::array<double, N + 1> kn_table(const std::array<double, N + 1> &gcrit)
+{
+    std::array<double, N + 1> table{};
+
+    for (std::size_t n = MIN_SAMPLE_NUM; n <= N; n++) {
+        table[n] = gcrit[n] * gcrit[n] * n / (n - 1);
+    }
+    return table;
+}
+
+/**
+ * @brief Compare-exchanges two elements so that a <= b, without branches.
+ */
+template <typename T>
+constexpr void cmpx(T &a, T &b) noexcept
+{
+    T lo = (b < a) ? b : a;
+    T hi = (b < a) ? a : b;
+
+    a = lo;
+    b = hi;
+}
+
+#define GLBS_HPP_CMPX(i, j) cmpx(data[i], data[j]);
+
+/**
+ * @brief Sorts M elements with the sorting network of that size from glbs_network.h.
+ */
+template <std::size_t M, typename T>
+void sort_network(T *data) noexcept
+{
+    static_assert(M <= MAX_SAMPLE_NUM, "glbs_network.h provides networks up to MAX_SAMPLE_NUM");
+
+    if constexpr (M == 2) {
+        GLBS_NETWORK_2(GLBS_HPP_CMPX)
+    } else if constexpr (M == 3) {
+        GLBS_NETWORK_3(GLBS_HPP_CMPX)
+    } else if constexpr (M == 4) {
+        GLBS_NETWORK_4(GLBS_HPP_CMPX)
+    } else if constexpr (M == 5) {
+        GLBS_NETWORK_5(GLBS_HPP_CMPX)
+    } else if constexpr (M == 6) {
+        GLBS_NETWORK_6(GLBS_HPP_CMPX)
+    } else if constexpr (M == 7) {
+        GLBS_NETWORK_7(GLBS_HPP_CMPX)
+    } else if constexpr (M == 8) {
+        GLBS_NETWORK_8(GLBS_HPP_CMPX)
+    } else if constexpr (M == 9) {
+        GLBS_NETWORK_9(GLBS_HPP_CMPX)
+    } else if constexpr (M == 10) {
+        GLBS_NETWORK_10(GLBS_HPP_CMPX)
+    } else if constexpr (M == 11) {
+        GLBS_NETWORK_11(GLBS_HPP_CMPX)
+    } else if constexpr (M == 12) {
+        GLBS_NETWORK_12(GLBS_HPP_CMPX)
+    } else if constexpr (M == 13) {
+        GLBS_NETWORK_13(GLBS_HPP_CMPX)
+    } else if constexpr (M == 14) {
+        GLBS_NETWORK_14(GLBS_HPP_CMPX)
+    } else if constexpr (M == 15) {
+        GLBS_NETWORK_15(GLBS_HPP_CMPX)
+    } else if constexpr (M == 16) {
+        GLBS_NETWORK_16(GLBS_HPP_CMPX)
+    } else if constexpr (M == 17) {
+        GLBS_NETWORK_17(GLBS_HPP_CMPX)
+    } else if constexpr (M == 18) {
+        GLBS_NETWORK_18(GLBS_HPP_CMPX)
+    } else if constexpr (M == 19) {
+        GLBS_NETWORK_19(GLBS_HPP_CMPX)
+    } else if constexpr (M == 20) {
+        GLBS_NETWORK_20(GLBS_HPP_CMPX)
+    } else {
+        (void)data;
+    }
+}
+
+#undef GLBS_HPP_CMPX
+
+/**
+ * @brief Sorts a window of runtime size through a jump table of networks.
+ */
+template <typename T, std::size_t... M>
+void sort_small(T *data, std::size_t num, std::index_sequence<M...>) noexcept
+{
+    static constexpr void (*networks[])(T *) noexcept = {&sort_network<M, T>...};
+
+    networks[num](data);
+}
+
+/**
+ * @brief Sorts a window of runtime size in ascending order.
+ */
+template <typename T>
+void sort(T *data, std::size_t num) noexcept
+{
+    if (num <= MAX_SAMPLE_NUM) {
+        sort_small(data, num, std::make_index_sequence<MAX_SAMPLE_NUM + 1>{});
+    } else {
+        std::sort(data, data + num);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Grubbs' outlier filter for windows of up to N samples.
+ *
+ * The filter sorts a copy of the window in its own std::array, removes the
+ * more extreme end while it fails the test, and returns the mean of the rest,
+ * like glbs_ctx_process() with glbs_ctx_set_alpha(ctx, Alpha) and
+ * GLBS_ENGINE_SQUARED. Sums are kept in double; integer sample types, e.g. raw
+ * fixed-point ADC codes, are converted exactly and averaged to a double.
+ *
+ * A detector is not thread-safe, since calls share the scratch array; use one
+ * per thread.
+ *
+ * The critical value table is built while compiling, at a cost of O(N) solver
+ * steps; with the default constexpr limits of GCC that allows N up to about
+ * 1000, beyond which -fconstexpr-ops-limit must be raised.
+ *
+ * @tparam T     The sample type, any arithmetic type.
+ * @tparam N     The largest window size, at least MIN_SAMPLE_NUM.
+ * @tparam Alpha The significance level as a std::ratio, e.g. grubbs::alpha_05.
+ */
+template <typename T, std::size_t N, typename Alpha = alpha_05>
+class detector
+{
+    static_assert(std::is_arithmetic_v<T>, "samples must be of an arithmetic type");
+    static_assert(N >= MIN_SAMPLE_NUM, "the window must hold at least MIN_SAMPLE_NUM samples");
+    static_assert(Alpha::num > 0 && Alpha::num < Alpha::den, "alpha must lie in (0, 1)");
+
+  public:
+    using value_type  = T;
+    using result_type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+    static constexpr std::size_t capacity = N;
+    static constexpr double      alpha    = (double)Alpha::num / (double)Alpha::den;
+
+    /**
+     * @brief Critical values G_crit(n, alpha) for n = 0..N, computed at compile time.
+     */
+    static constexpr std::array<double, N + 1> critical_values = detail::gcrit_table<N>(alpha);
+
+    /**
+     * @brief Returns the critical value for n samples, or 0 below MIN_SAMPLE_NUM.
+     */
+    static constexpr double critical_value(std::size_t n) noexcept
+    {
+        return (n <= N) ? critical_values[n] : 0.0;
+    }
+
+    /**
+     * @brief Processes a window whose size is known only at run time.
+     *
+     * @param[in]  samples Pointer to the input array of samples.
+     * @param[in]  num     The number of samples, MIN_SAMPLE_NUM..N.
+     * @param[out] result  The average of the valid samples.
+     *
+     * @return bool Returns true on success, false on failure.
+     */
+    bool process(const T *samples, std::size_t num, result_type &result) noexcept
+    {
+        if (samples == nullptr || num < MIN_SAMPLE_NUM || num > N) {
+            return false;
+        }
+        std::copy(samples, samples + num, m_scratch.begin());
+        result = run<0>(num);
+        return true;
+    }
+
+    /**
+     * @brief Processes a window whose size is part of its type.
+     *
+     * @param[in]  samples The input samples.
+     * @param[out] result  The average of the valid samples.
+     *
+     * @return bool Returns true.
+     */
+    template <std::size_t M>
+    bool process(const std::array<T, M> &samples, result_type &result) noexcept
+    {
+        static_assert(M >= MIN_SAMPLE_NUM && M <= N, "the window size must lie in MIN_SAMPLE_NUM..N");
+
+        std::copy(samples.begin(), samples.end(), m_scratch.begin());
+        result = run<M>(M);
+        return true;
+    }
+
+#ifdef GLBS_HPP_HAS_SPAN
+    /**
+     * @brief Processes a window given as a std::span.
+     *
+     * Spans of static extent take the same unrolled path as std::array.
+     *
+     * @param[in]  samples The input samples.
+     * @param[out] result  The average of the valid samples.
+     *
+     * @return bool Returns true on success, false on failure.
+     */
+    template <std::size_t Extent>
+    bool process(std::span<const T, Extent> samples, result_type &result) noexcept
+    {
+        if constexpr (Extent == std::dynamic_extent) {
+            return process(samples.data(), samples.size(), result);
+        } else {
+            static_assert(Extent >= MIN_SAMPLE_NUM && Extent <= N, "the window size must lie in MIN_SAMPLE_NUM..N");
+
+            std::copy(samples.begin(), samples.end(), m_scratch.begin());
+            result = run<Extent>(Extent);
+            return true;
+        }
+    }
+#endif
+
+  private:
+    /**
+     * @brief Scaled squared critical values, so that a step tests A^2 > K(n) * B.
+     */
+    static constexpr std::array<double, N + 1> s_kn = detail::kn_table<N>(critical_values);
+
+    /**
+     * @brief Removes the outliers of the window in the scratch array.
+     *
+     * With A = n * (value - ref) - sum and B = n * sum_sq - sum^2 over the kept
+     * range, an end is an outlier if A^2 * (n - 1) > G^2 * n * B, as for
+     * GLBS_ENGINE_SQUARED.
+     *
+     * @tparam M The window size if known at compile time, 0 otherwise.
+     *
+     * @param[in] num The window size.
+     *
+     * @return result_type The average of the valid samples.
+     */
+    template <std::size_t M>
+    result_type run(std::size_t num) noexcept
+    {
+        const std::size_t count  = (M != 0) ? M : num;
+        T                *data   = m_scratch.data();
+        double            ref    = 0.0;
+        double            sum    = 0.0;
+        double            sum_sq = 0.0;
+        double            delta  = 0.0;
+        std::size_t       lo     = 0;
+        std::size_t       hi     = count - 1;
+
+        if constexpr (M != 0 && M <= MAX_SAMPLE_NUM) {
+            detail::sort_network<M>(data);
+        } else {
+            detail::sort(data, count);
+        }
+
+        // Sums about the median limit cancellation in B.
+        ref = (double)data[count / 2];
+        for (std::size_t i = 0; i < count; i++) {
+            delta = (double)data[i] - ref;
+            sum += delta;
+            sum_sq += delta * delta;
+        }
+
+        while (hi - lo + 1 >= MIN_SAMPLE_NUM) {
+            const double n    = (double)(hi - lo + 1);
+            const double lo_a = sum - n * ((double)data[lo] - ref);
+            const double hi_a = n * ((double)data[hi] - ref) - sum;
+            const double b    = n * sum_sq - sum * sum;
+            const bool   high = hi_a > lo_a;
+            const double a    = high ? hi_a : lo_a;
+
+            if (!(b > 0.0 && a * a > s_kn[hi - lo + 1] * b)) {
+                break;
+            }
+
+            delta = (double)(high ? data[hi] : data[lo]) - ref;
+            sum -= delta;
+            sum_sq -= delta * delta;
+            if (high) {
+                hi--;
+            } else {
+                lo++;
+            }
+        }
+
+        return (result_type)(ref + sum / (double)(hi - lo + 1));
+    }
+
+    std::array<T, N> m_scratch{};
+};
+
+} // namespace grubbs
+
+#endif /* __GLBS_HPP__ */
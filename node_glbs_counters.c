@@ -0,0 +1,138 @@
+/**
+ * @file glbs_counters.c
+ * @author wdfk-prog
+ * @brief Per-thread instrumentation counters, built with GLBS_INSTRUMENT.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "glbs.h"
+#include "glbs_internal.h"
+
+#ifdef GLBS_INSTRUMENT
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define GLBS_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define GLBS_THREAD_LOCAL __thread
+#else
+#define GLBS_THREAD_LOCAL
+#endif
+
+/**
+ * @brief Head of the list of registered blocks.
+ */
+static glbs_counter_block_t *s_blocks = NULL;
+
+/**
+ * @brief Block of the calling thread, NULL until its first event.
+ */
+static GLBS_THREAD_LOCAL glbs_counter_block_t *s_local = NULL;
+
+/**
+ * @brief Shared block for threads whose own block could not be allocated.
+ *
+ * Only used after an allocation failure; its updates may race and lose counts,
+ * but never corrupt anything.
+ */
+static glbs_counter_block_t s_fallback;
+
+/**
+ * @brief Returns the counters of the calling thread, registering them on first use.
+ *
+ * Blocks are pushed onto the list with a compare-and-swap and never freed, so a
+ * reader can walk the list at any time and the counts of exited threads remain.
+ *
+ * @return glbs_counters_t* The counters of the calling thread.
+ */
+glbs_counters_t *glbs_counters_local(void)
+{
+    glbs_counter_block_t *block = s_local;
+
+    if (block != NULL) {
+        return &block->counters;
+    }
+
+    block = calloc(1, sizeof(*block));
+    if (block == NULL) {
+        return &s_fallback.counters;
+    }
+
+    block->next = __atomic_load_n(&s_blocks, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&s_blocks, &block->next, block, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    s_local = block;
+    return &block->counters;
+}
+
+/**
+ * @brief Adds a latency sample to the histogram of the calling thread.
+ *
+ * @param[in] ticks The duration of the call.
+ */
+void glbs_counters_latency(uint64_t ticks)
+{
+    unsigned bucket = 0;
+
+    // floor(log2(ticks)), clamped to the last bucket.
+    while (ticks > 1 && bucket < GLBS_LATENCY_BUCKETS - 1) {
+        ticks >>= 1;
+        bucket++;
+    }
+    GLBS_COUNT(latency[bucket], 1);
+}
+
+#ifdef GLBS_INSTRUMENT_DEFAULT_CLOCK
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ *
+ * @return uint64_t The current time.
+ */
+uint64_t glbs_counters_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+/**
+ * @brief Adds the counters of one block to a total.
+ */
+static void glbs_counters_accumulate(glbs_counters_t *total, const glbs_counters_t *block)
+{
+    total->calls += __atomic_load_n(&block->calls, __ATOMIC_RELAXED);
+    total->rejected += __atomic_load_n(&block->rejected, __ATOMIC_RELAXED);
+    total->samples += __atomic_load_n(&block->samples, __ATOMIC_RELAXED);
+    total->outliers += __atomic_load_n(&block->outliers, __ATOMIC_RELAXED);
+    total->iterations += __atomic_load_n(&block->iterations, __ATOMIC_RELAXED);
+    total->exhausted += __atomic_load_n(&block->exhausted, __ATOMIC_RELAXED);
+    for (size_t b = 0; b < GLBS_LATENCY_BUCKETS; b++) {
+        total->latency[b] += __atomic_load_n(&block->latency[b], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Sums the counters of every thread.
+ *
+ * @param[out] counters Pointer receiving the totals.
+ */
+void glbs_counters_read(glbs_counters_t *counters)
+{
+    memset(counters, 0, sizeof(*counters));
+    for (glbs_counter_block_t *block = __atomic_load_n(&s_blocks, __ATOMIC_ACQUIRE); block != NULL;
+         block = block->next) {
+        glbs_counters_accumulate(counters, &block->counters);
+    }
+    glbs_counters_accumulate(counters, &s_fallback.counters);
+}
+
+#endif /* GLBS_INSTRUMENT */
@@ -0,0 +1,257 @@
+/**
+ * @file glbs_fixed.c
+ * @author wdfk-prog
+ * @brief Integer Grubbs' test engine for raw ADC codes.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "glbs.h"
+
+/**
+ * @brief Fractional bits of the scaled critical values K(n).
+ */
+#define GLBS_FIX_K_FRAC 16
+
+/**
+ * @brief Largest magnitude accepted from int32_t samples (24-bit ADC codes).
+ */
+#define GLBS_FIX_I32_LIMIT (INT32_C(1) << 23)
+
+/**
+ * @brief Scaled critical values K(n) = G_p(n)^2 * n / (n - 1) in Q16.
+ *
+ * Derived from gpn_data in glbs.c and indexed by n, so that the integer engine
+ * makes the same decisions as glbs_process() without touching floating point.
+ */
+static const uint32_t gpn_fix_data[][MAX_SAMPLE_NUM + 1] = {
+    /* P=99% (alpha=0.01) */
+    {0, 0, 0, 131140, 194516, 250593, 297203, 336220, 369129, 397861, 422933,
+     445169, 464889, 482530, 499001, 513781, 527504, 540081, 552217, 603646, 573782},
+    /* P=95% (alpha=0.05) */
+    {0, 0, 0, 130686, 187028, 229014, 261071, 287167, 309257, 328244, 344790,
+     359782, 373285, 385768, 396760, 407490, 417211, 426539, 434041, 443495, 451043},
+    /* P=90% (alpha=0.10) */
+    {0, 0, 0, 129555, 177439, 210240, 235099, 255493, 272950, 288168, 301851,
+     314292, 325580, 335862, 345643, 354527, 363076, 371242, 378336, 385614, 392404},
+    /* P=80% (alpha=0.20) */
+    {0, 0, 0, 129555, 116771, 128410, 138903, 155913, 170549, 183356, 194896,
+     205408, 214964, 223686, 231985, 239539, 246810, 253759, 259816, 266021, 271817},
+};
+
+/**
+ * @brief Initializes an integer engine with a built-in confidence level.
+ *
+ * @param[out] fix  The engine.
+ * @param[in]  mode The desired confidence level from gpn_mode_t.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_fix_init(glbs_fix_t *fix, gpn_mode_t mode)
+{
+    if (fix == NULL || (unsigned)mode > GPN_80) {
+        return false;
+    }
+
+    fix->kn    = gpn_fix_data[mode];
+    fix->max_n = MAX_SAMPLE_NUM;
+    return true;
+}
+
+/**
+ * @brief Initializes an integer engine from the critical values of a context.
+ *
+ * @param[out] fix    The engine.
+ * @param[out] buffer Caller-owned array of GLBS_GCRIT_TABLE_LEN(max_n) words.
+ * @param[in]  ctx    The context supplying the critical values.
+ * @param[in]  max_n  The largest window size, at most GLBS_FIX_MAX_NUM.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_fix_init_ctx(glbs_fix_t *fix, uint32_t *buffer, const glbs_ctx_t *ctx, size_t max_n)
+{
+    double gcrit = 0.0;
+
+    if (fix == NULL || buffer == NULL || ctx == NULL || max_n < MIN_SAMPLE_NUM || max_n > GLBS_FIX_MAX_NUM) {
+        return false;
+    }
+
+    for (size_t n = 0; n <= max_n; n++) {
+        if (n < MIN_SAMPLE_NUM) {
+            buffer[n] = 0;
+            continue;
+        }
+        gcrit     = glbs_ctx_gcrit(ctx, n);
+        buffer[n] = (uint32_t)(gcrit * gcrit * n / (n - 1) * (1 << GLBS_FIX_K_FRAC) + 0.5);
+    }
+
+    fix->kn    = buffer;
+    fix->max_n = max_n;
+    return true;
+}
+
+/**
+ * @brief Sorts a short array of integers in ascending order.
+ */
+static void glbs_fix_sort(int32_t *data, size_t num)
+{
+    int32_t key = 0;
+    size_t  j   = 0;
+
+    for (size_t i = 1; i < num; i++) {
+        key = data[i];
+        for (j = i; j > 0 && data[j - 1] > key; j--) {
+            data[j] = data[j - 1];
+        }
+        data[j] = key;
+    }
+}
+
+/**
+ * @brief Tests a^2 * 2^16 > k * b exactly.
+ *
+ * Both sides need up to 96 bits, so they are formed as 128-bit pairs from
+ * 32 x 32 -> 64 bit products, which cores without a 64-bit multiplier handle
+ * with a short library call.
+ */
+static bool glbs_fix_exceeds(uint32_t a, uint32_t k, uint64_t b)
+{
+    uint64_t a_sq   = (uint64_t)a * a;
+    uint64_t lhs_hi = a_sq >> (64 - GLBS_FIX_K_FRAC);
+    uint64_t lhs_lo = a_sq << GLBS_FIX_K_FRAC;
+    uint64_t p_lo   = (uint64_t)k * (uint32_t)b;
+    uint64_t p_hi   = (uint64_t)k * (uint32_t)(b >> 32);
+    uint64_t rhs_lo = p_lo + (p_hi << 32);
+    uint64_t rhs_hi = (p_hi >> 32) + (rhs_lo < p_lo);
+
+    return lhs_hi > rhs_hi || (lhs_hi == rhs_hi && lhs_lo > rhs_lo);
+}
+
+/**
+ * @brief Removes the outliers of a window of integers and returns its mean.
+ *
+ * For the m kept samples y (offset by the median), with S = sum(y) and
+ * Q = sum(y^2), an end value y is an outlier if
+ *
+ *     G^2 = (m * y - S)^2 * (m - 1) / (m * (m * Q - S^2)) > G_p(m)^2,
+ *
+ * i.e. A^2 > K(m) * B with A = |m * y - S| and B = m * Q - S^2. Every step is
+ * a handful of integer multiplies; the only division is the final mean.
+ *
+ * @param[in]     fix  The engine.
+ * @param[in,out] data The working copy, sorted in place.
+ * @param[in]     num  The number of samples.
+ * @param[in]     frac The number of fractional bits of the result.
+ *
+ * @return int32_t The mean of the kept samples with frac fractional bits.
+ */
+static int32_t glbs_fix_run(const glbs_fix_t *fix, int32_t *data, size_t num, unsigned frac)
+{
+    int32_t ref    = 0;
+    int32_t y      = 0;
+    int64_t sum    = 0;
+    int64_t sum_sq = 0;
+    int64_t a_lo   = 0;
+    int64_t a_hi   = 0;
+    int64_t total  = 0;
+    int64_t n      = 0;
+    size_t  lo     = 0;
+    size_t  hi     = num - 1;
+    bool    high   = false;
+
+    glbs_fix_sort(data, num);
+
+    // Offsetting by the median keeps the sums small for ADC codes that sit
+    // far from zero.
+    ref = data[num / 2];
+    for (size_t i = 0; i < num; i++) {
+        y = data[i] - ref;
+        sum += y;
+        sum_sq += (int64_t)y * y;
+    }
+
+    while (hi - lo + 1 >= MIN_SAMPLE_NUM) {
+        n    = (int64_t)(hi - lo + 1);
+        a_lo = sum - n * (data[lo] - ref);
+        a_hi = n * (data[hi] - ref) - sum;
+        high = a_hi > a_lo;
+
+        // B == 0 means the kept range has no spread.
+        if (!glbs_fix_exceeds((uint32_t)(high ? a_hi : a_lo), fix->kn[n], (uint64_t)(n * sum_sq - sum * sum))) {
+            break;
+        }
+
+        y = (high ? data[hi] : data[lo]) - ref;
+        sum -= y;
+        sum_sq -= (int64_t)y * y;
+        if (high) {
+            hi--;
+        } else {
+            lo++;
+        }
+    }
+
+    // Round half away from zero.
+    n     = (int64_t)(hi - lo + 1);
+    total = (sum + n * ref) * ((int64_t)1 << frac);
+    return (int32_t)((total >= 0) ? (total + n / 2) / n : -((-total + n / 2) / n));
+}
+
+/**
+ * @brief Processes a window of 16-bit samples with the integer engine.
+ *
+ * @param[in]  fix     The engine.
+ * @param[in]  samples Pointer to the input array of samples.
+ * @param[in]  num     The number of samples, MIN_SAMPLE_NUM..fix->max_n.
+ * @param[out] result  Pointer receiving the average of the valid samples in
+ *                     Q16.16 sample units.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_fix_process_i16(const glbs_fix_t *fix, const int16_t *samples, size_t num, int32_t *result)
+{
+    int32_t data[GLBS_FIX_MAX_NUM];
+
+    if (num < MIN_SAMPLE_NUM || num > fix->max_n) {
+        return false;
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        data[i] = samples[i];
+    }
+    *result = glbs_fix_run(fix, data, num, GLBS_FIX_I16_FRAC);
+    return true;
+}
+
+/**
+ * @brief Processes a window of 32-bit samples with the integer engine.
+ *
+ * @param[in]  fix     The engine.
+ * @param[in]  samples Pointer to the input array of samples, each within
+ *                     [-2^23, 2^23).
+ * @param[in]  num     The number of samples, MIN_SAMPLE_NUM..fix->max_n.
+ * @param[out] result  Pointer receiving the average of the valid samples in
+ *                     Q24.8 sample units.
+ *
+ * @return bool Returns true on success, false on failure or if a sample is out
+ *              of range.
+ */
+bool glbs_fix_process_i32(const glbs_fix_t *fix, const int32_t *samples, size_t num, int32_t *result)
+{
+    int32_t data[GLBS_FIX_MAX_NUM];
+
+    if (num < MIN_SAMPLE_NUM || num > fix->max_n) {
+        return false;
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        if (samples[i] < -GLBS_FIX_I32_LIMIT || samples[i] >= GLBS_FIX_I32_LIMIT) {
+            return false;
+        }
+        data[i] = samples[i];
+    }
+    *result = glbs_fix_run(fix, data, num, GLBS_FIX_I32_FRAC);
+    return true;
+}
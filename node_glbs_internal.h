@@ -0,0 +1,248 @@
+/**
+ * @file glbs_internal.h
+ * @author wdfk-prog
+ * @brief Definitions shared between the Grubbs' test translation units.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef __GLBS_INTERNAL_H__
+#define __GLBS_INTERNAL_H__
+
+#include "glbs.h"
+
+/**
+ * @brief Running statistics of the kept range of a sorted window.
+ *
+ * The valid samples are always the contiguous range [lo, hi] of the sorted data,
+ * since an outlier can only be the current minimum or maximum. The sums are taken
+ * about a reference value inside the data to limit cancellation when the
+ * variance is derived from them.
+ *
+ * Dropping a glitch far from the data subtracts a term that dwarfs what is left,
+ * so the rounding error of each sum is carried alongside it and folded back in
+ * after every drop. Windows holding such a glitch are summed that way from the
+ * start; for the others the carried error starts at zero.
+ *
+ * The carried error holds one glitch exactly, but not several of very different
+ * magnitudes. sum_sq_peak records the magnitude the sums are accurate relative
+ * to; once the drops leave the spread of the kept range far below it, or far
+ * below the distance to ref, the kept range is summed again about its middle,
+ * from sorted when the engine keeps it there.
+ */
+typedef struct glbs_trim_s {
+    size_t       lo;          /**< Index of the smallest kept sample. */
+    size_t       hi;          /**< Index of the largest kept sample. */
+    double       ref;         /**< Reference value the sums are taken about. */
+    double       sum;         /**< Sum of (value - ref) over the kept samples. */
+    double       sum_sq;      /**< Sum of (value - ref)^2 over the kept samples. */
+    double       sum_err;     /**< Rounding error of sum not yet folded into it. */
+    double       sum_sq_err;  /**< Rounding error of sum_sq not yet folded into it. */
+    double       sum_sq_peak; /**< Largest sum_sq_err reached, or sum_sq for plain sums. */
+    const float *sorted;      /**< Samples holding the kept range at [lo, hi], or NULL. */
+    size_t       stride;      /**< Distance between consecutive samples of sorted, in floats. */
+} glbs_trim_t;
+
+/**
+ * @brief How far the spread may fall below the sums before they are redone.
+ *
+ * The sum of squares about the mean is off by about n * DBL_EPSILON times the
+ * larger of sum_sq and sum_sq_peak, so below this ratio it stays accurate to
+ * about n * 2^-33.
+ */
+#define GLBS_TRIM_LOSSY (1024.0 * 1024.0)
+
+/**
+ * @brief Adds a term to a sum, accumulating the rounding error separately.
+ *
+ * Knuth's TwoSum recovers the part of the term lost to rounding without a
+ * branch.
+ *
+ * @param[in,out] sum  The sum.
+ * @param[in,out] err  The rounding error not yet folded into the sum.
+ * @param[in]     term The term to add.
+ */
+static inline void glbs_sum_add(double *sum, double *err, double term)
+{
+    double total = *sum + term;
+    double part  = total - *sum;
+
+    *err += (*sum - (total - part)) + (term - part);
+    *sum = total;
+}
+
+/**
+ * @brief Folds the accumulated rounding error into a sum.
+ *
+ * Afterwards the sum is the correctly rounded total and the error holds only
+ * what does not fit into it.
+ *
+ * @param[in,out] sum The sum.
+ * @param[in,out] err The rounding error not yet folded into the sum.
+ */
+static inline void glbs_sum_fold(double *sum, double *err)
+{
+    double total = *sum + *err;
+
+    *err -= total - *sum;
+    *sum = total;
+}
+
+/**
+ * @brief Adds a deviation and its square to the sums, carrying the rounding error.
+ *
+ * @param[in,out] trim  The trim state.
+ * @param[in]     delta The deviation of a sample from trim->ref.
+ */
+static inline void glbs_trim_add(glbs_trim_t *trim, double delta)
+{
+    double err = 0.0;
+
+    glbs_sum_add(&trim->sum, &trim->sum_err, delta);
+    glbs_sum_add(&trim->sum_sq, &trim->sum_sq_err, delta * delta);
+    err               = (trim->sum_sq_err < 0.0) ? -trim->sum_sq_err : trim->sum_sq_err;
+    trim->sum_sq_peak = (err > trim->sum_sq_peak) ? err : trim->sum_sq_peak;
+}
+
+/**
+ * @brief Tells whether the drops left the sums with little more than rounding error.
+ *
+ * @param[in] trim The trim state.
+ *
+ * @return bool Returns true if the kept range must be summed again.
+ */
+static inline bool glbs_trim_lossy(const glbs_trim_t *trim)
+{
+    double n     = (double)(trim->hi - trim->lo + 1);
+    double scale = (trim->sum_sq_peak > trim->sum_sq) ? trim->sum_sq_peak : trim->sum_sq;
+
+    return scale > GLBS_TRIM_LOSSY * (trim->sum_sq - trim->sum * (trim->sum / n));
+}
+
+/**
+ * @brief Tells whether an end of a window lies far outside its middle.
+ *
+ * @param[in] sorted The samples, ordered by glbs_order() or sorted.
+ * @param[in] num    The number of samples, at least 1.
+ * @param[in] stride The distance between consecutive samples, in floats.
+ *
+ * @return bool Returns true if the sums must carry their rounding error.
+ */
+bool glbs_trim_wild(const float *sorted, size_t num, size_t stride);
+
+/**
+ * @brief Runs one Grubbs' test on the extremes of the kept range.
+ *
+ * @param[in,out] trim   The trim state.
+ * @param[in]     ctx    The context supplying the critical values.
+ * @param[in]     lo_val The value of rank trim->lo.
+ * @param[in]     hi_val The value of rank trim->hi.
+ *
+ * @return bool Returns true if a sample was removed, false when the test stops.
+ */
+bool glbs_trim_step(glbs_trim_t *trim, const glbs_ctx_t *ctx, float lo_val, float hi_val);
+
+/**
+ * @brief Returns the average of the kept range.
+ *
+ * @param[in] trim The trim state after the last step.
+ *
+ * @return float The average of the remaining valid samples.
+ */
+float glbs_trim_mean(const glbs_trim_t *trim);
+
+/**
+ * @brief Orders the ends of a window for the trimming loop.
+ *
+ * @param[in]     ctx  The context; ctx->max_outliers ends are ordered.
+ * @param[in,out] data The working copy.
+ * @param[in]     num  The number of samples.
+ *
+ * @return size_t The number of samples in order at each end, num if sorted.
+ */
+size_t glbs_order(const glbs_ctx_t *ctx, float *data, size_t num);
+
+#ifdef GLBS_INSTRUMENT
+/**
+ * @brief Per-thread counters, linked into the list read by glbs_counters_read().
+ */
+typedef struct glbs_counter_block_s {
+    glbs_counters_t              counters; /**< Counts of the owning thread. */
+    struct glbs_counter_block_s *next;     /**< Next registered block. */
+} glbs_counter_block_t;
+
+/**
+ * @brief Returns the counters of the calling thread, registering them on first use.
+ */
+glbs_counters_t *glbs_counters_local(void);
+
+/**
+ * @brief Adds a latency sample to the histogram of the calling thread.
+ */
+void glbs_counters_latency(uint64_t ticks);
+
+/**
+ * @brief Returns the current time for the latency histogram.
+ *
+ * Defaults to CLOCK_MONOTONIC in nanoseconds. Define GLBS_INSTRUMENT_NOW() to a
+ * cheaper source, e.g. a cycle counter, on targets without clock_gettime().
+ */
+#ifndef GLBS_INSTRUMENT_NOW
+#define GLBS_INSTRUMENT_DEFAULT_CLOCK 1
+uint64_t glbs_counters_now(void);
+#define GLBS_INSTRUMENT_NOW() glbs_counters_now()
+#endif
+
+/**
+ * @brief Adds n to a counter of the calling thread.
+ *
+ * Only the owning thread writes its block, so a relaxed load and store suffice
+ * and concurrent readers never see a torn value.
+ */
+#define GLBS_COUNT(field, n)                                                                                           \
+    do {                                                                                                               \
+        glbs_counters_t *count_local_ = glbs_counters_local();                                                        \
+        __atomic_store_n(&count_local_->field, count_local_->field + (uint64_t)(n), __ATOMIC_RELAXED);                \
+    } while (0)
+
+/**
+ * @brief Starts timing a call into the variable var.
+ */
+#define GLBS_TRACE_BEGIN(var) uint64_t var = GLBS_INSTRUMENT_NOW()
+
+/**
+ * @brief Records the duration of a call started with GLBS_TRACE_BEGIN(var).
+ */
+#define GLBS_TRACE_END(var) glbs_counters_latency(GLBS_INSTRUMENT_NOW() - (var))
+
+/**
+ * @brief Counts a failed call started with GLBS_TRACE_BEGIN(var) and records its duration.
+ *
+ * Every exit of a counted call ends its trace, so that the latency histogram
+ * always adds up to the calls.
+ */
+#define GLBS_TRACE_REJECT(var)                                                                                         \
+    do {                                                                                                               \
+        GLBS_COUNT(rejected, 1);                                                                                       \
+        GLBS_TRACE_END(var);                                                                                           \
+    } while (0)
+#else
+#define GLBS_COUNT(field, n) ((void)0)
+#define GLBS_TRACE_BEGIN(var)
+#define GLBS_TRACE_END(var) ((void)0)
+#define GLBS_TRACE_REJECT(var) ((void)0)
+#endif /* GLBS_INSTRUMENT */
+
+#ifdef GLBS_PROFILE
+/**
+ * @brief Stages of glbs_ctx_process(), exported by builds with GLBS_PROFILE defined
+ *        so that tools/glbs_profile.c can measure each one in isolation.
+ */
+void  glbs_profile_sort(float *data, size_t num);
+void  glbs_profile_sums(glbs_trim_t *trim, const float *sorted, size_t num);
+float glbs_profile_test(glbs_trim_t *trim, const glbs_ctx_t *ctx, const float *sorted);
+#endif /* GLBS_PROFILE */
+
+#endif /* __GLBS_INTERNAL_H__ */
@@ -0,0 +1,238 @@
+/**
+ * @file glbs_network.h
+ * @author wdfk-prog
+ * @brief Sorting networks for windows of 2 to MAX_SAMPLE_NUM samples.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * GLBS_NETWORK_n(X) expands X(i, j) once per comparator of an n-input network,
+ * layer by layer; a comparator puts the smaller of elements i and j at i. The
+ * networks are the smallest found among Batcher's odd-even merge sort (pruned
+ * to n inputs), Bose-Nelson, and recursive splits merged by pruned Batcher
+ * merges, and each was checked on all 2^n zero-one inputs. Up to n = 8 they are
+ * optimal; above, they are a few comparators longer than the best known ones.
+ */
+#ifndef __GLBS_NETWORK_H__
+#define __GLBS_NETWORK_H__
+
+/* n = 2: 1 comparator, depth 1. */
+#define GLBS_NETWORK_2(X) X(0, 1)
+
+/* n = 3: 3 comparators, depth 3. */
+#define GLBS_NETWORK_3(X)                                                                                              \
+    X(0, 1)                                                                                                            \
+    X(0, 2)                                                                                                            \
+    X(1, 2)
+
+/* n = 4: 5 comparators, depth 3. */
+#define GLBS_NETWORK_4(X)                                                                                              \
+    X(0, 1) X(2, 3)                                                                                                    \
+    X(0, 2) X(1, 3)                                                                                                    \
+    X(1, 2)
+
+/* n = 5: 9 comparators, depth 5. */
+#define GLBS_NETWORK_5(X)                                                                                              \
+    X(0, 1) X(2, 3)                                                                                                    \
+    X(0, 2) X(1, 3)                                                                                                    \
+    X(1, 2) X(0, 4)                                                                                                    \
+    X(2, 4)                                                                                                            \
+    X(1, 2) X(3, 4)
+
+/* n = 6: 12 comparators, depth 6. */
+#define GLBS_NETWORK_6(X)                                                                                              \
+    X(0, 1) X(2, 3) X(4, 5)                                                                                            \
+    X(0, 2) X(1, 3)                                                                                                    \
+    X(1, 2) X(0, 4)                                                                                                    \
+    X(1, 5) X(2, 4)                                                                                                    \
+    X(3, 5) X(1, 2)                                                                                                    \
+    X(3, 4)
+
+/* n = 7: 16 comparators, depth 6. */
+#define GLBS_NETWORK_7(X)                                                                                              \
+    X(0, 1) X(2, 3) X(4, 5)                                                                                            \
+    X(0, 2) X(1, 3) X(4, 6)                                                                                            \
+    X(1, 2) X(5, 6) X(0, 4)                                                                                            \
+    X(1, 5) X(2, 6)                                                                                                    \
+    X(2, 4) X(3, 5)                                                                                                    \
+    X(1, 2) X(3, 4) X(5, 6)
+
+/* n = 8: 19 comparators, depth 6. */
+#define GLBS_NETWORK_8(X)                                                                                              \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7)                                                                                    \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7)                                                                                    \
+    X(1, 2) X(5, 6) X(0, 4) X(3, 7)                                                                                    \
+    X(1, 5) X(2, 6)                                                                                                    \
+    X(2, 4) X(3, 5)                                                                                                    \
+    X(1, 2) X(3, 4) X(5, 6)
+
+/* n = 9: 26 comparators, depth 8. */
+#define GLBS_NETWORK_9(X)                                                                                              \
+    X(0, 1) X(2, 3) X(5, 6) X(7, 8)                                                                                    \
+    X(0, 2) X(1, 3) X(5, 7) X(6, 8)                                                                                    \
+    X(1, 2) X(0, 4) X(6, 7)                                                                                            \
+    X(2, 4) X(0, 8)                                                                                                    \
+    X(1, 2) X(3, 4)                                                                                                    \
+    X(1, 5) X(3, 7) X(2, 6) X(4, 8)                                                                                    \
+    X(3, 5) X(0, 2) X(4, 6)                                                                                            \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7)
+
+/* n = 10: 31 comparators, depth 9. */
+#define GLBS_NETWORK_10(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9)                                                                            \
+    X(0, 2) X(1, 3) X(6, 8) X(7, 9)                                                                                    \
+    X(1, 2) X(0, 4) X(7, 8)                                                                                            \
+    X(1, 5) X(2, 4) X(0, 8)                                                                                            \
+    X(3, 5) X(1, 2)                                                                                                    \
+    X(3, 4) X(2, 6) X(1, 9)                                                                                            \
+    X(4, 8) X(0, 2) X(3, 7) X(5, 9)                                                                                    \
+    X(4, 6) X(1, 3) X(5, 7)                                                                                            \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8)
+
+/* n = 11: 37 comparators, depth 10. */
+#define GLBS_NETWORK_11(X)                                                                                             \
+    X(0, 1) X(3, 4) X(5, 6) X(7, 8) X(9, 10)                                                                           \
+    X(0, 2) X(3, 5) X(4, 6) X(7, 9) X(8, 10)                                                                           \
+    X(1, 2) X(4, 5) X(8, 9) X(3, 7) X(6, 10)                                                                           \
+    X(4, 8) X(5, 9) X(2, 10)                                                                                           \
+    X(5, 7) X(6, 8)                                                                                                    \
+    X(4, 5) X(6, 7) X(8, 9)                                                                                            \
+    X(1, 9) X(0, 8) X(2, 6)                                                                                            \
+    X(1, 5) X(0, 4) X(6, 8)                                                                                            \
+    X(1, 3) X(5, 7) X(2, 4) X(8, 9)                                                                                    \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7)
+
+/* n = 12: 41 comparators, depth 10. */
+#define GLBS_NETWORK_12(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11)                                                                  \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11)                                                                  \
+    X(1, 2) X(5, 6) X(9, 10) X(4, 8) X(7, 11)                                                                          \
+    X(5, 9) X(6, 10) X(3, 11)                                                                                          \
+    X(6, 8) X(7, 9)                                                                                                    \
+    X(5, 6) X(7, 8) X(9, 10)                                                                                           \
+    X(0, 8) X(2, 10) X(1, 9) X(3, 7)                                                                                   \
+    X(0, 4) X(2, 6) X(1, 5) X(7, 9)                                                                                    \
+    X(2, 4) X(6, 8) X(3, 5) X(9, 10)                                                                                   \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8)
+
+/* n = 13: 48 comparators, depth 10. */
+#define GLBS_NETWORK_13(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11)                                                                  \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11)                                                                  \
+    X(1, 2) X(5, 6) X(9, 10) X(0, 4) X(3, 7) X(8, 12)                                                                  \
+    X(1, 5) X(2, 6) X(10, 12) X(0, 8)                                                                                  \
+    X(2, 4) X(3, 5) X(9, 10) X(11, 12)                                                                                 \
+    X(1, 2) X(3, 4) X(5, 6)                                                                                            \
+    X(1, 9) X(2, 10) X(3, 11) X(4, 12)                                                                                 \
+    X(4, 8) X(5, 9) X(6, 10) X(7, 11)                                                                                  \
+    X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12)                                                                          \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12)
+
+/* n = 14: 53 comparators, depth 10. */
+#define GLBS_NETWORK_14(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13)                                                        \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11)                                                                  \
+    X(1, 2) X(5, 6) X(9, 10) X(0, 4) X(3, 7) X(8, 12)                                                                  \
+    X(1, 5) X(2, 6) X(9, 13) X(10, 12) X(0, 8)                                                                         \
+    X(2, 4) X(3, 5) X(11, 13) X(9, 10)                                                                                 \
+    X(1, 2) X(3, 4) X(5, 6) X(11, 12)                                                                                  \
+    X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(5, 13)                                                                        \
+    X(4, 8) X(5, 9) X(6, 10) X(7, 11)                                                                                  \
+    X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) X(11, 13)                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12)
+
+/* n = 15: 59 comparators, depth 10. */
+#define GLBS_NETWORK_15(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13)                                                        \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11) X(12, 14)                                                        \
+    X(1, 2) X(5, 6) X(9, 10) X(13, 14) X(0, 4) X(3, 7) X(8, 12)                                                        \
+    X(1, 5) X(2, 6) X(9, 13) X(10, 14) X(0, 8)                                                                         \
+    X(2, 4) X(3, 5) X(10, 12) X(11, 13)                                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(9, 10) X(11, 12) X(13, 14)                                                               \
+    X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(5, 13) X(6, 14)                                                               \
+    X(4, 8) X(5, 9) X(6, 10) X(7, 11)                                                                                  \
+    X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) X(11, 13)                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12) X(13, 14)
+
+/* n = 16: 63 comparators, depth 10. */
+#define GLBS_NETWORK_16(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13) X(14, 15)                                              \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11) X(12, 14) X(13, 15)                                              \
+    X(1, 2) X(5, 6) X(9, 10) X(13, 14) X(0, 4) X(3, 7) X(8, 12) X(11, 15)                                              \
+    X(1, 5) X(2, 6) X(9, 13) X(10, 14) X(0, 8) X(7, 15)                                                                \
+    X(2, 4) X(3, 5) X(10, 12) X(11, 13)                                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(9, 10) X(11, 12) X(13, 14)                                                               \
+    X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(5, 13) X(6, 14)                                                               \
+    X(4, 8) X(5, 9) X(6, 10) X(7, 11)                                                                                  \
+    X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) X(11, 13)                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12) X(13, 14)
+
+/* n = 17: 74 comparators, depth 12. */
+#define GLBS_NETWORK_17(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(13, 14) X(15, 16)                                              \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11) X(13, 15) X(14, 16)                                              \
+    X(1, 2) X(5, 6) X(0, 4) X(3, 7) X(9, 10) X(8, 12) X(14, 15)                                                        \
+    X(1, 5) X(2, 6) X(10, 12) X(8, 16)                                                                                 \
+    X(2, 4) X(3, 5) X(9, 10) X(11, 12)                                                                                 \
+    X(1, 2) X(3, 4) X(5, 6) X(9, 13) X(11, 15) X(10, 14) X(12, 16)                                                     \
+    X(11, 13) X(8, 10) X(12, 14) X(0, 16)                                                                              \
+    X(8, 9) X(10, 11) X(12, 13) X(14, 15)                                                                              \
+    X(0, 8) X(4, 12) X(2, 10) X(6, 14) X(1, 9) X(5, 13) X(3, 11) X(7, 15)                                              \
+    X(4, 8) X(12, 16) X(6, 10) X(5, 9) X(7, 11)                                                                        \
+    X(2, 4) X(6, 8) X(10, 12) X(14, 16) X(3, 5) X(7, 9) X(11, 13)                                                      \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12) X(13, 14) X(15, 16)
+
+/* n = 18: 82 comparators, depth 14. */
+#define GLBS_NETWORK_18(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13) X(14, 15) X(16, 17)                                    \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11) X(14, 16) X(15, 17)                                              \
+    X(1, 2) X(5, 6) X(0, 4) X(3, 7) X(9, 10) X(8, 12) X(15, 16)                                                        \
+    X(1, 5) X(2, 6) X(9, 13) X(10, 12) X(8, 16)                                                                        \
+    X(2, 4) X(3, 5) X(11, 13) X(9, 10)                                                                                 \
+    X(1, 2) X(3, 4) X(5, 6) X(11, 12) X(10, 14) X(9, 17)                                                               \
+    X(12, 16) X(8, 10) X(11, 15) X(13, 17)                                                                             \
+    X(12, 14) X(9, 11) X(13, 15) X(1, 17)                                                                              \
+    X(9, 10) X(11, 12) X(13, 14) X(15, 16)                                                                             \
+    X(0, 16) X(4, 12) X(2, 10) X(6, 14) X(1, 9) X(5, 13) X(3, 11) X(7, 15)                                             \
+    X(0, 8) X(12, 16) X(6, 10) X(5, 9) X(13, 17) X(7, 11)                                                              \
+    X(4, 8) X(10, 12) X(14, 16) X(3, 5) X(7, 9) X(11, 13) X(15, 17)                                                    \
+    X(2, 4) X(6, 8) X(9, 10) X(11, 12) X(13, 14) X(15, 16)                                                             \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8)
+
+/* n = 19: 91 comparators, depth 14. */
+#define GLBS_NETWORK_19(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(11, 12) X(13, 14) X(15, 16) X(17, 18)                                    \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(11, 13) X(12, 14) X(15, 17) X(16, 18)                                   \
+    X(1, 2) X(5, 6) X(0, 4) X(3, 7) X(9, 10) X(12, 13) X(16, 17) X(11, 15) X(14, 18)                                   \
+    X(1, 5) X(2, 6) X(12, 16) X(13, 17) X(10, 18)                                                                      \
+    X(2, 4) X(3, 5) X(13, 15) X(14, 16)                                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(12, 13) X(14, 15) X(16, 17)                                                              \
+    X(9, 17) X(8, 16) X(10, 14) X(2, 18)                                                                               \
+    X(9, 13) X(8, 12) X(14, 16)                                                                                        \
+    X(9, 11) X(13, 15) X(10, 12) X(16, 17)                                                                             \
+    X(8, 9) X(10, 11) X(12, 13) X(14, 15) X(0, 16) X(1, 17)                                                            \
+    X(0, 8) X(4, 12) X(2, 10) X(6, 14) X(1, 9) X(5, 13) X(3, 11) X(7, 15)                                              \
+    X(4, 8) X(12, 16) X(6, 10) X(14, 18) X(5, 9) X(13, 17) X(7, 11)                                                    \
+    X(2, 4) X(6, 8) X(10, 12) X(14, 16) X(3, 5) X(7, 9) X(11, 13) X(15, 17)                                            \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12) X(13, 14) X(15, 16) X(17, 18)
+
+/* n = 20: 97 comparators, depth 15. */
+#define GLBS_NETWORK_20(X)                                                                                             \
+    X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13) X(14, 15) X(16, 17) X(18, 19)                          \
+    X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(9, 11) X(12, 14) X(13, 15) X(16, 18) X(17, 19)                          \
+    X(1, 2) X(5, 6) X(0, 4) X(3, 7) X(9, 10) X(13, 14) X(17, 18) X(12, 16) X(15, 19)                                   \
+    X(1, 5) X(2, 6) X(13, 17) X(14, 18) X(11, 19)                                                                      \
+    X(2, 4) X(3, 5) X(14, 16) X(15, 17)                                                                                \
+    X(1, 2) X(3, 4) X(5, 6) X(13, 14) X(15, 16) X(17, 18)                                                              \
+    X(8, 16) X(10, 18) X(9, 17) X(11, 15) X(3, 19)                                                                     \
+    X(8, 12) X(10, 14) X(9, 13) X(15, 17)                                                                              \
+    X(10, 12) X(14, 16) X(11, 13) X(17, 18)                                                                            \
+    X(9, 10) X(11, 12) X(13, 14) X(15, 16) X(2, 18) X(1, 17)                                                           \
+    X(0, 16) X(4, 12) X(2, 10) X(6, 14) X(1, 9) X(5, 13) X(3, 11) X(7, 15)                                             \
+    X(0, 8) X(12, 16) X(6, 10) X(14, 18) X(5, 9) X(13, 17) X(7, 11) X(15, 19)                                          \
+    X(4, 8) X(10, 12) X(14, 16) X(3, 5) X(7, 9) X(11, 13) X(15, 17)                                                    \
+    X(2, 4) X(6, 8) X(9, 10) X(11, 12) X(13, 14) X(15, 16) X(17, 18)                                                   \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8)
+
+#endif /* __GLBS_NETWORK_H__ */
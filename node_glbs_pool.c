@@ -0,0 +1,784 @@
+/**
+ * @file glbs_pool.c
+ * @author wdfk-prog
+ * @brief Work-stealing thread pool for large batches of windows, built with GLBS_THREADS.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glbs.h"
+#include "glbs_internal.h"
+
+#ifdef GLBS_THREADS
+
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * @brief Cache line size assumed for padding the per-worker state.
+ */
+#define GLBS_POOL_LINE 64
+
+/**
+ * @brief Chunks handed to each worker per run when the caller picks no chunk size.
+ *
+ * More chunks balance the tail better; each costs one compare-and-swap.
+ */
+#define GLBS_POOL_CHUNKS_PER_WORKER 64
+
+/**
+ * @brief Largest chunk picked automatically, in items.
+ */
+#define GLBS_POOL_MAX_CHUNK 4096
+
+/**
+ * @brief Parts a large window is split into per worker.
+ */
+#define GLBS_POOL_LARGE_PARTS 4
+
+/**
+ * @brief Smallest window split across the workers; smaller ones run on the caller.
+ */
+#define GLBS_POOL_LARGE_MIN_NUM 65536
+
+/**
+ * @brief Ends ordered per part of a large window when ctx->max_outliers is 0.
+ */
+#define GLBS_POOL_LARGE_ENDS 256
+
+/**
+ * @brief Packs the chunk range [begin, end) into one word.
+ */
+#define GLBS_POOL_RANGE(begin, end) (((uint64_t)(end) << 32) | (uint64_t)(begin))
+#define GLBS_POOL_BEGIN(range)      ((uint32_t)(range))
+#define GLBS_POOL_END(range)        ((uint32_t)((range) >> 32))
+
+/**
+ * @brief State of one worker, padded to its own cache lines.
+ *
+ * The range is the only field other workers touch. The owner takes chunks from
+ * its front and thieves take halves from its back, both with a compare-and-swap
+ * of the packed word, so neither side needs a lock.
+ */
+typedef struct glbs_pool_worker_s {
+    union {
+        uint64_t range;               /**< Chunks [begin, end) not yet taken. */
+        char     pad[GLBS_POOL_LINE]; /**< Keeps the range off the lines of other workers. */
+    } u;
+    struct glbs_pool_s *pool;                 /**< The owning pool. */
+    size_t              id;                   /**< Index of the worker; 0 is the calling thread. */
+    pthread_t           thread;               /**< Thread of workers 1 and above. */
+    glbs_ctx_t          ctx;                  /**< Per-worker context handed to the callback. */
+    void               *scratch;              /**< Per-worker scratch buffer, or NULL. */
+    char                tail[GLBS_POOL_LINE]; /**< Keeps the next worker's range off these lines. */
+} glbs_pool_worker_t;
+
+/**
+ * @brief Thread pool. The mutex and conditions only start and join runs.
+ */
+struct glbs_pool_s {
+    pthread_mutex_t     lock;         /**< Guards the start and join of a run. */
+    pthread_cond_t      start;        /**< Signalled when a run starts or the pool stops. */
+    pthread_cond_t      done;         /**< Signalled when the last worker finishes a run. */
+    unsigned long       generation;   /**< Number of runs started. */
+    size_t              busy;         /**< Workers still running the current run. */
+    bool                quit;         /**< Whether the workers should exit. */
+    glbs_pool_fn_t      fn;           /**< Callback of the current run. */
+    void               *arg;          /**< Argument of the current run. */
+    size_t              count;        /**< Items of the current run. */
+    size_t              chunk;        /**< Items per chunk of the current run. */
+    size_t              threads;      /**< Number of workers, the calling thread included. */
+    size_t              started;      /**< One past the last worker thread created. */
+    size_t              scratch_size; /**< Bytes of each worker scratch buffer. */
+    glbs_pool_worker_t *workers;      /**< Per-worker state. */
+};
+
+/**
+ * @brief Takes the next chunk from the front of a worker's own range.
+ *
+ * @param[in,out] worker The worker.
+ * @param[out]    chunk  Receives the chunk index.
+ *
+ * @return bool Returns true if a chunk was taken, false if the range is empty.
+ */
+static bool glbs_pool_pop(glbs_pool_worker_t *worker, uint32_t *chunk)
+{
+    uint64_t range = __atomic_load_n(&worker->u.range, __ATOMIC_RELAXED);
+
+    do {
+        if (GLBS_POOL_BEGIN(range) >= GLBS_POOL_END(range)) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&worker->u.range, &range,
+                                          GLBS_POOL_RANGE(GLBS_POOL_BEGIN(range) + 1, GLBS_POOL_END(range)), true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    *chunk = GLBS_POOL_BEGIN(range);
+    return true;
+}
+
+/**
+ * @brief Moves half of another worker's range into the range of a thief.
+ *
+ * The thief's range is empty, so no other worker modifies it while it is
+ * replaced. Ranges only ever shrink or move, and a chunk is never handed out
+ * twice, so a stale word cannot match and the compare-and-swap is ABA-free.
+ *
+ * @param[in,out] thief The worker whose range is empty.
+ *
+ * @return bool Returns true if chunks were stolen, false if every range is empty.
+ */
+static bool glbs_pool_steal(glbs_pool_worker_t *thief)
+{
+    glbs_pool_t *pool = thief->pool;
+
+    for (size_t i = 1; i < pool->threads; i++) {
+        glbs_pool_worker_t *victim = &pool->workers[(thief->id + i) % pool->threads];
+        uint64_t            range  = __atomic_load_n(&victim->u.range, __ATOMIC_RELAXED);
+        uint32_t            split  = 0;
+
+        while (GLBS_POOL_BEGIN(range) < GLBS_POOL_END(range)) {
+            // Take the back half, rounded up so that a last chunk can be stolen.
+            split = GLBS_POOL_END(range) - (GLBS_POOL_END(range) - GLBS_POOL_BEGIN(range) + 1) / 2;
+            if (__atomic_compare_exchange_n(&victim->u.range, &range, GLBS_POOL_RANGE(GLBS_POOL_BEGIN(range), split),
+                                            false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                __atomic_store_n(&thief->u.range, GLBS_POOL_RANGE(split, GLBS_POOL_END(range)), __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Runs chunks of the current run until no worker has any left.
+ *
+ * @param[in,out] worker The worker.
+ */
+static void glbs_pool_work(glbs_pool_worker_t *worker)
+{
+    glbs_pool_t *pool  = worker->pool;
+    uint32_t     chunk = 0;
+    size_t       begin = 0;
+    size_t       end   = 0;
+
+    do {
+        while (glbs_pool_pop(worker, &chunk)) {
+            begin = (size_t)chunk * pool->chunk;
+            end   = (begin + pool->chunk < pool->count) ? begin + pool->chunk : pool->count;
+            pool->fn(&worker->ctx, pool->arg, begin, end);
+        }
+    } while (glbs_pool_steal(worker));
+}
+
+/**
+ * @brief Main loop of the worker threads.
+ *
+ * @param[in] param The worker.
+ *
+ * @return void* Always NULL.
+ */
+static void *glbs_pool_main(void *param)
+{
+    glbs_pool_worker_t *worker = param;
+    glbs_pool_t        *pool   = worker->pool;
+    unsigned long       seen   = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->generation == seen && !pool->quit) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        glbs_pool_work(worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * @brief Creates a thread pool.
+ *
+ * @param[in] threads      The number of workers, the calling thread included,
+ *                         or 0 for one per online processor.
+ * @param[in] scratch_size Bytes of scratch buffer given to each worker context.
+ *
+ * @return glbs_pool_t* The pool, or NULL if it could not be created.
+ */
+glbs_pool_t *glbs_pool_create(size_t threads, size_t scratch_size)
+{
+    glbs_pool_t *pool  = NULL;
+    void        *block = NULL;
+    long         cpus  = 0;
+
+    if (threads == 0) {
+        cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (size_t)cpus : 1;
+    }
+
+    pool = calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (posix_memalign(&block, GLBS_POOL_LINE, threads * sizeof(glbs_pool_worker_t)) != 0) {
+        free(pool);
+        return NULL;
+    }
+    memset(block, 0, threads * sizeof(glbs_pool_worker_t));
+    pool->workers      = block;
+    pool->threads      = threads;
+    pool->scratch_size = scratch_size;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t w = 0; w < threads; w++) {
+        glbs_pool_worker_t *worker = &pool->workers[w];
+
+        worker->pool = pool;
+        worker->id   = w;
+        glbs_ctx_init(&worker->ctx, GPN_80);
+        if (scratch_size > 0) {
+            worker->scratch = malloc(scratch_size);
+            if (worker->scratch == NULL) {
+                glbs_pool_destroy(pool);
+                return NULL;
+            }
+        }
+    }
+    for (size_t w = 1; w < threads; w++) {
+        if (pthread_create(&pool->workers[w].thread, NULL, glbs_pool_main, &pool->workers[w]) != 0) {
+            glbs_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started = w + 1;
+    }
+    return pool;
+}
+
+/**
+ * @brief Stops the workers of a pool and releases it.
+ *
+ * @param[in] pool The pool, or NULL.
+ */
+void glbs_pool_destroy(glbs_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t w = 1; w < pool->started; w++) {
+        pthread_join(pool->workers[w].thread, NULL);
+    }
+
+    for (size_t w = 0; w < pool->threads; w++) {
+        free(pool->workers[w].scratch);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+ * @brief Returns the number of workers of a pool, the calling thread included.
+ *
+ * @param[in] pool The pool.
+ *
+ * @return size_t The number of workers.
+ */
+size_t glbs_pool_threads(const glbs_pool_t *pool)
+{
+    return pool->threads;
+}
+
+/**
+ * @brief Calls fn on chunks of [0, count) from every worker of the pool.
+ *
+ * @param[in,out] pool  The pool.
+ * @param[in]     ctx   The context copied into each worker context.
+ * @param[in]     count The number of items.
+ * @param[in]     chunk The number of items per call, or 0 to pick one.
+ * @param[in]     fn    The callback.
+ * @param[in]     arg   The argument passed to fn.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_pool_run(glbs_pool_t *pool, const glbs_ctx_t *ctx, size_t count, size_t chunk, glbs_pool_fn_t fn,
+                   void *arg)
+{
+    size_t chunks = 0;
+    size_t share  = 0;
+    size_t rest   = 0;
+    size_t next   = 0;
+
+    if (pool == NULL || ctx == NULL || fn == NULL) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    if (chunk == 0) {
+        chunk = count / (pool->threads * GLBS_POOL_CHUNKS_PER_WORKER);
+        chunk = (chunk < 1) ? 1 : (chunk > GLBS_POOL_MAX_CHUNK) ? GLBS_POOL_MAX_CHUNK : chunk;
+    }
+    // Chunk indices are packed in 32 bits.
+    if ((count - 1) / chunk >= UINT32_MAX) {
+        chunk = (count - 1) / (UINT32_MAX - 1) + 1;
+    }
+    chunks = (count - 1) / chunk + 1;
+
+    // Contiguous equal shares keep each worker on its own part of the input
+    // until it runs dry and starts stealing.
+    share = chunks / pool->threads;
+    rest  = chunks % pool->threads;
+    for (size_t w = 0; w < pool->threads; w++) {
+        glbs_pool_worker_t *worker = &pool->workers[w];
+        size_t              take   = share + (w < rest);
+
+        worker->ctx = *ctx;
+        glbs_ctx_set_scratch(&worker->ctx, worker->scratch, pool->scratch_size);
+        worker->u.range = GLBS_POOL_RANGE(next, next + take);
+        next += take;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn    = fn;
+    pool->arg   = arg;
+    pool->count = count;
+    pool->chunk = chunk;
+    pool->busy  = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    glbs_pool_work(&pool->workers[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+/**
+ * @brief Arguments of the window callbacks.
+ */
+typedef struct glbs_pool_job_s {
+    const float         *samples; /**< Windows laid out back to back, or NULL. */
+    const glbs_window_t *windows; /**< Window descriptors, or NULL. */
+    size_t               num;     /**< Samples per window of the back-to-back layout. */
+    float               *results; /**< One result per window. */
+    bool                 failed;  /**< Set when a window could not be processed. */
+} glbs_pool_job_t;
+
+/**
+ * @brief Records a failed window. Every writer stores the same value.
+ */
+static void glbs_pool_fail(glbs_pool_job_t *job, float *result)
+{
+    *result = NAN;
+    __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Processes windows [begin, end) of the back-to-back layout.
+ */
+static void glbs_pool_windows_packed(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    glbs_pool_job_t *job = arg;
+
+    for (size_t w = begin; w < end; w++) {
+        if (!glbs_ctx_process(ctx, job->samples + w * job->num, job->num, &job->results[w])) {
+            glbs_pool_fail(job, &job->results[w]);
+        }
+    }
+}
+
+/**
+ * @brief Processes the windows described by [begin, end).
+ */
+static void glbs_pool_windows_desc(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    glbs_pool_job_t *job = arg;
+
+    for (size_t w = begin; w < end; w++) {
+        if (!glbs_ctx_process(ctx, job->windows[w].samples, job->windows[w].num, &job->results[w])) {
+            glbs_pool_fail(job, &job->results[w]);
+        }
+    }
+}
+
+/**
+ * @brief Processes many windows of equal size stored back to back.
+ *
+ * @param[in,out] pool    The pool.
+ * @param[in]     ctx     The context copied into each worker context.
+ * @param[in]     samples Pointer to count * num samples.
+ * @param[in]     num     The number of samples per window.
+ * @param[in]     count   The number of windows.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false if any window failed.
+ */
+bool glbs_pool_process(glbs_pool_t *pool, const glbs_ctx_t *ctx, const float *samples, size_t num, size_t count,
+                       float *results)
+{
+    glbs_pool_job_t job = {samples, NULL, num, results, false};
+
+    return glbs_pool_run(pool, ctx, count, 0, glbs_pool_windows_packed, &job) && !job.failed;
+}
+
+/**
+ * @brief Processes many windows given by descriptors.
+ *
+ * @param[in,out] pool    The pool.
+ * @param[in]     ctx     The context copied into each worker context.
+ * @param[in]     windows Pointer to count window descriptors.
+ * @param[in]     count   The number of windows.
+ * @param[out]    results Pointer to count floats receiving the averages.
+ *
+ * @return bool Returns true on success, false if any window failed.
+ */
+bool glbs_pool_process_windows(glbs_pool_t *pool, const glbs_ctx_t *ctx, const glbs_window_t *windows, size_t count,
+                               float *results)
+{
+    glbs_pool_job_t job = {NULL, windows, 0, results, false};
+
+    return glbs_pool_run(pool, ctx, count, 0, glbs_pool_windows_desc, &job) && !job.failed;
+}
+
+/**
+ * @brief Running sums of one part of a large window.
+ */
+typedef struct glbs_pool_part_s {
+    float  median;      /**< Median of the part, found by the first pass. */
+    double sum;         /**< Sum of (value - ref). */
+    double sum_sq;      /**< Sum of (value - ref)^2. */
+    double sum_err;     /**< Rounding error of sum not yet folded into it. */
+    double sum_sq_err;  /**< Rounding error of sum_sq not yet folded into it. */
+    double sum_sq_peak; /**< Largest sum_sq_err reached, or sum_sq for plain sums. */
+} glbs_pool_part_t;
+
+/**
+ * @brief Arguments of the large-window callbacks.
+ */
+typedef struct glbs_pool_large_s {
+    const float      *samples; /**< The input window. */
+    float            *data;    /**< Working copy of the window. */
+    size_t            part;    /**< Samples per part. */
+    double            ref;     /**< Reference value of the second pass. */
+    size_t            ends;    /**< Ends ordered per part. */
+    glbs_pool_part_t *parts;   /**< Sums of each part. */
+} glbs_pool_large_t;
+
+/**
+ * @brief Orders the ends of a part, which also moves its median to the middle.
+ */
+static void glbs_pool_large_order(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    glbs_pool_large_t *job = arg;
+
+    ctx->max_outliers = job->ends;
+    glbs_order(ctx, job->data + begin, end - begin);
+}
+
+/**
+ * @brief First pass over a part: copies it, orders its ends and notes its median.
+ */
+static void glbs_pool_large_copy(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    glbs_pool_large_t *job = arg;
+
+    memcpy(job->data + begin, job->samples + begin, (end - begin) * sizeof(float));
+    glbs_pool_large_order(ctx, arg, begin, end);
+    job->parts[begin / job->part].median = job->data[begin + (end - begin) / 2];
+}
+
+/**
+ * @brief Second pass over a part: sums about the reference.
+ *
+ * A part holding a far glitch is summed with its rounding error carried, as
+ * glbs_ctx_process() does for such a window; the others use the kernels.
+ */
+static void glbs_pool_large_sum(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    glbs_pool_large_t    *job     = arg;
+    glbs_pool_part_t     *part    = &job->parts[begin / job->part];
+    const glbs_kernels_t *kernels = glbs_kernels();
+    glbs_trim_t           trim    = {0};
+
+    (void)ctx;
+    if (!glbs_trim_wild(job->data + begin, end - begin, 1)) {
+        part->sum         = kernels->sum(job->data + begin, NULL, end - begin, job->ref);
+        part->sum_sq      = kernels->sum_sq(job->data + begin, NULL, end - begin, job->ref);
+        part->sum_err     = 0.0;
+        part->sum_sq_err  = 0.0;
+        part->sum_sq_peak = part->sum_sq;
+        return;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        glbs_trim_add(&trim, job->data[i] - job->ref);
+    }
+    part->sum         = trim.sum;
+    part->sum_sq      = trim.sum_sq;
+    part->sum_err     = trim.sum_err;
+    part->sum_sq_err  = trim.sum_sq_err;
+    part->sum_sq_peak = trim.sum_sq_peak;
+}
+
+/**
+ * @brief Merges the sums of the parts pairwise, leaving the total in parts[0].
+ *
+ * A tree keeps the rounding error growing with log(count) rather than count,
+ * and the error of each addition is carried, so that the sums of a part with
+ * a far glitch do not swamp the others. The peak of the carried error is kept
+ * as glbs_trim_add() keeps it.
+ */
+static void glbs_pool_large_merge(glbs_pool_part_t *parts, size_t count)
+{
+    double err = 0.0;
+
+    for (size_t step = 1; step < count; step *= 2) {
+        for (size_t i = 0; i + step < count; i += 2 * step) {
+            glbs_sum_add(&parts[i].sum, &parts[i].sum_err, parts[i + step].sum);
+            glbs_sum_add(&parts[i].sum_sq, &parts[i].sum_sq_err, parts[i + step].sum_sq);
+            parts[i].sum_err += parts[i + step].sum_err;
+            parts[i].sum_sq_err += parts[i + step].sum_sq_err;
+
+            err = (parts[i].sum_sq_err < 0.0) ? -parts[i].sum_sq_err : parts[i].sum_sq_err;
+            err = (err > parts[i + step].sum_sq_peak) ? err : parts[i + step].sum_sq_peak;
+            parts[i].sum_sq_peak = (err > parts[i].sum_sq_peak) ? err : parts[i].sum_sq_peak;
+        }
+    }
+    glbs_sum_fold(&parts[0].sum, &parts[0].sum_err);
+    glbs_sum_fold(&parts[0].sum_sq, &parts[0].sum_sq_err);
+}
+
+/**
+ * @brief Gathers the ordered ends of every part into sorted candidate arrays.
+ *
+ * A sample below the k-th smallest value t_p of every part p that holds more
+ * than k samples is among the k smallest of its own part, so all candidates
+ * below T = min(t_p) are present and the first one equal to T is in its global
+ * rank too. This usually covers far more than k global ends; the same holds
+ * mirrored for the largest values.
+ *
+ * @param[in]  job      The large-window job after the second pass.
+ * @param[in]  num      The number of samples.
+ * @param[in]  count    The number of parts.
+ * @param[out] lows     Receives the smallest ends of the parts, ascending.
+ * @param[out] highs    Receives the largest ends of the parts, ascending.
+ * @param[out] lo_ends  Receives the number of leading lows in global rank.
+ * @param[out] hi_ends  Receives the number of trailing highs in global rank.
+ *
+ * @return size_t The number of candidates at each end.
+ */
+static size_t glbs_pool_large_gather(const glbs_pool_large_t *job, size_t num, size_t count, float *lows,
+                                     float *highs, size_t *lo_ends, size_t *hi_ends)
+{
+    glbs_ctx_t sort   = {0};
+    size_t     taken  = 0;
+    size_t     begin  = 0;
+    size_t     len    = 0;
+    size_t     ends   = 0;
+    size_t     lo     = 0;
+    size_t     hi     = 0;
+    bool       bound  = false;
+    float      lo_max = 0.0f;
+    float      hi_min = 0.0f;
+
+    for (size_t p = 0; p < count; p++) {
+        begin = p * job->part;
+        len   = (begin + job->part < num) ? job->part : num - begin;
+        ends  = (job->ends < len) ? job->ends : len;
+        memcpy(lows + taken, job->data + begin, ends * sizeof(float));
+        memcpy(highs + taken, job->data + begin + len - ends, ends * sizeof(float));
+        taken += ends;
+        if (ends < len) {
+            lo_max = (!bound || job->data[begin + ends - 1] < lo_max) ? job->data[begin + ends - 1] : lo_max;
+            hi_min = (!bound || job->data[begin + len - ends] > hi_min) ? job->data[begin + len - ends] : hi_min;
+            bound  = true;
+        }
+    }
+
+    glbs_ctx_init(&sort, GPN_80);
+    glbs_order(&sort, lows, taken);
+    glbs_order(&sort, highs, taken);
+
+    if (!bound) {
+        *lo_ends = taken;
+        *hi_ends = taken;
+        return taken;
+    }
+
+    while (lo < taken && lows[lo] < lo_max) {
+        lo++;
+    }
+    while (hi < taken && highs[taken - 1 - hi] > hi_min) {
+        hi++;
+    }
+    *lo_ends = (lo < taken) ? lo + 1 : taken;
+    *hi_ends = (hi < taken) ? hi + 1 : taken;
+    return taken;
+}
+
+/**
+ * @brief Removes outliers from one large window with every worker of the pool.
+ *
+ * @param[in,out] pool    The pool.
+ * @param[in]     ctx     The context.
+ * @param[in]     samples Pointer to the input array of sample data.
+ * @param[in]     num     The number of samples.
+ * @param[out]    result  Pointer receiving the average of the valid samples.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_pool_process_large(glbs_pool_t *pool, const glbs_ctx_t *ctx, const float *samples, size_t num,
+                             float *result)
+{
+    glbs_ctx_t        local   = *ctx;
+    glbs_ctx_t        sort    = {0};
+    glbs_pool_large_t job     = {samples, NULL, 0, 0.0, 0, NULL};
+    glbs_trim_t       trim    = {0};
+    float            *lows    = NULL;
+    float            *highs   = NULL;
+    size_t            count   = 0;
+    size_t            taken   = 0;
+    size_t            lo_ends = 0;
+    size_t            hi_ends = 0;
+    bool              heap    = false;
+    bool              done    = false;
+    bool              counted = false;
+    bool              first   = true;
+    GLBS_TRACE_BEGIN(start);
+
+    if (pool == NULL || num < GLBS_POOL_LARGE_MIN_NUM || num > UINT32_MAX) {
+        return glbs_ctx_process(&local, samples, num, result);
+    }
+
+    count    = pool->threads * GLBS_POOL_LARGE_PARTS;
+    job.part = (num - 1) / count + 1;
+    count    = (num - 1) / job.part + 1;
+    job.ends = (ctx->max_outliers > 0) ? ctx->max_outliers : GLBS_POOL_LARGE_ENDS;
+
+    // Start well below the fallback bound, so that small parts still get a retry.
+    job.ends = (job.ends < job.part / 32) ? job.ends : job.part / 32;
+    job.ends = (job.ends > 0) ? job.ends : 1;
+
+    if (ctx->scratch != NULL && ctx->scratch_size >= num * sizeof(float)) {
+        job.data = ctx->scratch;
+    } else {
+        job.data = malloc(num * sizeof(float));
+        heap     = true;
+    }
+    job.parts = malloc(count * sizeof(glbs_pool_part_t));
+    lows      = malloc(2 * count * job.ends * sizeof(float));
+    if (job.data == NULL || job.parts == NULL || lows == NULL) {
+        goto out;
+    }
+
+    // The first pass orders the ends of each part and finds its median. The
+    // median of those medians is the reference, which a glitch cannot pull
+    // away from the data the way it pulls the mean.
+    glbs_pool_run(pool, ctx, num, job.part, glbs_pool_large_copy, &job);
+    for (size_t p = 0; p < count; p++) {
+        lows[p] = job.parts[p].median;
+    }
+    glbs_ctx_init(&sort, GPN_80);
+    glbs_order(&sort, lows, count);
+    job.ref = lows[count / 2];
+
+    glbs_pool_run(pool, ctx, num, job.part, glbs_pool_large_sum, &job);
+    glbs_pool_large_merge(job.parts, count);
+
+    // The extremes of the window are among the ordered ends of the parts. If
+    // the removal runs past the candidates known to be in global rank, the
+    // parts are reordered with four times as many ends and the trim restarts.
+    // Should the drops leave the sums lossy, the kept range is spread over
+    // every part, so the window is left to glbs_ctx_process() to sum again.
+    while (!done) {
+        if (job.ends >= job.part / 8 || glbs_trim_lossy(&trim)) {
+            free(lows);
+            lows    = NULL;
+            done    = glbs_ctx_process(&local, samples, num, result);
+            counted = true;
+            goto out;
+        }
+        if (!first) {
+            free(lows);
+            lows = malloc(2 * count * job.ends * sizeof(float));
+            if (lows == NULL) {
+                goto out;
+            }
+            glbs_pool_run(pool, ctx, num, job.part, glbs_pool_large_order, &job);
+        }
+        first = false;
+        highs = lows + count * job.ends;
+        taken = glbs_pool_large_gather(&job, num, count, lows, highs, &lo_ends, &hi_ends);
+
+        trim.lo          = 0;
+        trim.hi          = num - 1;
+        trim.ref         = job.ref;
+        trim.sum         = job.parts[0].sum;
+        trim.sum_sq      = job.parts[0].sum_sq;
+        trim.sum_err     = job.parts[0].sum_err;
+        trim.sum_sq_err  = job.parts[0].sum_sq_err;
+        trim.sum_sq_peak = job.parts[0].sum_sq_peak;
+        while (trim.lo < lo_ends && num - 1 - trim.hi < hi_ends) {
+            if (!glbs_trim_step(&trim, ctx, lows[trim.lo], highs[taken - num + trim.hi])) {
+                done = true;
+                break;
+            }
+            if (glbs_trim_lossy(&trim)) {
+                break;
+            }
+        }
+        job.ends *= 4;
+    }
+    *result = glbs_trim_mean(&trim);
+
+out:
+    free(lows);
+    free(job.parts);
+    if (heap) {
+        free(job.data);
+    }
+    // The fallback to glbs_ctx_process() counts and times the call itself.
+    if (!counted) {
+        GLBS_COUNT(calls, 1);
+        if (done) {
+            GLBS_COUNT(samples, num);
+            GLBS_TRACE_END(start);
+        } else {
+            GLBS_TRACE_REJECT(start);
+        }
+    }
+    return done;
+}
+
+#endif /* GLBS_THREADS */
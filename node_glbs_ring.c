@@ -0,0 +1,295 @@
+/**
+ * @file glbs_ring.c
+ * @author wdfk-prog
+ * @brief Lock-free single-producer/single-consumer rings and a Grubbs' consumer loop.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include "glbs.h"
+
+/**
+ * @brief Hints the CPU that the caller is spinning.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define GLBS_RING_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define GLBS_RING_PAUSE() __asm__ __volatile__("yield")
+#else
+#define GLBS_RING_PAUSE() ((void)0)
+#endif
+
+/**
+ * @brief Initializes an empty ring.
+ *
+ * @param[out] ring     The ring.
+ * @param[in]  buffer   Caller-owned memory of GLBS_RING_BUFFER_SIZE(capacity, item) bytes.
+ * @param[in]  capacity The number of items, a power of two.
+ * @param[in]  item     The size of an item in bytes.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_ring_init(glbs_ring_t *ring, void *buffer, size_t capacity, size_t item)
+{
+    if (ring == NULL || buffer == NULL || item == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->shared.buffer = buffer;
+    ring->shared.mask   = capacity - 1;
+    ring->shared.item   = item;
+    return true;
+}
+
+/**
+ * @brief Copies count items between the ring storage at index and a flat array.
+ *
+ * @param[in]     ring  The ring.
+ * @param[in]     index The free-running index of the first item.
+ * @param[in,out] items The flat array.
+ * @param[in]     count The number of items, at most the capacity.
+ * @param[in]     store Whether to copy into the ring rather than out of it.
+ */
+static void glbs_ring_copy(const glbs_ring_t *ring, size_t index, void *items, size_t count, bool store)
+{
+    unsigned char *slot  = (unsigned char *)ring->shared.buffer + (index & ring->shared.mask) * ring->shared.item;
+    size_t         first = ring->shared.mask + 1 - (index & ring->shared.mask);
+    size_t         item  = ring->shared.item;
+
+    // At most two runs: up to the end of the storage, then from its start.
+    first = (count < first) ? count : first;
+    if (store) {
+        memcpy(slot, items, first * item);
+        memcpy(ring->shared.buffer, (unsigned char *)items + first * item, (count - first) * item);
+    } else {
+        memcpy(items, slot, first * item);
+        memcpy((unsigned char *)items + first * item, ring->shared.buffer, (count - first) * item);
+    }
+}
+
+/**
+ * @brief Returns the free slots of a ring. Producer side only.
+ *
+ * The consumer's index is read again only when the cached copy shows fewer
+ * than wanted free slots, so a producer that stays ahead does not touch the
+ * consumer's cache line.
+ *
+ * @param[in,out] ring   The ring.
+ * @param[in]     wanted The number of slots needed.
+ *
+ * @return size_t The number of free slots.
+ */
+static size_t glbs_ring_space(glbs_ring_t *ring, size_t wanted)
+{
+    size_t capacity = ring->shared.mask + 1;
+
+    if (capacity - (ring->producer.index - ring->producer.cache) < wanted) {
+        ring->producer.cache = __atomic_load_n(&ring->consumer.index, __ATOMIC_ACQUIRE);
+    }
+    return capacity - (ring->producer.index - ring->producer.cache);
+}
+
+/**
+ * @brief Returns the items a ring holds. Consumer side only.
+ *
+ * The mirror of glbs_ring_space(): the producer's index is read again only
+ * when the cached copy shows fewer than wanted items.
+ *
+ * @param[in,out] ring   The ring.
+ * @param[in]     wanted The number of items needed.
+ *
+ * @return size_t The number of items that can be read.
+ */
+static size_t glbs_ring_avail(glbs_ring_t *ring, size_t wanted)
+{
+    if (ring->consumer.cache - ring->consumer.index < wanted) {
+        ring->consumer.cache = __atomic_load_n(&ring->producer.index, __ATOMIC_ACQUIRE);
+    }
+    return ring->consumer.cache - ring->consumer.index;
+}
+
+/**
+ * @brief Appends items to a ring. Producer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[in]     items The items.
+ * @param[in]     count The number of items.
+ *
+ * @return size_t The number of items appended, less than count if the ring filled up.
+ */
+size_t glbs_ring_write(glbs_ring_t *ring, const void *items, size_t count)
+{
+    size_t head  = ring->producer.index;
+    size_t space = glbs_ring_space(ring, count);
+
+    count = (count < space) ? count : space;
+    if (count == 0) {
+        return 0;
+    }
+
+    glbs_ring_copy(ring, head, (void *)items, count, true);
+    __atomic_store_n(&ring->producer.index, head + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+/**
+ * @brief Returns the number of items a ring holds. Consumer side only.
+ *
+ * @param[in,out] ring The ring.
+ *
+ * @return size_t The number of items that can be read.
+ */
+size_t glbs_ring_count(glbs_ring_t *ring)
+{
+    return glbs_ring_avail(ring, SIZE_MAX);
+}
+
+/**
+ * @brief Copies the oldest items of a ring without removing them. Consumer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[out]    items Receives the items.
+ * @param[in]     count The number of items wanted.
+ *
+ * @return size_t The number of items copied, less than count if the ring held fewer.
+ */
+size_t glbs_ring_peek(glbs_ring_t *ring, void *items, size_t count)
+{
+    size_t avail = glbs_ring_avail(ring, count);
+
+    count = (count < avail) ? count : avail;
+    glbs_ring_copy(ring, ring->consumer.index, items, count, false);
+    return count;
+}
+
+/**
+ * @brief Drops the oldest items of a ring without copying them. Consumer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[in]     count The number of items to remove.
+ *
+ * @return size_t The number of items removed, less than count if the ring held fewer.
+ */
+size_t glbs_ring_discard(glbs_ring_t *ring, size_t count)
+{
+    size_t avail = glbs_ring_avail(ring, count);
+
+    count = (count < avail) ? count : avail;
+    __atomic_store_n(&ring->consumer.index, ring->consumer.index + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+/**
+ * @brief Removes the oldest items of a ring. Consumer side only.
+ *
+ * @param[in,out] ring  The ring.
+ * @param[out]    items Receives the items.
+ * @param[in]     count The number of items wanted.
+ *
+ * @return size_t The number of items read, less than count if the ring held fewer.
+ */
+size_t glbs_ring_read(glbs_ring_t *ring, void *items, size_t count)
+{
+    count = glbs_ring_peek(ring, items, count);
+    __atomic_store_n(&ring->consumer.index, ring->consumer.index + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+/**
+ * @brief Initializes a consumer that cuts windows from a sample ring.
+ *
+ * @param[out] consumer The consumer.
+ * @param[in]  ctx      The context supplying the critical values.
+ * @param[in]  samples  Ring of float samples; the consumer is its consumer side.
+ * @param[in]  results  Ring of glbs_ring_result_t; the consumer is its producer side.
+ * @param[in]  window   Caller-owned array of num floats.
+ * @param[in]  num      The number of samples per window.
+ * @param[in]  step     The number of samples between window starts.
+ *
+ * @return bool Returns true on success, false if the parameters are invalid.
+ */
+bool glbs_consumer_init(glbs_consumer_t *consumer, const glbs_ctx_t *ctx, glbs_ring_t *samples,
+                        glbs_ring_t *results, float *window, size_t num, size_t step)
+{
+    if (consumer == NULL || ctx == NULL || samples == NULL || results == NULL || window == NULL ||
+        num < MIN_SAMPLE_NUM || step == 0 || samples->shared.item != sizeof(float) ||
+        results->shared.item != sizeof(glbs_ring_result_t) || samples->shared.mask + 1 < num) {
+        return false;
+    }
+
+    consumer->ctx     = ctx;
+    consumer->samples = samples;
+    consumer->results = results;
+    consumer->window  = window;
+    consumer->num     = num;
+    consumer->step    = step;
+    consumer->skip    = 0;
+    consumer->count   = 0;
+    return true;
+}
+
+/**
+ * @brief Processes every window the sample ring holds, as far as results fit.
+ *
+ * @param[in,out] consumer The consumer.
+ *
+ * @return size_t The number of windows processed.
+ */
+size_t glbs_consumer_poll(glbs_consumer_t *consumer)
+{
+    glbs_ring_result_t result = {0, 0.0f};
+    size_t             done   = 0;
+
+    while (1) {
+        // Gap samples between windows with a step above num.
+        consumer->skip -= glbs_ring_discard(consumer->samples, consumer->skip);
+        if (consumer->skip > 0) {
+            break;
+        }
+
+        // Stop while the result ring is full: the samples stay queued, so no
+        // window is lost, and the producer sees the ring fill up instead.
+        if (glbs_ring_space(consumer->results, 1) == 0 ||
+            glbs_ring_peek(consumer->samples, consumer->window, consumer->num) < consumer->num) {
+            break;
+        }
+
+        // The window is already a private copy, so the in-place engine can
+        // reorder it and needs neither scratch nor heap for any size.
+        result.window = consumer->count++;
+        glbs_ctx_process_inplace(consumer->ctx, consumer->window, consumer->num, &result.mean);
+        glbs_ring_write(consumer->results, &result, 1);
+
+        if (consumer->step < consumer->num) {
+            glbs_ring_discard(consumer->samples, consumer->step);
+        } else {
+            glbs_ring_discard(consumer->samples, consumer->num);
+            consumer->skip = consumer->step - consumer->num;
+        }
+        done++;
+    }
+    return done;
+}
+
+/**
+ * @brief Runs a consumer until stop is set, spinning while there is no work.
+ *
+ * @param[in,out] consumer The consumer.
+ * @param[in]     stop     Flag set by another thread to end the loop.
+ */
+void glbs_consumer_run(glbs_consumer_t *consumer, const bool *stop)
+{
+    while (!__atomic_load_n(stop, __ATOMIC_ACQUIRE)) {
+        if (glbs_consumer_poll(consumer) == 0) {
+            GLBS_RING_PAUSE();
+        }
+    }
+    // Windows complete when the stop is seen are still processed, as far as
+    // the result ring has room.
+    glbs_consumer_poll(consumer);
+}
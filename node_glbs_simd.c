@@ -0,0 +1,695 @@
+/**
+ * @file glbs_simd.c
+ * @author wdfk-prog
+ * @brief Vectorized reduction kernels for the Grubbs' test, with runtime dispatch.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <math.h>
+#include "glbs.h"
+
+/*
+ * x86 kernels are compiled per function with target attributes, so a single
+ * binary carries every instruction set and picks one at runtime. AArch64 always
+ * has Advanced SIMD. Define GLBS_NO_SIMD to build the scalar kernels only.
+ */
+#if !defined(GLBS_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GLBS_SIMD_X86 1
+#include <immintrin.h>
+#define GLBS_TARGET(isa) __attribute__((target(isa)))
+#elif !defined(GLBS_NO_SIMD) && defined(__aarch64__)
+#define GLBS_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief Extracts the validity bits of samples [i, i + width) from a packed mask.
+ *
+ * i must be a multiple of width, and width a power of two no larger than 32.
+ */
+#define GLBS_MASK_BITS(valid, i, width) (((valid)[(i) >> 5] >> ((i) & 31)) & ((1u << ((width) - 1) << 1) - 1u))
+
+/**
+ * @brief Tests the validity bit of sample i, true when no mask is given.
+ */
+#define GLBS_MASK_TEST(valid, i) ((valid) == NULL || (((valid)[(i) >> 5] >> ((i) & 31)) & 1u))
+
+/**
+ * @brief Scalar sum of (data[i] - center) over valid samples in [begin, num).
+ */
+static double glbs_sum_tail(const float *data, const uint32_t *valid, size_t begin, size_t num, double center)
+{
+    double sum = 0.0;
+
+    for (size_t i = begin; i < num; i++) {
+        if (GLBS_MASK_TEST(valid, i)) {
+            sum += (double)data[i] - center;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Scalar sum of (data[i] - center)^2 over valid samples in [begin, num).
+ */
+static double glbs_sum_sq_tail(const float *data, const uint32_t *valid, size_t begin, size_t num, double center)
+{
+    double sum   = 0.0;
+    double delta = 0.0;
+
+    for (size_t i = begin; i < num; i++) {
+        if (GLBS_MASK_TEST(valid, i)) {
+            delta = (double)data[i] - center;
+            sum += delta * delta;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Scalar search for the largest |data[i] - center| over valid samples in [begin, num).
+ *
+ * Continues from a running best so the vector kernels can finish their tails
+ * with it; strict comparison keeps the lowest index on ties.
+ */
+static size_t glbs_max_dev_tail(const float *data, const uint32_t *valid, size_t begin, size_t num, double center,
+                                size_t best, double *best_dev)
+{
+    double dev = 0.0;
+
+    for (size_t i = begin; i < num; i++) {
+        if (GLBS_MASK_TEST(valid, i)) {
+            dev = fabs((double)data[i] - center);
+            if (dev > *best_dev) {
+                *best_dev = dev;
+                best      = i;
+            }
+        }
+    }
+    return best;
+}
+
+static double glbs_sum_scalar(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    return glbs_sum_tail(data, valid, 0, num, center);
+}
+
+static double glbs_sum_sq_scalar(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    return glbs_sum_sq_tail(data, valid, 0, num, center);
+}
+
+static size_t glbs_max_dev_scalar(const float *data, const uint32_t *valid, size_t num, double center,
+                                  double *deviation)
+{
+    double best_dev = -1.0;
+    size_t best     = glbs_max_dev_tail(data, valid, 0, num, center, num, &best_dev);
+
+    if (deviation != NULL) {
+        *deviation = (best < num) ? best_dev : 0.0;
+    }
+    return best;
+}
+
+#if defined(GLBS_SIMD_X86) || defined(GLBS_SIMD_NEON)
+/**
+ * @brief Merges per-lane maxima into the overall maximum, lowest index on ties.
+ *
+ * @param[in]     dev      Per-lane largest deviations.
+ * @param[in]     idx      Per-lane indices of those deviations.
+ * @param[in]     lanes    The number of lanes.
+ * @param[in,out] best_dev The running largest deviation.
+ *
+ * @return size_t The index of the largest deviation, or SIZE_MAX if none.
+ */
+static size_t glbs_max_dev_merge(const double *dev, const double *idx, size_t lanes, double *best_dev)
+{
+    size_t best = SIZE_MAX;
+
+    for (size_t l = 0; l < lanes; l++) {
+        if (dev[l] > *best_dev || (dev[l] == *best_dev && dev[l] >= 0.0 && (size_t)idx[l] < best)) {
+            *best_dev = dev[l];
+            best      = (size_t)idx[l];
+        }
+    }
+    return best;
+}
+#endif
+
+#if defined(GLBS_SIMD_X86)
+
+/**
+ * @brief Builds a two-lane double mask from two validity bits.
+ */
+GLBS_TARGET("sse2")
+static __m128d glbs_mask_sse2(unsigned bits)
+{
+    return _mm_castsi128_pd(_mm_set_epi64x(-(long long)((bits >> 1) & 1u), -(long long)(bits & 1u)));
+}
+
+GLBS_TARGET("sse2")
+static double glbs_sum_sse2(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    __m128d c    = _mm_set1_pd(center);
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    double  lanes[2];
+    size_t  i = 0;
+
+    for (; i + 4 <= num; i += 4) {
+        __m128  x  = _mm_loadu_ps(data + i);
+        __m128d lo = _mm_sub_pd(_mm_cvtps_pd(x), c);
+        __m128d hi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), c);
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 4);
+            lo            = _mm_and_pd(lo, glbs_mask_sse2(bits));
+            hi            = _mm_and_pd(hi, glbs_mask_sse2(bits >> 2));
+        }
+        acc0 = _mm_add_pd(acc0, lo);
+        acc1 = _mm_add_pd(acc1, hi);
+    }
+
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + glbs_sum_tail(data, valid, i, num, center);
+}
+
+GLBS_TARGET("sse2")
+static double glbs_sum_sq_sse2(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    __m128d c    = _mm_set1_pd(center);
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    double  lanes[2];
+    size_t  i = 0;
+
+    for (; i + 4 <= num; i += 4) {
+        __m128  x  = _mm_loadu_ps(data + i);
+        __m128d lo = _mm_sub_pd(_mm_cvtps_pd(x), c);
+        __m128d hi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), c);
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 4);
+            lo            = _mm_and_pd(lo, glbs_mask_sse2(bits));
+            hi            = _mm_and_pd(hi, glbs_mask_sse2(bits >> 2));
+        }
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(lo, lo));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(hi, hi));
+    }
+
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + glbs_sum_sq_tail(data, valid, i, num, center);
+}
+
+GLBS_TARGET("sse2")
+static size_t glbs_max_dev_sse2(const float *data, const uint32_t *valid, size_t num, double center,
+                                double *deviation)
+{
+    const __m128d sign  = _mm_set1_pd(-0.0);
+    const __m128d none  = _mm_set1_pd(-1.0);
+    const __m128d step  = _mm_set1_pd(4.0);
+    __m128d       c     = _mm_set1_pd(center);
+    __m128d       idx0  = _mm_set_pd(1.0, 0.0);
+    __m128d       idx1  = _mm_set_pd(3.0, 2.0);
+    __m128d       best0 = none;
+    __m128d       best1 = none;
+    __m128d       bidx0 = _mm_setzero_pd();
+    __m128d       bidx1 = _mm_setzero_pd();
+    double        dev[4];
+    double        idx[4];
+    double        best_dev = -1.0;
+    size_t        best     = SIZE_MAX;
+    size_t        i        = 0;
+
+    for (; i + 4 <= num; i += 4) {
+        __m128  x  = _mm_loadu_ps(data + i);
+        __m128d lo = _mm_andnot_pd(sign, _mm_sub_pd(_mm_cvtps_pd(x), c));
+        __m128d hi = _mm_andnot_pd(sign, _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), c));
+        __m128d gt = _mm_setzero_pd();
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 4);
+            __m128d  m0   = glbs_mask_sse2(bits);
+            __m128d  m1   = glbs_mask_sse2(bits >> 2);
+            lo            = _mm_or_pd(_mm_and_pd(m0, lo), _mm_andnot_pd(m0, none));
+            hi            = _mm_or_pd(_mm_and_pd(m1, hi), _mm_andnot_pd(m1, none));
+        }
+        gt    = _mm_cmpgt_pd(lo, best0);
+        best0 = _mm_or_pd(_mm_and_pd(gt, lo), _mm_andnot_pd(gt, best0));
+        bidx0 = _mm_or_pd(_mm_and_pd(gt, idx0), _mm_andnot_pd(gt, bidx0));
+        gt    = _mm_cmpgt_pd(hi, best1);
+        best1 = _mm_or_pd(_mm_and_pd(gt, hi), _mm_andnot_pd(gt, best1));
+        bidx1 = _mm_or_pd(_mm_and_pd(gt, idx1), _mm_andnot_pd(gt, bidx1));
+        idx0  = _mm_add_pd(idx0, step);
+        idx1  = _mm_add_pd(idx1, step);
+    }
+
+    _mm_storeu_pd(dev, best0);
+    _mm_storeu_pd(dev + 2, best1);
+    _mm_storeu_pd(idx, bidx0);
+    _mm_storeu_pd(idx + 2, bidx1);
+    best = glbs_max_dev_merge(dev, idx, 4, &best_dev);
+    best = glbs_max_dev_tail(data, valid, i, num, center, (best == SIZE_MAX) ? num : best, &best_dev);
+
+    if (deviation != NULL) {
+        *deviation = (best < num) ? best_dev : 0.0;
+    }
+    return best;
+}
+
+/**
+ * @brief Builds a four-lane double mask from four validity bits.
+ */
+GLBS_TARGET("avx2")
+static __m256d glbs_mask_avx2(unsigned bits)
+{
+    const __m256i select = _mm256_set_epi64x(8, 4, 2, 1);
+    return _mm256_castsi256_pd(
+        _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), select), select));
+}
+
+GLBS_TARGET("avx2")
+static double glbs_sum_avx2(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    __m256d c    = _mm256_set1_pd(center);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    double  lanes[4];
+    size_t  i = 0;
+
+    for (; i + 8 <= num; i += 8) {
+        __m256  x  = _mm256_loadu_ps(data + i);
+        __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), c);
+        __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), c);
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 8);
+            lo            = _mm256_and_pd(lo, glbs_mask_avx2(bits));
+            hi            = _mm256_and_pd(hi, glbs_mask_avx2(bits >> 4));
+        }
+        acc0 = _mm256_add_pd(acc0, lo);
+        acc1 = _mm256_add_pd(acc1, hi);
+    }
+
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + glbs_sum_tail(data, valid, i, num, center);
+}
+
+GLBS_TARGET("avx2")
+static double glbs_sum_sq_avx2(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    __m256d c    = _mm256_set1_pd(center);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    double  lanes[4];
+    size_t  i = 0;
+
+    for (; i + 8 <= num; i += 8) {
+        __m256  x  = _mm256_loadu_ps(data + i);
+        __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), c);
+        __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), c);
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 8);
+            lo            = _mm256_and_pd(lo, glbs_mask_avx2(bits));
+            hi            = _mm256_and_pd(hi, glbs_mask_avx2(bits >> 4));
+        }
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(lo, lo));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(hi, hi));
+    }
+
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + glbs_sum_sq_tail(data, valid, i, num, center);
+}
+
+GLBS_TARGET("avx2")
+static size_t glbs_max_dev_avx2(const float *data, const uint32_t *valid, size_t num, double center,
+                                double *deviation)
+{
+    const __m256d sign  = _mm256_set1_pd(-0.0);
+    const __m256d none  = _mm256_set1_pd(-1.0);
+    const __m256d step  = _mm256_set1_pd(8.0);
+    __m256d       c     = _mm256_set1_pd(center);
+    __m256d       idx0  = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    __m256d       idx1  = _mm256_set_pd(7.0, 6.0, 5.0, 4.0);
+    __m256d       best0 = none;
+    __m256d       best1 = none;
+    __m256d       bidx0 = _mm256_setzero_pd();
+    __m256d       bidx1 = _mm256_setzero_pd();
+    double        dev[8];
+    double        idx[8];
+    double        best_dev = -1.0;
+    size_t        best     = SIZE_MAX;
+    size_t        i        = 0;
+
+    for (; i + 8 <= num; i += 8) {
+        __m256  x  = _mm256_loadu_ps(data + i);
+        __m256d lo = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), c));
+        __m256d hi = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), c));
+        __m256d gt = _mm256_setzero_pd();
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 8);
+            lo            = _mm256_blendv_pd(none, lo, glbs_mask_avx2(bits));
+            hi            = _mm256_blendv_pd(none, hi, glbs_mask_avx2(bits >> 4));
+        }
+        gt    = _mm256_cmp_pd(lo, best0, _CMP_GT_OQ);
+        best0 = _mm256_blendv_pd(best0, lo, gt);
+        bidx0 = _mm256_blendv_pd(bidx0, idx0, gt);
+        gt    = _mm256_cmp_pd(hi, best1, _CMP_GT_OQ);
+        best1 = _mm256_blendv_pd(best1, hi, gt);
+        bidx1 = _mm256_blendv_pd(bidx1, idx1, gt);
+        idx0  = _mm256_add_pd(idx0, step);
+        idx1  = _mm256_add_pd(idx1, step);
+    }
+
+    _mm256_storeu_pd(dev, best0);
+    _mm256_storeu_pd(dev + 4, best1);
+    _mm256_storeu_pd(idx, bidx0);
+    _mm256_storeu_pd(idx + 4, bidx1);
+    best = glbs_max_dev_merge(dev, idx, 8, &best_dev);
+    best = glbs_max_dev_tail(data, valid, i, num, center, (best == SIZE_MAX) ? num : best, &best_dev);
+
+    if (deviation != NULL) {
+        *deviation = (best < num) ? best_dev : 0.0;
+    }
+    return best;
+}
+
+GLBS_TARGET("avx512f")
+static double glbs_sum_avx512(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    __m512d c    = _mm512_set1_pd(center);
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    double  lanes[8];
+    size_t  i = 0;
+
+    for (; i + 16 <= num; i += 16) {
+        __m512d  lo   = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(data + i)), c);
+        __m512d  hi   = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(data + i + 8)), c);
+        unsigned bits = (valid != NULL) ? GLBS_MASK_BITS(valid, i, 16) : 0xFFFFu;
+        acc0          = _mm512_mask_add_pd(acc0, (__mmask8)bits, acc0, lo);
+        acc1          = _mm512_mask_add_pd(acc1, (__mmask8)(bits >> 8), acc1, hi);
+    }
+
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) +
+           glbs_sum_tail(data, valid, i, num, center);
+}
+
+GLBS_TARGET("avx512f")
+static double glbs_sum_sq_avx512(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    __m512d c    = _mm512_set1_pd(center);
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    double  lanes[8];
+    size_t  i = 0;
+
+    for (; i + 16 <= num; i += 16) {
+        __m512d  lo   = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(data + i)), c);
+        __m512d  hi   = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(data + i + 8)), c);
+        unsigned bits = (valid != NULL) ? GLBS_MASK_BITS(valid, i, 16) : 0xFFFFu;
+        acc0          = _mm512_mask_add_pd(acc0, (__mmask8)bits, acc0, _mm512_mul_pd(lo, lo));
+        acc1          = _mm512_mask_add_pd(acc1, (__mmask8)(bits >> 8), acc1, _mm512_mul_pd(hi, hi));
+    }
+
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) +
+           glbs_sum_sq_tail(data, valid, i, num, center);
+}
+
+GLBS_TARGET("avx512f")
+static size_t glbs_max_dev_avx512(const float *data, const uint32_t *valid, size_t num, double center,
+                                  double *deviation)
+{
+    const __m512d none  = _mm512_set1_pd(-1.0);
+    const __m512d step  = _mm512_set1_pd(16.0);
+    __m512d       c     = _mm512_set1_pd(center);
+    __m512d       idx0  = _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0);
+    __m512d       idx1  = _mm512_set_pd(15.0, 14.0, 13.0, 12.0, 11.0, 10.0, 9.0, 8.0);
+    __m512d       best0 = none;
+    __m512d       best1 = none;
+    __m512d       bidx0 = _mm512_setzero_pd();
+    __m512d       bidx1 = _mm512_setzero_pd();
+    double        dev[16];
+    double        idx[16];
+    double        best_dev = -1.0;
+    size_t        best     = SIZE_MAX;
+    size_t        i        = 0;
+
+    for (; i + 16 <= num; i += 16) {
+        __m512d   lo   = _mm512_abs_pd(_mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(data + i)), c));
+        __m512d   hi   = _mm512_abs_pd(_mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(data + i + 8)), c));
+        unsigned  bits = (valid != NULL) ? GLBS_MASK_BITS(valid, i, 16) : 0xFFFFu;
+        __mmask8  gt0  = _mm512_mask_cmp_pd_mask((__mmask8)bits, lo, best0, _CMP_GT_OQ);
+        __mmask8  gt1  = _mm512_mask_cmp_pd_mask((__mmask8)(bits >> 8), hi, best1, _CMP_GT_OQ);
+        best0          = _mm512_mask_blend_pd(gt0, best0, lo);
+        bidx0          = _mm512_mask_blend_pd(gt0, bidx0, idx0);
+        best1          = _mm512_mask_blend_pd(gt1, best1, hi);
+        bidx1          = _mm512_mask_blend_pd(gt1, bidx1, idx1);
+        idx0           = _mm512_add_pd(idx0, step);
+        idx1           = _mm512_add_pd(idx1, step);
+    }
+
+    _mm512_storeu_pd(dev, best0);
+    _mm512_storeu_pd(dev + 8, best1);
+    _mm512_storeu_pd(idx, bidx0);
+    _mm512_storeu_pd(idx + 8, bidx1);
+    best = glbs_max_dev_merge(dev, idx, 16, &best_dev);
+    best = glbs_max_dev_tail(data, valid, i, num, center, (best == SIZE_MAX) ? num : best, &best_dev);
+
+    if (deviation != NULL) {
+        *deviation = (best < num) ? best_dev : 0.0;
+    }
+    return best;
+}
+
+#endif /* GLBS_SIMD_X86 */
+
+#if defined(GLBS_SIMD_NEON)
+
+/**
+ * @brief Builds a two-lane double mask from two validity bits.
+ */
+static uint64x2_t glbs_mask_neon(unsigned bits)
+{
+    static const uint64_t select[2] = {1, 2};
+    return vtstq_u64(vdupq_n_u64(bits), vld1q_u64(select));
+}
+
+static double glbs_sum_neon(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    float64x2_t c    = vdupq_n_f64(center);
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    size_t      i    = 0;
+
+    for (; i + 4 <= num; i += 4) {
+        float32x4_t x  = vld1q_f32(data + i);
+        float64x2_t lo = vsubq_f64(vcvt_f64_f32(vget_low_f32(x)), c);
+        float64x2_t hi = vsubq_f64(vcvt_high_f64_f32(x), c);
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 4);
+            lo            = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(lo), glbs_mask_neon(bits)));
+            hi            = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(hi), glbs_mask_neon(bits >> 2)));
+        }
+        acc0 = vaddq_f64(acc0, lo);
+        acc1 = vaddq_f64(acc1, hi);
+    }
+
+    return vaddvq_f64(vaddq_f64(acc0, acc1)) + glbs_sum_tail(data, valid, i, num, center);
+}
+
+static double glbs_sum_sq_neon(const float *data, const uint32_t *valid, size_t num, double center)
+{
+    float64x2_t c    = vdupq_n_f64(center);
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    size_t      i    = 0;
+
+    for (; i + 4 <= num; i += 4) {
+        float32x4_t x  = vld1q_f32(data + i);
+        float64x2_t lo = vsubq_f64(vcvt_f64_f32(vget_low_f32(x)), c);
+        float64x2_t hi = vsubq_f64(vcvt_high_f64_f32(x), c);
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 4);
+            lo            = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(lo), glbs_mask_neon(bits)));
+            hi            = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(hi), glbs_mask_neon(bits >> 2)));
+        }
+        acc0 = vaddq_f64(acc0, vmulq_f64(lo, lo));
+        acc1 = vaddq_f64(acc1, vmulq_f64(hi, hi));
+    }
+
+    return vaddvq_f64(vaddq_f64(acc0, acc1)) + glbs_sum_sq_tail(data, valid, i, num, center);
+}
+
+static size_t glbs_max_dev_neon(const float *data, const uint32_t *valid, size_t num, double center,
+                                double *deviation)
+{
+    static const double start[4] = {0.0, 1.0, 2.0, 3.0};
+    const float64x2_t   none     = vdupq_n_f64(-1.0);
+    const float64x2_t   step     = vdupq_n_f64(4.0);
+    float64x2_t         c        = vdupq_n_f64(center);
+    float64x2_t         idx0     = vld1q_f64(start);
+    float64x2_t         idx1     = vld1q_f64(start + 2);
+    float64x2_t         best0    = none;
+    float64x2_t         best1    = none;
+    float64x2_t         bidx0    = vdupq_n_f64(0.0);
+    float64x2_t         bidx1    = vdupq_n_f64(0.0);
+    double              dev[4];
+    double              idx[4];
+    double              best_dev = -1.0;
+    size_t              best     = SIZE_MAX;
+    size_t              i        = 0;
+
+    for (; i + 4 <= num; i += 4) {
+        float32x4_t x  = vld1q_f32(data + i);
+        float64x2_t lo = vabsq_f64(vsubq_f64(vcvt_f64_f32(vget_low_f32(x)), c));
+        float64x2_t hi = vabsq_f64(vsubq_f64(vcvt_high_f64_f32(x), c));
+        uint64x2_t  gt;
+        if (valid != NULL) {
+            unsigned bits = GLBS_MASK_BITS(valid, i, 4);
+            lo            = vbslq_f64(glbs_mask_neon(bits), lo, none);
+            hi            = vbslq_f64(glbs_mask_neon(bits >> 2), hi, none);
+        }
+        gt    = vcgtq_f64(lo, best0);
+        best0 = vbslq_f64(gt, lo, best0);
+        bidx0 = vbslq_f64(gt, idx0, bidx0);
+        gt    = vcgtq_f64(hi, best1);
+        best1 = vbslq_f64(gt, hi, best1);
+        bidx1 = vbslq_f64(gt, idx1, bidx1);
+        idx0  = vaddq_f64(idx0, step);
+        idx1  = vaddq_f64(idx1, step);
+    }
+
+    vst1q_f64(dev, best0);
+    vst1q_f64(dev + 2, best1);
+    vst1q_f64(idx, bidx0);
+    vst1q_f64(idx + 2, bidx1);
+    best = glbs_max_dev_merge(dev, idx, 4, &best_dev);
+    best = glbs_max_dev_tail(data, valid, i, num, center, (best == SIZE_MAX) ? num : best, &best_dev);
+
+    if (deviation != NULL) {
+        *deviation = (best < num) ? best_dev : 0.0;
+    }
+    return best;
+}
+
+#endif /* GLBS_SIMD_NEON */
+
+static const glbs_kernels_t glbs_kernels_scalar = {
+    GLBS_ISA_SCALAR, "scalar", glbs_sum_scalar, glbs_sum_sq_scalar, glbs_max_dev_scalar,
+};
+
+#if defined(GLBS_SIMD_X86)
+static const glbs_kernels_t glbs_kernels_sse2 = {
+    GLBS_ISA_SSE2, "sse2", glbs_sum_sse2, glbs_sum_sq_sse2, glbs_max_dev_sse2,
+};
+
+static const glbs_kernels_t glbs_kernels_avx2 = {
+    GLBS_ISA_AVX2, "avx2", glbs_sum_avx2, glbs_sum_sq_avx2, glbs_max_dev_avx2,
+};
+
+static const glbs_kernels_t glbs_kernels_avx512 = {
+    GLBS_ISA_AVX512, "avx512", glbs_sum_avx512, glbs_sum_sq_avx512, glbs_max_dev_avx512,
+};
+#endif
+
+#if defined(GLBS_SIMD_NEON)
+static const glbs_kernels_t glbs_kernels_neon = {
+    GLBS_ISA_NEON, "neon", glbs_sum_neon, glbs_sum_sq_neon, glbs_max_dev_neon,
+};
+#endif
+
+/**
+ * @brief The kernel set returned by glbs_kernels(), NULL until the first call.
+ *
+ * Every thread that races on the first call stores the same pointer, and the
+ * accesses are atomic where the compiler offers it.
+ */
+static const glbs_kernels_t *s_kernels = NULL;
+
+#if defined(__GNUC__)
+#define GLBS_KERNELS_LOAD()   __atomic_load_n(&s_kernels, __ATOMIC_ACQUIRE)
+#define GLBS_KERNELS_STORE(k) __atomic_store_n(&s_kernels, (k), __ATOMIC_RELEASE)
+#else
+#define GLBS_KERNELS_LOAD()   (s_kernels)
+#define GLBS_KERNELS_STORE(k) (s_kernels = (k))
+#endif
+
+/**
+ * @brief Returns the kernels for a specific instruction set.
+ *
+ * @param[in] isa The instruction set.
+ *
+ * @return const glbs_kernels_t* The kernel set, or NULL if unavailable.
+ */
+const glbs_kernels_t *glbs_kernels_isa(glbs_isa_t isa)
+{
+#if defined(GLBS_SIMD_X86)
+    __builtin_cpu_init();
+#endif
+
+    switch (isa) {
+    case GLBS_ISA_SCALAR:
+        return &glbs_kernels_scalar;
+#if defined(GLBS_SIMD_X86)
+    case GLBS_ISA_SSE2:
+        return __builtin_cpu_supports("sse2") ? &glbs_kernels_sse2 : NULL;
+    case GLBS_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") ? &glbs_kernels_avx2 : NULL;
+    case GLBS_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") ? &glbs_kernels_avx512 : NULL;
+#endif
+#if defined(GLBS_SIMD_NEON)
+    case GLBS_ISA_NEON:
+        return &glbs_kernels_neon;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * @brief Returns the kernels for the best instruction set of the running CPU.
+ *
+ * @return const glbs_kernels_t* The selected kernel set, never NULL.
+ */
+const glbs_kernels_t *glbs_kernels(void)
+{
+    static const glbs_isa_t preference[] = {GLBS_ISA_AVX512, GLBS_ISA_AVX2, GLBS_ISA_NEON, GLBS_ISA_SSE2};
+    const glbs_kernels_t   *kernels      = GLBS_KERNELS_LOAD();
+
+    if (kernels != NULL) {
+        return kernels;
+    }
+
+    kernels = &glbs_kernels_scalar;
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        const glbs_kernels_t *candidate = glbs_kernels_isa(preference[i]);
+        if (candidate != NULL) {
+            kernels = candidate;
+            break;
+        }
+    }
+
+    GLBS_KERNELS_STORE(kernels);
+    return kernels;
+}
+
+/**
+ * @brief Overrides the kernel set returned by glbs_kernels().
+ *
+ * @param[in] isa The instruction set.
+ *
+ * @return bool Returns true on success, false if the set is unavailable.
+ */
+bool glbs_kernels_select(glbs_isa_t isa)
+{
+    const glbs_kernels_t *kernels = glbs_kernels_isa(isa);
+
+    if (kernels == NULL) {
+        return false;
+    }
+    GLBS_KERNELS_STORE(kernels);
+    return true;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file glbs_stream.c
+ * @author wdfk-prog
+ * @brief Sliding-window Grubbs' filter with O(log N) updates.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "glbs.h"
+#include "glbs_internal.h"
+
+/**
+ * @brief Null node index of the treap.
+ */
+#define GLBS_NIL UINT32_MAX
+
+/**
+ * @brief Returns the number of nodes in a subtree.
+ */
+static uint32_t glbs_node_size(const glbs_stream_node_t *nodes, uint32_t node)
+{
+    return (node == GLBS_NIL) ? 0 : nodes[node].size;
+}
+
+/**
+ * @brief Recomputes the subtree size of a node from its children.
+ */
+static void glbs_node_update(glbs_stream_node_t *nodes, uint32_t node)
+{
+    nodes[node].size = 1 + glbs_node_size(nodes, nodes[node].left) + glbs_node_size(nodes, nodes[node].right);
+}
+
+/**
+ * @brief Orders nodes by value, then by slot so that equal values stay distinct.
+ */
+static bool glbs_node_less(const glbs_stream_node_t *nodes, uint32_t a, uint32_t b)
+{
+    return nodes[a].value < nodes[b].value || (nodes[a].value == nodes[b].value && a < b);
+}
+
+/**
+ * @brief Splits a subtree into the nodes ordered before key and the rest.
+ *
+ * @param[in,out] nodes The node pool.
+ * @param[in]     node  The subtree root.
+ * @param[in]     key   The node to split at.
+ * @param[out]    left  Root of the nodes ordered before key.
+ * @param[out]    right Root of key and the nodes ordered after it.
+ */
+static void glbs_treap_split(glbs_stream_node_t *nodes, uint32_t node, uint32_t key, uint32_t *left,
+                             uint32_t *right)
+{
+    if (node == GLBS_NIL) {
+        *left  = GLBS_NIL;
+        *right = GLBS_NIL;
+        return;
+    }
+
+    if (glbs_node_less(nodes, node, key)) {
+        glbs_treap_split(nodes, nodes[node].right, key, &nodes[node].right, right);
+        *left = node;
+    } else {
+        glbs_treap_split(nodes, nodes[node].left, key, left, &nodes[node].left);
+        *right = node;
+    }
+    glbs_node_update(nodes, node);
+}
+
+/**
+ * @brief Joins two subtrees where every node of left orders before right.
+ *
+ * @return uint32_t The root of the joined tree.
+ */
+static uint32_t glbs_treap_merge(glbs_stream_node_t *nodes, uint32_t left, uint32_t right)
+{
+    if (left == GLBS_NIL) {
+        return right;
+    }
+    if (right == GLBS_NIL) {
+        return left;
+    }
+
+    if (nodes[left].priority > nodes[right].priority) {
+        nodes[left].right = glbs_treap_merge(nodes, nodes[left].right, right);
+        glbs_node_update(nodes, left);
+        return left;
+    }
+    nodes[right].left = glbs_treap_merge(nodes, left, nodes[right].left);
+    glbs_node_update(nodes, right);
+    return right;
+}
+
+/**
+ * @brief Removes the smallest node of a subtree.
+ *
+ * @return uint32_t The root of the remaining subtree.
+ */
+static uint32_t glbs_treap_pop_min(glbs_stream_node_t *nodes, uint32_t node)
+{
+    if (nodes[node].left == GLBS_NIL) {
+        return nodes[node].right;
+    }
+    nodes[node].left = glbs_treap_pop_min(nodes, nodes[node].left);
+    glbs_node_update(nodes, node);
+    return node;
+}
+
+/**
+ * @brief Returns the value of the given rank (0 = smallest) in the window.
+ */
+static float glbs_stream_select(const glbs_stream_t *stream, size_t rank)
+{
+    const glbs_stream_node_t *nodes = stream->nodes;
+    uint32_t                  node  = stream->root;
+
+    while (1) {
+        size_t left_size = glbs_node_size(nodes, nodes[node].left);
+        if (rank < left_size) {
+            node = nodes[node].left;
+        } else if (rank > left_size) {
+            rank -= left_size + 1;
+            node = nodes[node].right;
+        } else {
+            return nodes[node].value;
+        }
+    }
+}
+
+/**
+ * @brief Adds a deviation and its square to the running sums.
+ *
+ * @param[in,out] stream The stream.
+ * @param[in]     delta  The deviation from stream->ref, negated to remove it.
+ * @param[in]     square The square of the deviation, negated to remove it.
+ */
+static void glbs_stream_add(glbs_stream_t *stream, double delta, double square)
+{
+    double err = 0.0;
+
+    glbs_sum_add(&stream->sum, &stream->sum_err, delta);
+    glbs_sum_add(&stream->sum_sq, &stream->sum_sq_err, square);
+    err                 = (stream->sum_sq_err < 0.0) ? -stream->sum_sq_err : stream->sum_sq_err;
+    stream->sum_sq_peak = (err > stream->sum_sq_peak) ? err : stream->sum_sq_peak;
+    glbs_sum_fold(&stream->sum, &stream->sum_err);
+    glbs_sum_fold(&stream->sum_sq, &stream->sum_sq_err);
+}
+
+/**
+ * @brief Adds the deviations of the nodes ranked within [trim->lo, trim->hi].
+ *
+ * @param[in]     stream The stream.
+ * @param[in]     node   The subtree root.
+ * @param[in]     rank   The rank of the smallest node of the subtree.
+ * @param[in,out] trim   The trim state receiving the deviations.
+ */
+static void glbs_stream_sum_ranks(const glbs_stream_t *stream, uint32_t node, size_t rank, glbs_trim_t *trim)
+{
+    const glbs_stream_node_t *nodes     = stream->nodes;
+    size_t                    left_size = 0;
+
+    while (node != GLBS_NIL && rank <= trim->hi) {
+        left_size = glbs_node_size(nodes, nodes[node].left);
+        if (rank + left_size > trim->lo) {
+            glbs_stream_sum_ranks(stream, nodes[node].left, rank, trim);
+        }
+        rank += left_size;
+        if (rank >= trim->lo && rank <= trim->hi) {
+            glbs_trim_add(trim, nodes[node].value - trim->ref);
+        }
+        rank++;
+        node = nodes[node].right;
+    }
+}
+
+/**
+ * @brief Recomputes the running sums about the current median.
+ *
+ * Done once the first MIN_SAMPLE_NUM samples are in, so that a glitch among
+ * them does not stay the reference, and then once per window length of pushes,
+ * so that the reference follows a drifting signal. Also done once evictions
+ * leave the sums far below the rounding error they carried.
+ */
+static void glbs_stream_rebase(glbs_stream_t *stream)
+{
+    double delta = 0.0;
+
+    // While the window fills, the occupied slots are exactly [0, count).
+    stream->ref         = glbs_stream_select(stream, stream->count / 2);
+    stream->sum         = 0.0;
+    stream->sum_sq      = 0.0;
+    stream->sum_err     = 0.0;
+    stream->sum_sq_err  = 0.0;
+    stream->sum_sq_peak = 0.0;
+    for (size_t i = 0; i < stream->count; i++) {
+        delta = stream->nodes[i].value - stream->ref;
+        glbs_stream_add(stream, delta, delta * delta);
+    }
+    stream->rebase = stream->window;
+}
+
+/**
+ * @brief Initializes a sliding-window filter.
+ *
+ * @param[out] stream The stream to initialize.
+ * @param[in]  ctx    The context supplying the critical values.
+ * @param[in]  buffer Caller-owned memory of GLBS_STREAM_BUFFER_SIZE(window) bytes.
+ * @param[in]  window The window size N.
+ *
+ * @return bool Returns true on success, false on failure.
+ */
+bool glbs_stream_init(glbs_stream_t *stream, const glbs_ctx_t *ctx, void *buffer, size_t window)
+{
+    if (stream == NULL || ctx == NULL || buffer == NULL || window < MIN_SAMPLE_NUM || window >= GLBS_NIL) {
+        return false;
+    }
+
+    stream->ctx    = ctx;
+    stream->nodes  = buffer;
+    stream->window = window;
+    stream->seed   = 0x9E3779B9u;
+    glbs_stream_reset(stream);
+    return true;
+}
+
+/**
+ * @brief Empties the window of a stream.
+ *
+ * @param[in,out] stream The stream.
+ */
+void glbs_stream_reset(glbs_stream_t *stream)
+{
+    stream->count       = 0;
+    stream->head        = 0;
+    stream->rebase      = MIN_SAMPLE_NUM;
+    stream->root        = GLBS_NIL;
+    stream->ref         = 0.0;
+    stream->sum         = 0.0;
+    stream->sum_sq      = 0.0;
+    stream->sum_err     = 0.0;
+    stream->sum_sq_err  = 0.0;
+    stream->sum_sq_peak = 0.0;
+}
+
+/**
+ * @brief Pushes a sample into the window and returns the cleaned average.
+ *
+ * @param[in,out] stream The stream.
+ * @param[in]     sample The new sample.
+ * @param[out]    result Pointer to a float receiving the average.
+ *
+ * @return bool Returns true if a result was produced, false otherwise.
+ */
+bool glbs_stream_push(glbs_stream_t *stream, float sample, float *result)
+{
+    glbs_stream_node_t *nodes   = stream->nodes;
+    uint32_t            slot    = (uint32_t)stream->head;
+    uint32_t            left    = GLBS_NIL;
+    uint32_t            right   = GLBS_NIL;
+    glbs_trim_t         trim    = {0};
+    double              delta   = 0.0;
+    float               lo_val  = 0.0f;
+    float               hi_val  = 0.0f;
+    size_t              lo_rank = 0;
+
+    if (stream->count == stream->window) {
+        // Evict the oldest sample, which occupies the slot being reused.
+        delta = nodes[slot].value - stream->ref;
+        glbs_stream_add(stream, -delta, -(delta * delta));
+
+        glbs_treap_split(nodes, stream->root, slot, &left, &right);
+        stream->root = glbs_treap_merge(nodes, left, glbs_treap_pop_min(nodes, right));
+    } else {
+        if (stream->count == 0) {
+            stream->ref = sample;
+        }
+        stream->count++;
+    }
+
+    // Insert the new sample into its slot.
+    stream->seed ^= stream->seed << 13;
+    stream->seed ^= stream->seed >> 17;
+    stream->seed ^= stream->seed << 5;
+    nodes[slot].value    = sample;
+    nodes[slot].priority = stream->seed;
+    nodes[slot].left     = GLBS_NIL;
+    nodes[slot].right    = GLBS_NIL;
+    nodes[slot].size     = 1;
+    glbs_treap_split(nodes, stream->root, slot, &left, &right);
+    stream->root = glbs_treap_merge(nodes, glbs_treap_merge(nodes, left, slot), right);
+
+    delta = sample - stream->ref;
+    glbs_stream_add(stream, delta, delta * delta);
+
+    stream->head = (stream->head + 1 == stream->window) ? 0 : stream->head + 1;
+    // Evicting far glitches of different magnitudes can leave only rounding error.
+    if (--stream->rebase == 0 || stream->sum_sq_peak > GLBS_TRIM_LOSSY * stream->sum_sq) {
+        glbs_stream_rebase(stream);
+    }
+
+    if (stream->count < MIN_SAMPLE_NUM) {
+        return false;
+    }
+
+    // Test from the extremes, reading them by rank instead of sorting.
+    trim.lo          = 0;
+    trim.hi          = stream->count - 1;
+    trim.ref         = stream->ref;
+    trim.sum         = stream->sum;
+    trim.sum_sq      = stream->sum_sq;
+    trim.sum_err     = stream->sum_err;
+    trim.sum_sq_err  = stream->sum_sq_err;
+    trim.sum_sq_peak = stream->sum_sq_peak;
+    lo_val           = glbs_stream_select(stream, trim.lo);
+    hi_val           = glbs_stream_select(stream, trim.hi);
+    lo_rank          = trim.lo;
+    while (glbs_trim_step(&trim, stream->ctx, lo_val, hi_val)) {
+        // The window is not kept sorted, so the kept ranks are walked instead.
+        if (glbs_trim_lossy(&trim)) {
+            trim.ref         = glbs_stream_select(stream, trim.lo + (trim.hi - trim.lo) / 2);
+            trim.sum         = 0.0;
+            trim.sum_sq      = 0.0;
+            trim.sum_err     = 0.0;
+            trim.sum_sq_err  = 0.0;
+            trim.sum_sq_peak = 0.0;
+            glbs_stream_sum_ranks(stream, stream->root, 0, &trim);
+            glbs_sum_fold(&trim.sum, &trim.sum_err);
+            glbs_sum_fold(&trim.sum_sq, &trim.sum_sq_err);
+        }
+
+        // Only the end that was dropped needs a new lookup.
+        if (trim.lo != lo_rank) {
+            lo_rank = trim.lo;
+            lo_val  = glbs_stream_select(stream, trim.lo);
+        } else {
+            hi_val = glbs_stream_select(stream, trim.hi);
+        }
+    }
+
+    *result = glbs_trim_mean(&trim);
+    return true;
+}
@@ -0,0 +1,1426 @@
+/**
+ * @file glbs_test.c
+ * @author wdfk-prog
+ * @brief Checks every engine against a naive reference implementation.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * The reference recomputes the mean and standard deviation of the kept samples
+ * from scratch in double before every removal, O(n^2) per window, and takes its
+ * critical values from glbs_ctx_gcrit() or glbs_esd_lambda(). Random windows of
+ * many sizes and contaminations go through each engine, whose mean, kept set
+ * and removal order must match; some windows of the float engines also hold
+ * far glitches, 1e10 to 3e38 away. Windows where a statistic lies within 1e-4
+ * of its critical value, or where both ends are equally extreme, may legitimately
+ * be decided either way by float and double arithmetic and are skipped. The
+ * engines that share the sorted pipeline must agree with glbs_ctx_process() bit
+ * for bit. The sorting networks are checked on every zero-one input, and the
+ * SPSC ring runs with a producer and a consumer thread.
+ *
+ * Build, from a directory holding the library sources:
+ *
+ *     cc -O2 -DGLBS_THREADS -I. tests/glbs_test.c glbs.c glbs_simd.c glbs_stream.c glbs_fixed.c glbs_pool.c \
+ *        glbs_ring.c -lm -pthread -o glbs_test
+ *
+ * Add -DGLBS_INSTRUMENT and glbs_counters.c to also check that the counters
+ * reconcile. Without GLBS_THREADS the thread pool checks are skipped.
+ *
+ * Usage: glbs_test [-s seed] [-w windows]
+ *
+ * -w sets the number of random windows per engine, 1000 by default. Prints one
+ * line per check and exits with status 1 if any check failed.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "glbs.h"
+#include "glbs_network.h"
+
+/**
+ * @brief Largest window of the random checks; larger ones are checked separately.
+ */
+#define TEST_MAX_NUM 2048
+
+/**
+ * @brief Largest window of the thread pool check.
+ */
+#define TEST_LARGE_NUM 300000
+
+/**
+ * @brief Relative distance from a critical value below which a decision is marginal.
+ */
+#define TEST_MARGIN 1e-4
+
+/**
+ * @brief Tolerance of a mean, relative to the largest kept magnitude.
+ */
+#define TEST_MEAN_TOL 1e-5
+
+/**
+ * @brief Samples pushed through the SPSC ring per window layout.
+ */
+#define TEST_RING_SAMPLES 50000
+
+/**
+ * @brief Outcome of one reference run.
+ */
+typedef struct test_ref_s {
+    double mean;                  /**< Mean of the kept samples. */
+    size_t kept;                  /**< Number of kept samples. */
+    size_t removed;               /**< Number of removed samples. */
+    bool   marginal;              /**< Whether a decision was within rounding. */
+    bool   keep[TEST_LARGE_NUM];  /**< Whether each sample was kept. */
+    size_t order[TEST_LARGE_NUM]; /**< Indices of the removed samples in removal order. */
+} test_ref_t;
+
+/**
+ * @brief Failures, cases, marginal windows skipped and start time of the current check.
+ */
+static size_t  s_failed = 0;
+static size_t  s_cases  = 0;
+static size_t  s_skips  = 0;
+static clock_t s_start  = 0;
+
+/**
+ * @brief Total failures over all checks.
+ */
+static size_t s_total_failed = 0;
+
+/**
+ * @brief State of the random generator.
+ */
+static uint64_t s_seed = 1;
+
+/**
+ * @brief Records one case of the current check, printing the first few failures.
+ */
+#define TEST_EXPECT(cond, ...)                                                                                         \
+    do {                                                                                                               \
+        s_cases++;                                                                                                     \
+        if (!(cond)) {                                                                                                 \
+            if (s_failed++ < 5) {                                                                                      \
+                fprintf(stderr, "  %s:%d: ", __FILE__, __LINE__);                                                      \
+                fprintf(stderr, __VA_ARGS__);                                                                          \
+                fprintf(stderr, "\n");                                                                                 \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+/**
+ * @brief Starts a check.
+ */
+static void test_begin(void)
+{
+    s_failed = 0;
+    s_cases  = 0;
+    s_skips  = 0;
+    s_start  = clock();
+}
+
+/**
+ * @brief Ends a named check and prints its outcome.
+ */
+static void test_end(const char *name)
+{
+    printf("%-12s %s  %zu cases, %zu marginal skipped, %zu failed, %.2f s\n", name, (s_failed == 0) ? "ok  " : "FAIL",
+           s_cases, s_skips, s_failed, (double)(clock() - s_start) / CLOCKS_PER_SEC);
+    s_total_failed += s_failed;
+    fflush(stdout);
+}
+
+/**
+ * @brief Returns the next 64 random bits (splitmix64).
+ */
+static uint64_t test_next(void)
+{
+    uint64_t z = (s_seed += UINT64_C(0x9E3779B97F4A7C15));
+
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Returns a uniform double in [0, 1).
+ */
+static double test_uniform(void)
+{
+    return (double)(test_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Returns an integer in [0, bound).
+ */
+static size_t test_below(size_t bound)
+{
+    return (size_t)(test_next() % bound);
+}
+
+/**
+ * @brief Returns a standard normal sample (Box-Muller).
+ */
+static double test_normal(void)
+{
+    double u = 1.0 - test_uniform();
+
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * test_uniform());
+}
+
+/**
+ * @brief Fills a window with normal samples about center and a random contamination.
+ *
+ * Outliers are 4 to 60 sigma away, on both sides or on one side only, and
+ * make up between none and a quarter of the window.
+ */
+static void test_fill(double *x, size_t num, double center, double sigma)
+{
+    size_t outliers = test_below(num / 4 + 2);
+    bool   one_side = test_below(2) == 0;
+
+    for (size_t i = 0; i < num; i++) {
+        x[i] = center + sigma * test_normal();
+    }
+    for (size_t k = 0; k < outliers; k++) {
+        double side = (one_side || test_below(2) == 0) ? 1.0 : -1.0;
+        x[test_below(num)] = center + side * sigma * (4.0 + 56.0 * test_uniform());
+    }
+}
+
+/**
+ * @brief Fills a float window, see test_fill().
+ */
+static void test_fill_float(float *x, size_t num)
+{
+    double tmp[TEST_MAX_NUM];
+
+    test_fill(tmp, num, 100.0, 1.0);
+    for (size_t i = 0; i < num; i++) {
+        x[i] = (float)tmp[i];
+    }
+}
+
+/**
+ * @brief Plants one to three far glitches, 1e10 to 3e38 away, on one side or both.
+ *
+ * @param[in,out] x      The window.
+ * @param[in]     num    The number of samples.
+ * @param[in]     stride The distance between consecutive samples, in floats.
+ */
+static void test_far(float *x, size_t num, size_t stride)
+{
+    size_t glitches = 1 + test_below(3);
+    bool   one_side = test_below(2) == 0;
+    double side     = 0.0;
+
+    for (size_t k = 0; k < glitches; k++) {
+        side                        = (one_side || k % 2 == 0) ? 1.0 : -1.0;
+        x[test_below(num) * stride] = (float)(side * pow(10.0, 10.0 + 28.47 * test_uniform()));
+    }
+}
+
+/**
+ * @brief Picks a window size, mostly within the built-in table.
+ */
+static size_t test_num(size_t max)
+{
+    size_t num = 0;
+
+    switch (test_below(4)) {
+    case 0:
+    case 1:
+        num = MIN_SAMPLE_NUM + test_below(MAX_SAMPLE_NUM - MIN_SAMPLE_NUM + 1);
+        break;
+    case 2:
+        num = MAX_SAMPLE_NUM + 1 + test_below(200);
+        break;
+    default:
+        num = MIN_SAMPLE_NUM + test_below(TEST_MAX_NUM - MIN_SAMPLE_NUM + 1);
+        break;
+    }
+    return (num < max) ? num : max;
+}
+
+/**
+ * @brief Runs the iterative Grubbs' test naively.
+ *
+ * Before every step the mean and the standard deviation of the kept samples
+ * are recomputed from scratch, and the sample farthest from the mean is
+ * tested against crit(n), the lower value winning a tie as in the library.
+ *
+ * @param[in]  x    The samples.
+ * @param[in]  num  The number of samples.
+ * @param[in]  ctx  The context supplying G_p(n) through glbs_ctx_gcrit(), or NULL
+ *                  to use kn instead.
+ * @param[in]  kn   Scaled critical values K(n) = G^2 * n / (n - 1) in Q16, or NULL.
+ * @param[out] ref  The outcome.
+ */
+static void test_reference(const double *x, size_t num, const glbs_ctx_t *ctx, const uint32_t *kn, test_ref_t *ref)
+{
+    size_t n = num;
+
+    ref->removed  = 0;
+    ref->marginal = false;
+    for (size_t i = 0; i < num; i++) {
+        ref->keep[i] = true;
+    }
+
+    while (n >= MIN_SAMPLE_NUM) {
+        double mean   = 0.0;
+        double ss     = 0.0;
+        double lo_dev = -1.0;
+        double hi_dev = -1.0;
+        size_t lo     = 0;
+        size_t hi     = 0;
+        double crit   = 0.0;
+        double g      = 0.0;
+
+        for (size_t i = 0; i < num; i++) {
+            mean += ref->keep[i] ? x[i] : 0.0;
+        }
+        mean /= n;
+        for (size_t i = 0; i < num; i++) {
+            if (!ref->keep[i]) {
+                continue;
+            }
+            ss += (x[i] - mean) * (x[i] - mean);
+            if (mean - x[i] > lo_dev) {
+                lo_dev = mean - x[i];
+                lo     = i;
+            }
+            if (x[i] - mean > hi_dev) {
+                hi_dev = x[i] - mean;
+                hi     = i;
+            }
+        }
+        if (!(ss > 0.0)) {
+            break;
+        }
+
+        crit = (ctx != NULL) ? glbs_ctx_gcrit(ctx, n) : sqrt(kn[n] / 65536.0 * (n - 1) / n);
+        g    = ((hi_dev > lo_dev) ? hi_dev : lo_dev) / sqrt(ss / (n - 1));
+        if (fabs(g - crit) < TEST_MARGIN * crit || fabs(hi_dev - lo_dev) <= 1e-9 * (hi_dev + lo_dev)) {
+            ref->marginal = true;
+        }
+        if (!(g > crit)) {
+            break;
+        }
+
+        lo                         = (hi_dev > lo_dev) ? hi : lo;
+        ref->keep[lo]              = false;
+        ref->order[ref->removed++] = lo;
+        n--;
+    }
+
+    ref->kept = n;
+    ref->mean = 0.0;
+    for (size_t i = 0; i < num; i++) {
+        ref->mean += ref->keep[i] ? x[i] : 0.0;
+    }
+    ref->mean /= n;
+}
+
+/**
+ * @brief Returns the tolerance of a mean: TEST_MEAN_TOL times the largest kept magnitude.
+ */
+static double test_tol(const double *x, size_t num, const test_ref_t *ref)
+{
+    double max = 1.0;
+
+    for (size_t i = 0; i < num; i++) {
+        if (ref->keep[i] && fabs(x[i]) > max) {
+            max = fabs(x[i]);
+        }
+    }
+    return TEST_MEAN_TOL * max;
+}
+
+/**
+ * @brief Widens a float window for the reference.
+ */
+static void test_widen(double *wide, const float *x, size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        wide[i] = x[i];
+    }
+}
+
+/**
+ * @brief qsort() order of doubles.
+ */
+static int test_cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Compares a removal against the reference by value.
+ *
+ * Float windows may hold equal samples, of which either may go first, so the
+ * removed samples are compared by value: in order when the order is known,
+ * and as a multiset of the samples flagged as not kept otherwise.
+ *
+ * @param[in] x     The samples.
+ * @param[in] num   The number of samples.
+ * @param[in] keep  Whether each sample was kept, or NULL.
+ * @param[in] order Indices of the removed samples in removal order, or NULL.
+ * @param[in] ref   The reference outcome.
+ *
+ * @return bool Returns true if the same values were removed.
+ */
+static bool test_same_removed(const double *x, size_t num, const bool *keep, const size_t *order,
+                              const test_ref_t *ref)
+{
+    static double got[TEST_MAX_NUM];
+    static double want[TEST_MAX_NUM];
+    size_t        removed = 0;
+
+    for (size_t r = 0; order != NULL && r < ref->removed; r++) {
+        if (x[order[r]] != x[ref->order[r]]) {
+            return false;
+        }
+    }
+    if (keep == NULL) {
+        return true;
+    }
+    for (size_t i = 0; i < num; i++) {
+        if (!keep[i]) {
+            got[removed++] = x[i];
+        }
+    }
+    if (removed != ref->removed) {
+        return false;
+    }
+    for (size_t r = 0; r < removed; r++) {
+        want[r] = x[ref->order[r]];
+    }
+    qsort(got, removed, sizeof(double), test_cmp_double);
+    qsort(want, removed, sizeof(double), test_cmp_double);
+    return memcmp(got, want, removed * sizeof(double)) == 0;
+}
+
+/**
+ * @brief Critical values of the built-in table and of the Student-t quantile.
+ */
+static void test_gcrit(void)
+{
+    glbs_ctx_t         ctx;
+    glbs_gcrit_table_t table;
+    float              values[GLBS_GCRIT_TABLE_LEN(100)];
+
+    test_begin();
+    glbs_ctx_init(&ctx, GPN_95);
+    for (size_t n = MAX_SAMPLE_NUM + 1; n <= 2000; n += 7) {
+        // An uncached context uses the refined quantile, not Hill's approximation.
+        TEST_EXPECT(glbs_ctx_gcrit(&ctx, n) == (float)glbs_gcrit(n, 0.05), "n=%zu", n);
+        TEST_EXPECT(fabs(glbs_gcrit_fast(n, 0.05) / glbs_gcrit(n, 0.05) - 1.0) < 1e-8, "fast n=%zu", n);
+    }
+    for (size_t n = MIN_SAMPLE_NUM; n <= 20; n++) {
+        TEST_EXPECT(fabs(glbs_gcrit_fast(n, 0.1) / glbs_gcrit(n, 0.1) - 1.0) < 6.2e-6, "fast n=%zu", n);
+    }
+
+    // Student-t quantiles with closed forms: df = 1 and df = 2.
+    TEST_EXPECT(fabs(glbs_t_quantile(0.05, 1.0) - tan(3.141592653589793 * 0.45)) < 1e-9, "t df=1");
+    TEST_EXPECT(fabs(glbs_t_quantile(0.01, 2.0) - 0.98 / sqrt(2.0 * 0.01 * 0.99)) < 1e-9, "t df=2");
+
+    TEST_EXPECT(glbs_gcrit_table_init(&table, values, 100, 0.02), "table init");
+    glbs_ctx_set_alpha(&ctx, 0.02);
+    for (size_t n = MIN_SAMPLE_NUM; n <= 150; n++) {
+        TEST_EXPECT(glbs_gcrit_table_get(&table, n) == (float)glbs_gcrit(n, 0.02), "table n=%zu", n);
+        TEST_EXPECT(glbs_ctx_gcrit(&ctx, n) == (float)glbs_gcrit(n, 0.02), "ctx n=%zu", n);
+    }
+    test_end("gcrit");
+}
+
+/**
+ * @brief Compare-exchange of the sorting network check.
+ */
+#define TEST_NETWORK_CMPX(i, j)                                                                                        \
+    if (v[i] > v[j]) {                                                                                                 \
+        int t_ = v[i];                                                                                                 \
+        v[i]   = v[j];                                                                                                 \
+        v[j]   = t_;                                                                                                   \
+    }
+
+/**
+ * @brief Expands the network for n samples into a switch case.
+ */
+#define TEST_NETWORK_CASE(n)                                                                                           \
+    case n:                                                                                                            \
+        GLBS_NETWORK_##n(TEST_NETWORK_CMPX) break;
+
+/**
+ * @brief Runs the network for n samples on the zero-one input given by bits.
+ *
+ * By the zero-one principle a network that sorts all 2^n such inputs sorts
+ * every input.
+ *
+ * @return bool Returns true if the output is sorted.
+ */
+static bool test_network_sorts(size_t n, uint32_t bits)
+{
+    int v[MAX_SAMPLE_NUM];
+
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (int)((bits >> i) & 1u);
+    }
+    switch (n) {
+        TEST_NETWORK_CASE(2)
+        TEST_NETWORK_CASE(3)
+        TEST_NETWORK_CASE(4)
+        TEST_NETWORK_CASE(5)
+        TEST_NETWORK_CASE(6)
+        TEST_NETWORK_CASE(7)
+        TEST_NETWORK_CASE(8)
+        TEST_NETWORK_CASE(9)
+        TEST_NETWORK_CASE(10)
+        TEST_NETWORK_CASE(11)
+        TEST_NETWORK_CASE(12)
+        TEST_NETWORK_CASE(13)
+        TEST_NETWORK_CASE(14)
+        TEST_NETWORK_CASE(15)
+        TEST_NETWORK_CASE(16)
+        TEST_NETWORK_CASE(17)
+        TEST_NETWORK_CASE(18)
+        TEST_NETWORK_CASE(19)
+        TEST_NETWORK_CASE(20)
+    default:
+        return false;
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (v[i - 1] > v[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Every sorting network on every zero-one input, directly and through the library.
+ */
+static void test_networks(void)
+{
+    glbs_ctx_t ctx;
+    float      x[MAX_SAMPLE_NUM];
+    float      lanes[MAX_SAMPLE_NUM * GLBS_BATCH_LANES];
+    float      batch[GLBS_BATCH_LANES];
+    float      mean   = 0.0f;
+    bool       sorted = true;
+
+    test_begin();
+    glbs_ctx_init(&ctx, GPN_95);
+    for (size_t n = 2; n <= MAX_SAMPLE_NUM; n++) {
+        for (uint32_t bits = 0; bits < (UINT32_C(1) << n); bits++) {
+            TEST_EXPECT(test_network_sorts(n, bits), "network n=%zu input %#x", n, (unsigned)bits);
+            if (n < MIN_SAMPLE_NUM) {
+                continue;
+            }
+
+            // The in-place engine leaves the window sorted by the library's network.
+            for (size_t i = 0; i < n; i++) {
+                x[i] = (float)((bits >> i) & 1u);
+            }
+            glbs_ctx_process_inplace(&ctx, x, n, &mean);
+            sorted = true;
+            for (size_t i = 1; i < n; i++) {
+                sorted = sorted && x[i - 1] <= x[i];
+            }
+            TEST_EXPECT(sorted, "inplace n=%zu input %#x", n, (unsigned)bits);
+        }
+
+        // The lane networks of the batched engine, a tile of inputs at a time.
+        for (uint32_t base = 0; n >= MIN_SAMPLE_NUM && n <= 16 && base < (UINT32_C(1) << n);
+             base += GLBS_BATCH_LANES) {
+            for (size_t l = 0; l < GLBS_BATCH_LANES; l++) {
+                for (size_t i = 0; i < n; i++) {
+                    lanes[i * GLBS_BATCH_LANES + l] = (float)(((base + l) >> i) & 1u);
+                }
+            }
+            glbs_ctx_process_batch(&ctx, lanes, n, GLBS_BATCH_LANES, batch);
+            for (size_t l = 0; l < GLBS_BATCH_LANES; l++) {
+                for (size_t i = 0; i < n; i++) {
+                    x[i] = lanes[i * GLBS_BATCH_LANES + l];
+                }
+                glbs_ctx_process(&ctx, x, n, &mean);
+                TEST_EXPECT(memcmp(&mean, &batch[l], sizeof(float)) == 0, "batch n=%zu input %#x", n,
+                            (unsigned)(base + l));
+            }
+        }
+    }
+    test_end("networks");
+}
+
+/**
+ * @brief glbs_ctx_process() with each engine, the partial order and in place.
+ */
+static void test_ctx(glbs_engine_t engine, size_t partial, const char *name, size_t windows)
+{
+    static float      x[TEST_MAX_NUM];
+    static float      copy[TEST_MAX_NUM];
+    static double     wide[TEST_MAX_NUM];
+    static test_ref_t ref;
+    glbs_ctx_t        ctx;
+    float             mean    = 0.0f;
+    float             inplace = 0.0f;
+    size_t            num     = 0;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)test_below(4));
+        glbs_ctx_set_engine(&ctx, engine);
+        glbs_ctx_set_partial(&ctx, partial);
+        num = test_num(TEST_MAX_NUM);
+        test_fill_float(x, num);
+        if (test_below(8) == 0) {
+            test_far(x, num, 1);
+        }
+        test_widen(wide, x, num);
+        test_reference(wide, num, &ctx, NULL, &ref);
+
+        TEST_EXPECT(glbs_ctx_process(&ctx, x, num, &mean), "n=%zu failed", num);
+        memcpy(copy, x, num * sizeof(float));
+        TEST_EXPECT(glbs_ctx_process_inplace(&ctx, copy, num, &inplace), "inplace n=%zu failed", num);
+        TEST_EXPECT(memcmp(&mean, &inplace, sizeof(float)) == 0, "inplace n=%zu %.9g != %.9g", num, inplace, mean);
+        if (ref.marginal) {
+            s_skips++;
+            continue;
+        }
+        TEST_EXPECT(fabs(mean - ref.mean) <= test_tol(wide, num, &ref), "n=%zu mean %.9g, reference %.9g", num,
+                    mean, ref.mean);
+    }
+    TEST_EXPECT(!glbs_ctx_process(&ctx, x, MIN_SAMPLE_NUM - 1, &mean), "n=2 accepted");
+    test_end(name);
+}
+
+/**
+ * @brief glbs_ctx_process_ex(): mask, removal order and statistics.
+ */
+static void test_ex(size_t windows)
+{
+    static float      x[TEST_MAX_NUM];
+    static double     wide[TEST_MAX_NUM];
+    static test_ref_t ref;
+    static uint32_t   scratch[2 * TEST_MAX_NUM];
+    uint32_t          mask[GLBS_MASK_WORDS(TEST_MAX_NUM)];
+    size_t            order[TEST_MAX_NUM];
+    bool              keep[TEST_MAX_NUM];
+    glbs_stats_t      stats;
+    glbs_ctx_t        ctx;
+    size_t            num  = 0;
+    bool              same = true;
+    float             mean = 0.0f;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)test_below(4));
+        glbs_ctx_set_scratch(&ctx, scratch, sizeof(scratch));
+        num = test_num(TEST_MAX_NUM);
+        test_fill_float(x, num);
+        if (test_below(8) == 0) {
+            test_far(x, num, 1);
+        }
+        test_widen(wide, x, num);
+        test_reference(wide, num, &ctx, NULL, &ref);
+
+        TEST_EXPECT(glbs_ctx_process_ex(&ctx, x, num, mask, order, &stats), "n=%zu failed", num);
+        glbs_ctx_process(&ctx, x, num, &mean);
+        TEST_EXPECT(memcmp(&mean, &stats.mean, sizeof(float)) == 0, "n=%zu mean differs from glbs_ctx_process", num);
+        if (ref.marginal) {
+            s_skips++;
+            continue;
+        }
+
+        for (size_t i = 0; i < num; i++) {
+            keep[i] = (mask[i / 32] >> (i % 32)) & 1u;
+        }
+        same = stats.kept == ref.kept && test_same_removed(wide, num, keep, order, &ref);
+        TEST_EXPECT(same, "n=%zu kept %zu, reference %zu", num, stats.kept, ref.kept);
+        TEST_EXPECT(fabs(stats.mean - ref.mean) <= test_tol(wide, num, &ref), "n=%zu mean", num);
+    }
+    test_end("ex");
+}
+
+/**
+ * @brief glbs_ctx_process_masked(), with some samples invalid on entry.
+ */
+static void test_masked(size_t windows)
+{
+    static float      x[TEST_MAX_NUM];
+    static double     wide[TEST_MAX_NUM];
+    static double     valid_wide[TEST_MAX_NUM];
+    static test_ref_t ref;
+    uint32_t          mask[GLBS_MASK_WORDS(TEST_MAX_NUM)];
+    size_t            index[TEST_MAX_NUM];
+    bool              keep[TEST_MAX_NUM];
+    glbs_ctx_t        ctx;
+    size_t            num   = 0;
+    size_t            valid = 0;
+    float             mean  = 0.0f;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)test_below(4));
+        num = test_num(TEST_MAX_NUM);
+        test_fill_float(x, num);
+        if (test_below(8) == 0) {
+            test_far(x, num, 1);
+        }
+        test_widen(wide, x, num);
+
+        // About one sample in eight is known bad and cleared on entry.
+        memset(mask, 0, sizeof(mask));
+        valid = 0;
+        for (size_t i = 0; i < num; i++) {
+            if (test_below(8) != 0) {
+                mask[i / 32] |= UINT32_C(1) << (i % 32);
+                valid_wide[valid] = wide[i];
+                index[valid++]    = i;
+            }
+        }
+        if (valid < MIN_SAMPLE_NUM) {
+            TEST_EXPECT(!glbs_ctx_process_masked(&ctx, x, num, mask, &mean), "n=%zu accepted %zu valid", num, valid);
+            continue;
+        }
+        test_reference(valid_wide, valid, &ctx, NULL, &ref);
+
+        TEST_EXPECT(glbs_ctx_process_masked(&ctx, x, num, mask, &mean), "n=%zu failed", num);
+        if (ref.marginal) {
+            s_skips++;
+            continue;
+        }
+        for (size_t v = 0; v < valid; v++) {
+            keep[v] = (mask[index[v] / 32] >> (index[v] % 32)) & 1u;
+        }
+        TEST_EXPECT(test_same_removed(valid_wide, valid, keep, NULL, &ref), "n=%zu kept set differs", num);
+        TEST_EXPECT(fabs(mean - ref.mean) <= test_tol(valid_wide, valid, &ref), "n=%zu mean %.9g, reference %.9g",
+                    num, mean, ref.mean);
+    }
+    test_end("masked");
+}
+
+/**
+ * @brief glbs_ctx_process_levels() against one reference run per level.
+ */
+static void test_levels(size_t windows)
+{
+    static float      x[TEST_MAX_NUM];
+    static double     wide[TEST_MAX_NUM];
+    static test_ref_t ref[4];
+    static uint32_t   scratch[2 * TEST_MAX_NUM];
+    const gpn_mode_t  modes[4] = {GPN_80, GPN_99, GPN_90, GPN_95};
+    float             means[4];
+    size_t            removed[4];
+    size_t            order[TEST_MAX_NUM];
+    glbs_ctx_t        ctx;
+    glbs_ctx_t        level;
+    size_t            num      = 0;
+    bool              marginal = false;
+    bool              same     = true;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        glbs_ctx_init(&ctx, GPN_95);
+        glbs_ctx_set_scratch(&ctx, scratch, sizeof(scratch));
+        num = test_num(TEST_MAX_NUM);
+        test_fill_float(x, num);
+        if (test_below(8) == 0) {
+            test_far(x, num, 1);
+        }
+        test_widen(wide, x, num);
+        marginal = false;
+        for (size_t l = 0; l < 4; l++) {
+            glbs_ctx_init(&level, modes[l]);
+            test_reference(wide, num, &level, NULL, &ref[l]);
+            marginal = marginal || ref[l].marginal;
+        }
+
+        TEST_EXPECT(glbs_ctx_process_levels(&ctx, x, num, modes, 4, means, removed, order), "n=%zu failed", num);
+        if (marginal) {
+            s_skips++;
+            continue;
+        }
+        for (size_t l = 0; l < 4; l++) {
+            same = removed[l] == ref[l].removed && test_same_removed(wide, num, NULL, order, &ref[l]);
+            TEST_EXPECT(same, "n=%zu level %d removed %zu, reference %zu", num, (int)modes[l], removed[l],
+                        ref[l].removed);
+            TEST_EXPECT(fabs(means[l] - ref[l].mean) <= test_tol(wide, num, &ref[l]), "n=%zu level %d mean", num,
+                        (int)modes[l]);
+        }
+    }
+    test_end("levels");
+}
+
+/**
+ * @brief Batched, interleaved and strided windows against glbs_ctx_process(), bit for bit.
+ */
+static void test_batch(size_t rounds)
+{
+    static float x[64 * 100 * 3];
+    static float window[100];
+    float        results[100];
+    float        mean     = 0.0f;
+    size_t       num      = 0;
+    size_t       count    = 0;
+    size_t       stride   = 0;
+    glbs_ctx_t   ctx;
+
+    test_begin();
+    for (size_t r = 0; r < rounds; r++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)test_below(4));
+        glbs_ctx_set_engine(&ctx, (glbs_engine_t)test_below(2));
+        num    = (test_below(4) == 0) ? MAX_SAMPLE_NUM + 1 + test_below(40) : MIN_SAMPLE_NUM + test_below(18);
+        count  = 1 + test_below(100);
+        stride = count + test_below(3);
+        for (size_t i = 0; i < num; i++) {
+            test_fill_float(window, count);
+            for (size_t c = 0; c < stride; c++) {
+                x[i * stride + c] = (c < count) ? window[c] : NAN;
+            }
+        }
+        for (size_t c = 0; c < count; c++) {
+            if (test_below(8) == 0) {
+                test_far(x + c, num, stride);
+            }
+        }
+
+        TEST_EXPECT(glbs_ctx_process_interleaved(&ctx, x, num, count, stride, results), "interleaved failed");
+        for (size_t c = 0; c < count; c++) {
+            for (size_t i = 0; i < num; i++) {
+                window[i] = x[i * stride + c];
+            }
+            glbs_ctx_process(&ctx, window, num, &mean);
+            TEST_EXPECT(memcmp(&mean, &results[c], sizeof(float)) == 0, "interleaved n=%zu window %zu", num, c);
+            TEST_EXPECT(glbs_ctx_process_strided(&ctx, x + c, num, stride, &results[c]), "strided failed");
+            TEST_EXPECT(memcmp(&mean, &results[c], sizeof(float)) == 0, "strided n=%zu window %zu", num, c);
+        }
+
+        if (stride == count) {
+            TEST_EXPECT(glbs_ctx_process_batch(&ctx, x, num, count, results), "batch failed");
+            for (size_t c = 0; c < count; c++) {
+                for (size_t i = 0; i < num; i++) {
+                    window[i] = x[i * count + c];
+                }
+                glbs_ctx_process(&ctx, window, num, &mean);
+                TEST_EXPECT(memcmp(&mean, &results[c], sizeof(float)) == 0, "batch n=%zu window %zu", num, c);
+            }
+        }
+    }
+    TEST_EXPECT(!glbs_ctx_process_interleaved(&ctx, x, 10, 4, 3, results), "stride below channels accepted");
+    test_end("batch");
+}
+
+/**
+ * @brief Sliding-window stream against the reference over the current window.
+ */
+static void test_stream(size_t pushes)
+{
+    static const double       far[3] = {1e6, 1e20, 3e38};
+    static glbs_stream_node_t nodes[512];
+    static double             history[1 << 14];
+    static test_ref_t         ref;
+    glbs_stream_t             stream;
+    glbs_ctx_t                ctx;
+    size_t                    window = 0;
+    size_t                    count  = 0;
+    double                    glitch = 0.0;
+    float                     mean   = 0.0f;
+    float                     sample = 0.0f;
+    bool                      ok     = false;
+
+    test_begin();
+    for (size_t round = 0; round < 13; round++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)(round % 4));
+        glbs_ctx_set_engine(&ctx, (glbs_engine_t)(round / 4 % 2));
+        window = (round % 2 == 0) ? MIN_SAMPLE_NUM + test_below(18) : MAX_SAMPLE_NUM + test_below(490);
+        glitch = (round >= 8 && round < 11) ? far[round - 8] : 0.0;
+        TEST_EXPECT(glbs_stream_init(&stream, &ctx, nodes, window), "init window=%zu", window);
+
+        // Slowly drifting level with sparse spikes, so that the sums rebase.
+        // Rounds 8 to 10 add a far glitch of alternating sign every 600
+        // pushes, starting with the first sample. The last two add a burst
+        // of three, 1e10 to 3e38 away, so that the window holds several.
+        for (size_t i = 0; i < pushes && i < sizeof(history) / sizeof(history[0]); i++) {
+            sample     = (float)(1000.0 + 0.01 * (double)i + test_normal());
+            sample     = (test_below(20) == 0) ? sample + (float)(10.0 + 40.0 * test_uniform()) : sample;
+            sample     = (glitch > 0.0 && i % 600 == 0) ? (float)((i / 600 % 2 == 0) ? glitch : -glitch) : sample;
+            if (round >= 11 && i % 600 < 3) {
+                sample = (float)(((i % 2 == 0) ? 1.0 : -1.0) * pow(10.0, 10.0 + 28.47 * test_uniform()));
+            }
+            history[i] = sample;
+            ok         = glbs_stream_push(&stream, sample, &mean);
+            count      = (i + 1 < window) ? i + 1 : window;
+            TEST_EXPECT(ok == (count >= MIN_SAMPLE_NUM), "push %zu returned %d", i, (int)ok);
+            if (!ok) {
+                continue;
+            }
+            test_reference(history + i + 1 - count, count, &ctx, NULL, &ref);
+            if (ref.marginal) {
+                s_skips++;
+                continue;
+            }
+            TEST_EXPECT(fabs(mean - ref.mean) <= test_tol(history + i + 1 - count, count, &ref),
+                        "window=%zu push %zu mean %.9g, reference %.9g", window, i, mean, ref.mean);
+        }
+    }
+    test_end("stream");
+}
+
+/**
+ * @brief Runs the generalized ESD test naively.
+ *
+ * Each of the max_outliers steps recomputes the mean and standard deviation
+ * of the samples not yet removed and removes the one farthest from the mean,
+ * the lower value on a tie. The outliers are the samples removed up to the
+ * last step whose statistic exceeded its critical value.
+ *
+ * @param[in]  x            The samples.
+ * @param[in]  num          The number of samples.
+ * @param[in]  lambda       The critical values from glbs_esd_lambda().
+ * @param[in]  max_outliers The number of steps.
+ * @param[out] ref          The outcome; order lists every step's removal.
+ */
+static void test_esd_reference(const double *x, size_t num, const float *lambda, size_t max_outliers,
+                               test_ref_t *ref)
+{
+    static bool removed[TEST_MAX_NUM];
+    size_t      n = num;
+
+    ref->removed  = 0;
+    ref->marginal = false;
+    for (size_t i = 0; i < num; i++) {
+        removed[i] = false;
+    }
+    for (size_t r = 1; r <= max_outliers; r++) {
+        double mean   = 0.0;
+        double ss     = 0.0;
+        double lo_dev = -1.0;
+        double hi_dev = -1.0;
+        size_t lo     = 0;
+        size_t hi     = 0;
+        double stat   = 0.0;
+
+        for (size_t i = 0; i < num; i++) {
+            mean += removed[i] ? 0.0 : x[i];
+        }
+        mean /= n;
+        for (size_t i = 0; i < num; i++) {
+            if (removed[i]) {
+                continue;
+            }
+            ss += (x[i] - mean) * (x[i] - mean);
+            if (mean - x[i] > lo_dev) {
+                lo_dev = mean - x[i];
+                lo     = i;
+            }
+            if (x[i] - mean > hi_dev) {
+                hi_dev = x[i] - mean;
+                hi     = i;
+            }
+        }
+
+        stat = (ss > 0.0) ? ((hi_dev > lo_dev) ? hi_dev : lo_dev) / sqrt(ss / (n - 1)) : 0.0;
+        if (fabs(stat - lambda[r - 1]) < TEST_MARGIN * lambda[r - 1]) {
+            ref->marginal = true;
+        }
+        if (stat > lambda[r - 1]) {
+            ref->removed = r;
+        }
+        lo                = (hi_dev > lo_dev) ? hi : lo;
+        removed[lo]       = true;
+        ref->order[r - 1] = lo;
+        n--;
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        ref->keep[i] = true;
+    }
+    for (size_t r = 0; r < ref->removed; r++) {
+        ref->keep[ref->order[r]] = false;
+    }
+    ref->kept = num - ref->removed;
+    ref->mean = 0.0;
+    for (size_t i = 0; i < num; i++) {
+        ref->mean += ref->keep[i] ? x[i] : 0.0;
+    }
+    ref->mean /= ref->kept;
+}
+
+/**
+ * @brief glbs_ctx_process_esd() with precomputed and computed critical values.
+ */
+static void test_esd(size_t windows)
+{
+    static float      x[TEST_MAX_NUM];
+    static double     wide[TEST_MAX_NUM];
+    static float      lambda[TEST_MAX_NUM];
+    static test_ref_t ref;
+    glbs_ctx_t        ctx;
+    size_t            num      = 0;
+    size_t            r        = 0;
+    size_t            outliers = 0;
+    size_t            computed = 0;
+    float             mean     = 0.0f;
+    float             on_fly   = 0.0f;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)test_below(4));
+        glbs_ctx_set_engine(&ctx, (glbs_engine_t)test_below(2));
+        num = test_num(400);
+        r   = 1 + test_below(num - 2);
+        r   = (r > 40) ? 40 : r;
+        test_fill_float(x, num);
+        test_widen(wide, x, num);
+        TEST_EXPECT(glbs_esd_lambda(lambda, num, r, ctx.alpha), "lambda n=%zu r=%zu", num, r);
+        test_esd_reference(wide, num, lambda, r, &ref);
+
+        TEST_EXPECT(glbs_ctx_process_esd(&ctx, x, num, r, lambda, &mean, &outliers), "n=%zu failed", num);
+        TEST_EXPECT(glbs_ctx_process_esd(&ctx, x, num, r, NULL, &on_fly, &computed), "n=%zu failed", num);
+        if (ref.marginal) {
+            s_skips++;
+            continue;
+        }
+        // Without lambda the values are computed the same way as glbs_esd_lambda().
+        TEST_EXPECT(computed == outliers && on_fly == mean, "n=%zu r=%zu on the fly %zu, precomputed %zu", num, r,
+                    computed, outliers);
+        TEST_EXPECT(outliers == ref.removed, "n=%zu r=%zu outliers %zu, reference %zu", num, r, outliers,
+                    ref.removed);
+        TEST_EXPECT(fabs(mean - ref.mean) <= test_tol(wide, num, &ref), "n=%zu mean %.9g, reference %.9g", num,
+                    mean, ref.mean);
+    }
+    test_end("esd");
+}
+
+/**
+ * @brief Integer engine against the reference with its own critical values.
+ */
+static void test_fixed(size_t windows)
+{
+    static test_ref_t ref;
+    static uint32_t   kn[GLBS_GCRIT_TABLE_LEN(GLBS_FIX_MAX_NUM)];
+    double            wide[GLBS_FIX_MAX_NUM];
+    int16_t           x16[GLBS_FIX_MAX_NUM];
+    int32_t           x32[GLBS_FIX_MAX_NUM];
+    glbs_fix_t        fix16;
+    glbs_fix_t        fix32;
+    glbs_ctx_t        ctx;
+    int32_t           result = 0;
+    size_t            num    = 0;
+    double            center = 0.0;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        gpn_mode_t mode = (gpn_mode_t)test_below(4);
+
+        // Built-in constants: 16-bit codes, windows within the table.
+        TEST_EXPECT(glbs_fix_init(&fix16, mode), "init");
+        num    = MIN_SAMPLE_NUM + test_below(MAX_SAMPLE_NUM - MIN_SAMPLE_NUM + 1);
+        center = -20000.0 + 40000.0 * test_uniform();
+        test_fill(wide, num, center, 1.0 + 200.0 * test_uniform());
+        for (size_t i = 0; i < num; i++) {
+            wide[i] = (wide[i] > 32767.0) ? 32767.0 : (wide[i] < -32768.0) ? -32768.0 : wide[i];
+            x16[i]  = (int16_t)lrint(wide[i]);
+            wide[i] = x16[i];
+        }
+        test_reference(wide, num, NULL, fix16.kn, &ref);
+        TEST_EXPECT(glbs_fix_process_i16(&fix16, x16, num, &result), "i16 n=%zu failed", num);
+        if (ref.marginal) {
+            s_skips++;
+        } else {
+            TEST_EXPECT(fabs(result / 65536.0 - ref.mean) <= 1.0 / 65536.0, "i16 n=%zu mean %.6f, reference %.6f",
+                        num, result / 65536.0, ref.mean);
+        }
+
+        // Context critical values: 24-bit codes, windows up to GLBS_FIX_MAX_NUM.
+        glbs_ctx_init(&ctx, mode);
+        TEST_EXPECT(glbs_fix_init_ctx(&fix32, kn, &ctx, GLBS_FIX_MAX_NUM), "init ctx");
+        num    = MIN_SAMPLE_NUM + test_below(GLBS_FIX_MAX_NUM - MIN_SAMPLE_NUM + 1);
+        center = -4000000.0 + 8000000.0 * test_uniform();
+        test_fill(wide, num, center, 1.0 + 1000.0 * test_uniform());
+        for (size_t i = 0; i < num; i++) {
+            x32[i]  = (int32_t)lrint(wide[i]);
+            wide[i] = x32[i];
+        }
+        test_reference(wide, num, NULL, fix32.kn, &ref);
+        TEST_EXPECT(glbs_fix_process_i32(&fix32, x32, num, &result), "i32 n=%zu failed", num);
+        if (ref.marginal) {
+            s_skips++;
+        } else {
+            TEST_EXPECT(fabs(result / 256.0 - ref.mean) <= 1.0 / 256.0, "i32 n=%zu mean %.4f, reference %.4f", num,
+                        result / 256.0, ref.mean);
+        }
+    }
+    x32[0] = INT32_C(1) << 23;
+    TEST_EXPECT(!glbs_fix_process_i32(&fix32, x32, MIN_SAMPLE_NUM, &result), "2^23 accepted");
+    test_end("fixed");
+}
+
+/**
+ * @brief Typed entry points against the reference in double.
+ */
+static void test_typed(size_t windows)
+{
+    static double     wide[TEST_MAX_NUM];
+    static int16_t    x16[TEST_MAX_NUM];
+    static uint16_t   xu16[TEST_MAX_NUM];
+    static int32_t    x32[TEST_MAX_NUM];
+    static test_ref_t ref;
+    glbs_ctx_t        ctx;
+    double            result = 0.0;
+    double            spread = 0.0;
+    size_t            num    = 0;
+    size_t            type   = 0;
+    bool              ok     = false;
+
+    test_begin();
+    for (size_t w = 0; w < windows; w++) {
+        glbs_ctx_init(&ctx, (gpn_mode_t)test_below(4));
+        num    = test_num(TEST_MAX_NUM);
+        type   = test_below(4);
+        spread = (type < 2) ? 1.0 + 100.0 * test_uniform() : 1.0 + 10000.0 * test_uniform();
+        switch (type) {
+        case 0:
+            test_fill(wide, num, -10000.0 + 20000.0 * test_uniform(), spread);
+            for (size_t i = 0; i < num; i++) {
+                x16[i]  = (int16_t)((wide[i] > 32767.0) ? 32767 : (wide[i] < -32768.0) ? -32768 : lrint(wide[i]));
+                wide[i] = x16[i];
+            }
+            // A full-scale glitch in the first slot.
+            x16[0]  = (test_below(2) == 0) ? 32767 : -32767;
+            wide[0] = x16[0];
+            test_reference(wide, num, &ctx, NULL, &ref);
+            ok = glbs_ctx_process_i16(&ctx, x16, num, 1.0, 0.0, &result);
+            break;
+        case 1:
+            test_fill(wide, num, 20000.0 + 20000.0 * test_uniform(), spread);
+            for (size_t i = 0; i < num; i++) {
+                xu16[i] = (uint16_t)((wide[i] > 65535.0) ? 65535 : (wide[i] < 0.0) ? 0 : lrint(wide[i]));
+                wide[i] = xu16[i];
+            }
+            test_reference(wide, num, &ctx, NULL, &ref);
+            ok = glbs_ctx_process_u16(&ctx, xu16, num, 1.0, 0.0, &result);
+            break;
+        case 2:
+            test_fill(wide, num, -1e9 + 2e9 * test_uniform(), spread);
+            for (size_t i = 0; i < num; i++) {
+                x32[i]  = (int32_t)lrint(wide[i]);
+                wide[i] = x32[i];
+            }
+            // A glitch in the first slot, still within 2^24 of the median.
+            x32[0]  = x32[num / 2] + ((test_below(2) == 0) ? 8000000 : -8000000);
+            wide[0] = x32[0];
+            test_reference(wide, num, &ctx, NULL, &ref);
+            ok = glbs_ctx_process_i32(&ctx, x32, num, 1.0, 0.0, &result);
+            break;
+        default:
+            // A large common offset, resolved well below float resolution.
+            test_fill(wide, num, 1e6 + 1e5 * test_uniform(), 1e-3 * spread);
+            wide[0] = (test_below(2) == 0) ? 0.0 : wide[0];
+            test_reference(wide, num, &ctx, NULL, &ref);
+            ok = glbs_ctx_process_f64(&ctx, wide, num, 1.0, 0.0, &result);
+            spread *= 1e-3;
+            break;
+        }
+        TEST_EXPECT(ok, "type %zu n=%zu failed", type, num);
+        if (ref.marginal) {
+            s_skips++;
+            continue;
+        }
+        // The working copy holds float offsets from the median, so the
+        // precision is limited by the spread of the kept samples, not by
+        // their magnitude.
+        for (size_t i = 0; i < num; i++) {
+            spread = (ref.keep[i] && fabs(wide[i] - ref.mean) > spread) ? fabs(wide[i] - ref.mean) : spread;
+        }
+        TEST_EXPECT(fabs(result - ref.mean) <= 1e-5 * spread, "type %zu n=%zu mean %.9f, reference %.9f", type, num,
+                    result, ref.mean);
+    }
+
+    // The reported regressions, each with a glitch in slot 0.
+    {
+        const int32_t i32[6]      = {-8000000, 5, 6, 7, 5, 6};
+        const double  f64[8]      = {0.0,         1000000.002, 1000000.001, 1000000.003,
+                                     1000000.002, 1000000.002, 1000000.001, 1000000.003};
+        const int16_t i16[8]      = {32767, 100, 101, 102, 100, -32767, 101, 103};
+        float         as_float[8] = {0};
+        float         mean        = 0.0f;
+
+        glbs_ctx_init(&ctx, GPN_95);
+        TEST_EXPECT(glbs_ctx_process_i32(&ctx, i32, 6, 1.0, 0.0, &result) && fabs(result - 5.8) < 1e-9,
+                    "i32 slot 0: %.9f", result);
+        TEST_EXPECT(glbs_ctx_process_f64(&ctx, f64, 8, 1.0, 0.0, &result) && fabs(result - 1000000.002) < 1e-7,
+                    "f64 slot 0: %.9f", result);
+        for (size_t i = 0; i < 8; i++) {
+            as_float[i] = i16[i];
+        }
+        glbs_ctx_process(&ctx, as_float, 8, &mean);
+        TEST_EXPECT(glbs_ctx_process_i16(&ctx, i16, 8, 2.0, 1.0, &result) && fabs(result - (2.0 * mean + 1.0)) < 1e-4,
+                    "i16 slot 0: %.9f, float path %.9f", result, 2.0 * mean + 1.0);
+    }
+    test_end("typed");
+}
+
+#ifdef GLBS_THREADS
+/**
+ * @brief Thread pool: batches, descriptors and one large window, with and without far glitches.
+ */
+static void test_pool(void)
+{
+    static float      x[64 * 1000];
+    static double     large_wide[TEST_LARGE_NUM];
+    static float      large[TEST_LARGE_NUM];
+    static test_ref_t large_ref;
+    glbs_window_t     windows[200];
+    float             results[1000];
+    float             mean   = 0.0f;
+    double            far    = 0.0;
+    double            side   = 0.0;
+    glbs_ctx_t        ctx;
+    glbs_pool_t      *pool   = NULL;
+    size_t            num    = 0;
+    size_t            offset = 0;
+
+    test_begin();
+    for (size_t threads = 1; threads <= 4; threads++) {
+        pool = glbs_pool_create(threads, GLBS_SCRATCH_SIZE(64));
+        TEST_EXPECT(pool != NULL && glbs_pool_threads(pool) == threads, "create %zu", threads);
+        if (pool == NULL) {
+            continue;
+        }
+        glbs_ctx_init(&ctx, (gpn_mode_t)(threads - 1));
+
+        num = MIN_SAMPLE_NUM + test_below(62);
+        for (size_t w = 0; w < 1000; w++) {
+            test_fill_float(x + w * num, num);
+        }
+        TEST_EXPECT(glbs_pool_process(pool, &ctx, x, num, 1000, results), "process");
+        for (size_t w = 0; w < 1000; w++) {
+            glbs_ctx_process(&ctx, x + w * num, num, &mean);
+            TEST_EXPECT(memcmp(&mean, &results[w], sizeof(float)) == 0, "process n=%zu window %zu", num, w);
+        }
+
+        offset = 0;
+        for (size_t w = 0; w < 200; w++) {
+            windows[w].num     = MIN_SAMPLE_NUM + test_below(62);
+            windows[w].samples = x + offset;
+            test_fill_float(x + offset, windows[w].num);
+            offset += windows[w].num;
+        }
+        TEST_EXPECT(glbs_pool_process_windows(pool, &ctx, windows, 200, results), "windows");
+        for (size_t w = 0; w < 200; w++) {
+            glbs_ctx_process(&ctx, windows[w].samples, windows[w].num, &mean);
+            TEST_EXPECT(memcmp(&mean, &results[w], sizeof(float)) == 0, "window %zu", w);
+        }
+
+        // One large window; a small bound on the ends forces the retries. The
+        // second round adds far glitches, of both signs with 3 or 4 threads,
+        // and the third a few more of other magnitudes.
+        num = (threads % 2 == 0) ? TEST_LARGE_NUM : TEST_LARGE_NUM / 3;
+        far = (threads % 2 == 0) ? 3e38 : 1e20;
+        for (size_t i = 0; i < num; i++) {
+            large[i] = (float)(100.0 + test_normal());
+        }
+        for (size_t k = 0; k < 40; k++) {
+            large[test_below(num)] = (float)(100.0 + (test_below(2) ? 1.0 : -1.0) * (8.0 + 50.0 * test_uniform()));
+        }
+        for (size_t round = 0; round < 3; round++) {
+            for (size_t k = 0; round == 1 && k < 10; k++) {
+                side                   = (threads > 2 && k % 2 == 1) ? -1.0 : 1.0;
+                large[test_below(num)] = (float)(side * far * (0.5 + 0.5 * test_uniform()));
+            }
+            if (round == 2) {
+                test_far(large, num, 1);
+            }
+            for (size_t i = 0; i < num; i++) {
+                large_wide[i] = large[i];
+            }
+            test_reference(large_wide, num, &ctx, NULL, &large_ref);
+            for (size_t partial = 0; partial <= 4; partial += 4) {
+                glbs_ctx_set_partial(&ctx, partial);
+                TEST_EXPECT(glbs_pool_process_large(pool, &ctx, large, num, &mean), "large n=%zu failed", num);
+                if (large_ref.marginal) {
+                    s_skips++;
+                    continue;
+                }
+                TEST_EXPECT(fabs(mean - large_ref.mean) <= test_tol(large_wide, num, &large_ref),
+                            "large n=%zu k=%zu glitch %g mean %.9g, reference %.9g", num, partial,
+                            (round == 1) ? far : 0.0, mean, large_ref.mean);
+            }
+        }
+        glbs_pool_destroy(pool);
+    }
+    test_end("pool");
+}
+#endif /* GLBS_THREADS */
+
+/**
+ * @brief Consumer side of the ring check.
+ */
+typedef struct test_ring_job_s {
+    glbs_consumer_t consumer; /**< The consumer. */
+    bool            stop;     /**< Set by the producer when every window has been read. */
+} test_ring_job_t;
+
+/**
+ * @brief Runs the consumer until the producer sets the stop flag.
+ */
+static void *test_ring_consumer(void *arg)
+{
+    test_ring_job_t *job = arg;
+
+    glbs_consumer_run(&job->consumer, &job->stop);
+    return NULL;
+}
+
+/**
+ * @brief SPSC ring with the main thread as producer and a consumer thread.
+ */
+static void test_ring(void)
+{
+    static float                       samples[TEST_RING_SAMPLES];
+    static float                       storage[1024];
+    static glbs_ring_result_t          published[64];
+    static float                       window[64];
+    static glbs_ring_t GLBS_RING_ALIGNED sample_ring;
+    static glbs_ring_t GLBS_RING_ALIGNED result_ring;
+    const size_t                       layouts[3][2] = {{20, 20}, {64, 5}, {7, 30}};
+    test_ring_job_t                    job;
+    glbs_ring_result_t                 result;
+    glbs_ctx_t                         ctx;
+    pthread_t                          thread;
+    float                              mean     = 0.0f;
+    size_t                             written  = 0;
+    size_t                             expected = 0;
+    time_t                             progress = 0;
+    uint64_t                           received = 0;
+
+    test_begin();
+    glbs_ctx_init(&ctx, GPN_95);
+    for (size_t i = 0; i < TEST_RING_SAMPLES; i++) {
+        samples[i] = (float)(100.0 + test_normal() + ((test_below(30) == 0) ? 40.0 : 0.0));
+    }
+
+    for (size_t l = 0; l < 3; l++) {
+        size_t num  = layouts[l][0];
+        size_t step = layouts[l][1];
+
+        TEST_EXPECT(glbs_ring_init(&sample_ring, storage, 1024, sizeof(float)), "init samples");
+        TEST_EXPECT(glbs_ring_init(&result_ring, published, 64, sizeof(glbs_ring_result_t)), "init results");
+        TEST_EXPECT(glbs_consumer_init(&job.consumer, &ctx, &sample_ring, &result_ring, window, num, step), "init");
+        job.stop = false;
+        if (pthread_create(&thread, NULL, test_ring_consumer, &job) != 0) {
+            TEST_EXPECT(false, "pthread_create");
+            continue;
+        }
+
+        expected = (TEST_RING_SAMPLES - num) / step + 1;
+        written  = 0;
+        received = 0;
+        progress = time(NULL);
+        while (received < expected && time(NULL) - progress < 5) {
+            size_t chunk = 1 + test_below(64);
+            bool   idle  = true;
+
+            if (written < TEST_RING_SAMPLES) {
+                chunk = (chunk < TEST_RING_SAMPLES - written) ? chunk : TEST_RING_SAMPLES - written;
+                chunk = glbs_ring_write(&sample_ring, samples + written, chunk);
+                written += chunk;
+                idle = chunk == 0;
+            }
+            while (glbs_ring_read(&result_ring, &result, 1) == 1) {
+                glbs_ctx_process(&ctx, samples + result.window * step, num, &mean);
+                TEST_EXPECT(result.window == received, "window %llu, expected %llu",
+                            (unsigned long long)result.window, (unsigned long long)received);
+                TEST_EXPECT(memcmp(&mean, &result.mean, sizeof(float)) == 0, "window %llu mean",
+                            (unsigned long long)result.window);
+                received++;
+                idle = false;
+            }
+            // Let the consumer run when both rings are stuck, e.g. on one core.
+            if (idle) {
+                sched_yield();
+            } else {
+                progress = time(NULL);
+            }
+        }
+        TEST_EXPECT(received == expected, "num=%zu step=%zu stalled for 5 s after %llu of %zu windows", num, step,
+                    (unsigned long long)received, expected);
+        __atomic_store_n(&job.stop, true, __ATOMIC_RELEASE);
+        pthread_join(thread, NULL);
+        TEST_EXPECT(glbs_ring_count(&result_ring) == 0, "extra results");
+    }
+    test_end("ring");
+}
+
+#ifdef GLBS_INSTRUMENT
+/**
+ * @brief Every counted call, failed or not, enters the latency histogram once.
+ */
+static void test_counters(void)
+{
+    glbs_counters_t counters;
+    uint64_t        histogram = 0;
+
+    test_begin();
+    glbs_counters_read(&counters);
+    for (size_t b = 0; b < GLBS_LATENCY_BUCKETS; b++) {
+        histogram += counters.latency[b];
+    }
+    TEST_EXPECT(histogram == counters.calls, "histogram %llu, calls %llu", (unsigned long long)histogram,
+                (unsigned long long)counters.calls);
+    TEST_EXPECT(counters.rejected > 0 && counters.exhausted > 0, "rejected %llu, exhausted %llu",
+                (unsigned long long)counters.rejected, (unsigned long long)counters.exhausted);
+    test_end("counters");
+}
+#endif /* GLBS_INSTRUMENT */
+
+int main(int argc, char **argv)
+{
+    size_t windows = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            s_seed = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-w") == 0) {
+            windows = strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [-s seed] [-w windows]\n", argv[0]);
+            return 1;
+        }
+    }
+    printf("seed %llu, %zu windows per engine\n", (unsigned long long)s_seed, windows);
+
+    test_gcrit();
+    test_networks();
+    test_ctx(GLBS_ENGINE_SORTED, 0, "ctx", windows);
+    test_ctx(GLBS_ENGINE_SQUARED, 0, "squared", windows);
+    test_ctx(GLBS_ENGINE_SORTED, 8, "partial", windows);
+    test_ex(windows);
+    test_masked(windows);
+    test_levels(windows);
+    test_batch(windows / 20);
+    test_stream(windows);
+    test_esd(windows);
+    test_fixed(windows);
+    test_typed(windows);
+#ifdef GLBS_THREADS
+    test_pool();
+#endif
+    test_ring();
+#ifdef GLBS_INSTRUMENT
+    test_counters();
+#endif
+
+    printf("%s\n", (s_total_failed == 0) ? "all checks passed" : "some checks FAILED");
+    return (s_total_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,867 @@
+/**
+ * @file glbs_filter.c
+ * @author wdfk-prog
+ * @brief Offline bulk filter of binary and CSV sensor logs.
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Binary input (the default) is a flat file of little-endian float32 samples.
+ * The tool maps it, cuts it into windows of -n samples starting every -s
+ * samples (consecutive windows by default, sliding ones with a smaller step)
+ * and runs the Grubbs' test on every window across a thread pool. The windows
+ * are read straight from the mapping and the results written straight into
+ * mapped output files, so nothing is copied besides the working copy of the
+ * test itself. Trailing samples that do not fill a window are skipped.
+ *
+ *     -o file  One float32 cleaned mean per window, little-endian.
+ *     -m file  GLBS_MASK_WORDS(n) uint32 words per window, little-endian, with a
+ *              set bit for every kept sample as in glbs_ctx_process_ex().
+ *
+ * CSV input (-f csv, or a .csv name, or "-" for stdin) holds one
+ * "timestamp,channel,value" row per sample; a first row that does not parse is
+ * taken as a header. The file is streamed in fixed-size chunks and the values
+ * are parsed without strtof() on the common path. Rows are grouped by channel
+ * into windows of -n samples every -s samples, and full windows are collected
+ * into batches that run on the thread pool through the batched engine. Memory
+ * stays bounded by the chunk, one window per channel and one batch, whatever
+ * the size of the input. Each window produces a "channel,window,mean" row on
+ * -o, or on stdout without -o, in the order the windows fill up.
+ *
+ * Build, from a directory holding the library sources:
+ *
+ *     cc -O2 -DGLBS_THREADS -I. tools/glbs_filter.c glbs.c glbs_simd.c glbs_pool.c -lm -pthread -o glbs_filter
+ *
+ * Usage: glbs_filter [-f bin|csv] [-n num] [-s step] [-l level] [-t threads] [-c channels] [-o out] [-m masks] input
+ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "glbs.h"
+
+#ifndef GLBS_THREADS
+#error "glbs_filter needs the thread pool: build with -DGLBS_THREADS and glbs_pool.c"
+#endif
+
+/**
+ * @brief Default window size.
+ */
+#define FILTER_DEFAULT_NUM MAX_SAMPLE_NUM
+
+/**
+ * @brief Default limit on the distinct channels of a CSV input.
+ */
+#define FILTER_DEFAULT_CHANNELS 1024
+
+/**
+ * @brief Bytes read from a CSV input at a time; also the longest row.
+ */
+#define FILTER_CSV_CHUNK (1u << 20)
+
+/**
+ * @brief Samples collected per batch of CSV windows.
+ */
+#define FILTER_CSV_BATCH_SAMPLES (1u << 22)
+
+/**
+ * @brief Windows per chunk of a batch handed to a worker, a multiple of
+ *        GLBS_BATCH_LANES.
+ */
+#define FILTER_CSV_CHUNK_WINDOWS (16 * GLBS_BATCH_LANES)
+
+/**
+ * @brief Longest value handed to the strtof() fallback.
+ */
+#define FILTER_FLOAT_MAX_LEN 64
+
+/**
+ * @brief Input formats.
+ */
+typedef enum filter_format_e {
+    FILTER_FORMAT_AUTO = 0, /*!< CSV for a .csv name or stdin, binary otherwise. */
+    FILTER_FORMAT_BIN,      /*!< Little-endian float32 samples. */
+    FILTER_FORMAT_CSV,      /*!< timestamp,channel,value rows. */
+} filter_format_t;
+
+/**
+ * @brief Command-line options.
+ */
+typedef struct filter_opts_s {
+    filter_format_t format;   /**< Input format. */
+    size_t          num;      /**< Samples per window. */
+    size_t          step;     /**< Samples between window starts. */
+    size_t          threads;  /**< Worker threads, 0 for one per processor. */
+    size_t          channels; /**< Limit on the CSV channels. */
+    gpn_mode_t      mode;     /**< Confidence level. */
+    const char     *input;    /**< Input path, "-" for stdin. */
+    const char     *out;      /**< Output path, or NULL. */
+    const char     *masks;    /**< Mask output path, or NULL. */
+} filter_opts_t;
+
+/**
+ * @brief A mapped file.
+ */
+typedef struct filter_map_s {
+    int    fd;   /**< File descriptor, -1 if unused. */
+    void  *addr; /**< Start of the mapping, NULL if unused. */
+    size_t size; /**< Length of the mapping in bytes. */
+} filter_map_t;
+
+/**
+ * @brief Shared state of a run. Each window writes only its own outputs.
+ */
+typedef struct filter_job_s {
+    const float *samples; /**< The mapped input. */
+    size_t       num;     /**< Samples per window. */
+    size_t       step;    /**< Samples between the starts of two windows. */
+    float       *means;   /**< Mapped mean output, or NULL. */
+    uint32_t    *masks;   /**< Mapped mask output, or NULL. */
+    size_t       words;   /**< Mask words per window. */
+    size_t       failed;  /**< Number of windows that could not be processed. */
+} filter_job_t;
+
+/**
+ * @brief Returns true on a little-endian host, where the log needs no swapping.
+ */
+static bool filter_little_endian(void)
+{
+    const uint32_t probe = 1;
+
+    return *(const uint8_t *)&probe == 1;
+}
+
+/**
+ * @brief Maps an input file read-only for one sequential pass.
+ */
+static bool filter_map_input(filter_map_t *map, const char *path)
+{
+    struct stat st;
+
+    map->fd = open(path, O_RDONLY);
+    if (map->fd < 0 || fstat(map->fd, &st) != 0) {
+        perror(path);
+        return false;
+    }
+    map->size = (size_t)st.st_size;
+    if (map->size == 0) {
+        return true;
+    }
+    map->addr = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, map->fd, 0);
+    if (map->addr == MAP_FAILED) {
+        map->addr = NULL;
+        perror(path);
+        return false;
+    }
+    // Every byte is read once, front to back within each worker's share:
+    // ask for aggressive read-ahead and early reclaim behind the readers.
+    madvise(map->addr, map->size, MADV_SEQUENTIAL);
+    return true;
+}
+
+/**
+ * @brief Creates an output file of the given size and maps it for writing.
+ */
+static bool filter_map_output(filter_map_t *map, const char *path, size_t size)
+{
+    map->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (map->fd < 0 || ftruncate(map->fd, (off_t)size) != 0) {
+        perror(path);
+        return false;
+    }
+    map->size = size;
+    if (size == 0) {
+        return true;
+    }
+    map->addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+    if (map->addr == MAP_FAILED) {
+        map->addr = NULL;
+        perror(path);
+        return false;
+    }
+    madvise(map->addr, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+static void filter_unmap(filter_map_t *map)
+{
+    if (map->addr != NULL) {
+        munmap(map->addr, map->size);
+    }
+    if (map->fd >= 0) {
+        close(map->fd);
+    }
+}
+
+/**
+ * @brief Processes windows [begin, end) on one worker of the pool.
+ */
+static void filter_windows(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    filter_job_t *job    = arg;
+    glbs_stats_t  stats  = {0};
+    size_t        failed = 0;
+
+    for (size_t w = begin; w < end; w++) {
+        const float *window = job->samples + w * job->step;
+        uint32_t    *mask   = (job->masks != NULL) ? job->masks + w * job->words : NULL;
+        bool         ok     = false;
+
+        if (mask != NULL) {
+            ok = glbs_ctx_process_ex(ctx, window, job->num, mask, NULL, &stats);
+        } else {
+            ok = glbs_ctx_process(ctx, window, job->num, &stats.mean);
+        }
+        if (!ok) {
+            failed++;
+            continue;
+        }
+        if (job->means != NULL) {
+            job->means[w] = stats.mean;
+        }
+    }
+    if (failed > 0) {
+        __atomic_fetch_add(&job->failed, failed, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Parses a confidence level given as 99, 95, 90 or 80.
+ */
+static bool filter_parse_level(const char *text, gpn_mode_t *mode)
+{
+    static const struct {
+        const char *name;
+        gpn_mode_t  mode;
+    } levels[] = {{"99", GPN_99}, {"95", GPN_95}, {"90", GPN_90}, {"80", GPN_80}};
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        if (strcmp(text, levels[i].name) == 0) {
+            *mode = levels[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Filters a binary log through the mapping.
+ *
+ * @return int The exit status.
+ */
+static int filter_run_bin(const filter_opts_t *opts)
+{
+    filter_map_t in        = {-1, NULL, 0};
+    filter_map_t out_means = {-1, NULL, 0};
+    filter_map_t out_masks = {-1, NULL, 0};
+    filter_job_t job       = {0};
+    glbs_pool_t *pool      = NULL;
+    glbs_ctx_t   ctx;
+    size_t       total     = 0;
+    size_t       windows   = 0;
+    size_t       covered   = 0;
+    int          status    = 1;
+
+    if (!filter_little_endian()) {
+        fprintf(stderr, "the log is little-endian float32; big-endian hosts are not supported\n");
+        return 1;
+    }
+    if (!filter_map_input(&in, opts->input)) {
+        goto out;
+    }
+    total   = in.size / sizeof(float);
+    windows = (total >= opts->num) ? (total - opts->num) / opts->step + 1 : 0;
+    covered = (windows > 0) ? (windows - 1) * opts->step + opts->num : 0;
+    if (covered < total || in.size % sizeof(float) != 0) {
+        fprintf(stderr, "%s: %zu trailing samples do not fill a window and are skipped\n", opts->input,
+                total - covered);
+    }
+
+    job.samples = in.addr;
+    job.num     = opts->num;
+    job.step    = opts->step;
+    job.words   = GLBS_MASK_WORDS(opts->num);
+    if (opts->out != NULL) {
+        if (!filter_map_output(&out_means, opts->out, windows * sizeof(float))) {
+            goto out;
+        }
+        job.means = out_means.addr;
+    }
+    if (opts->masks != NULL) {
+        if (!filter_map_output(&out_masks, opts->masks, windows * job.words * sizeof(uint32_t))) {
+            goto out;
+        }
+        job.masks = out_masks.addr;
+    }
+
+    // Windows above MAX_SAMPLE_NUM need a scratch buffer for the extended
+    // engine; each worker gets its own.
+    pool = glbs_pool_create(opts->threads, (opts->num > MAX_SAMPLE_NUM) ? GLBS_SCRATCH_SIZE(opts->num) : 0);
+    if (pool == NULL) {
+        fprintf(stderr, "cannot create the thread pool\n");
+        goto out;
+    }
+    glbs_ctx_init(&ctx, opts->mode);
+    if (!glbs_pool_run(pool, &ctx, windows, 0, filter_windows, &job)) {
+        goto out;
+    }
+    if (job.failed > 0) {
+        fprintf(stderr, "%zu of %zu windows failed\n", job.failed, windows);
+        goto out;
+    }
+    fprintf(stderr, "%zu windows of %zu samples, %zu threads\n", windows, opts->num, glbs_pool_threads(pool));
+    status = 0;
+
+out:
+    glbs_pool_destroy(pool);
+    filter_unmap(&out_masks);
+    filter_unmap(&out_means);
+    filter_unmap(&in);
+    return status;
+}
+
+/**
+ * @brief Window being filled for one CSV channel.
+ */
+typedef struct filter_channel_s {
+    char   *name;   /**< Channel name, NUL-terminated, NULL for a free slot. */
+    size_t  len;    /**< Length of the name. */
+    float  *window; /**< The samples collected so far. */
+    size_t  fill;   /**< Number of samples in the window. */
+    size_t  skip;   /**< Samples to drop before the next window, for steps above num. */
+    size_t  count;  /**< Windows completed so far. */
+} filter_channel_t;
+
+/**
+ * @brief State of a CSV run.
+ */
+typedef struct filter_csv_s {
+    const filter_opts_t *opts;     /**< The options. */
+    glbs_pool_t         *pool;     /**< Pool running the batches. */
+    glbs_ctx_t           ctx;      /**< Context copied into the workers. */
+    FILE                *out;      /**< Text output. */
+    filter_channel_t    *table;    /**< Open-addressing table of the channels. */
+    size_t               mask;     /**< Table size minus one; the size is a power of two. */
+    size_t               used;     /**< Channels in the table. */
+    float               *batch;    /**< Full windows in SoA layout, stride capacity. */
+    float               *results;  /**< Means of the batch. */
+    filter_channel_t   **owner;    /**< Channel of each window of the batch. */
+    size_t              *index;    /**< Per-channel number of each window of the batch. */
+    size_t               capacity; /**< Windows per batch. */
+    size_t               windows;  /**< Windows in the batch. */
+    size_t               done;     /**< Windows written. */
+    size_t               rows;     /**< Rows read. */
+    size_t               bad;      /**< Malformed rows skipped. */
+    bool                 failed;   /**< Set when a batch could not be processed. */
+} filter_csv_t;
+
+/**
+ * @brief Powers of ten exactly representable in a double.
+ */
+static const double s_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * @brief Parses the fallback cases of filter_parse_float() with strtof().
+ */
+static bool filter_parse_float_slow(const char *text, size_t len, float *value)
+{
+    char  buffer[FILTER_FLOAT_MAX_LEN + 1];
+    char *end = NULL;
+
+    if (len == 0 || len > FILTER_FLOAT_MAX_LEN) {
+        return false;
+    }
+    memcpy(buffer, text, len);
+    buffer[len] = '\0';
+    *value      = strtof(buffer, &end);
+    return end == buffer + len;
+}
+
+/**
+ * @brief Parses a decimal float, rounded exactly as strtof() would.
+ *
+ * Up to 19 significant digits are gathered into an integer. If it is at most
+ * 2^53 and the decimal exponent at most 22 in magnitude, both it and the power
+ * of ten are exact doubles, so one multiply or divide gives the correctly
+ * rounded double (Clinger's fast path). Rounding that double to float is then
+ * exact too unless it lies precisely halfway between two floats, where the
+ * original digits may lie to either side. That case, denormal or overflowing
+ * results, longer mantissas, larger exponents, inf and nan go to strtof().
+ *
+ * @param[in]  text  The value, without surrounding blanks.
+ * @param[in]  len   Its length.
+ * @param[out] value Receives the value.
+ *
+ * @return bool Returns true if the whole text is a number.
+ */
+static bool filter_parse_float(const char *text, size_t len, float *value)
+{
+    const char *p        = text;
+    const char *end      = text + len;
+    uint64_t    mantissa = 0;
+    int         digits   = 0;
+    int         exp10    = 0;
+    int         exp_part = 0;
+    bool        negative = false;
+    bool        any      = false;
+    double      result   = 0.0;
+    union {
+        double   d;
+        uint64_t u;
+    } bits;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p++ == '-');
+    }
+    for (; p < end && *p >= '0' && *p <= '9'; p++, any = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits += (mantissa != 0);
+        } else {
+            exp10++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits += (mantissa != 0);
+                exp10--;
+            }
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        bool exp_negative = false;
+
+        p++;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exp_negative = (*p++ == '-');
+        }
+        if (p == end || *p < '0' || *p > '9') {
+            return false;
+        }
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            exp_part = (exp_part < 10000) ? exp_part * 10 + (*p - '0') : exp_part;
+        }
+        exp10 += exp_negative ? -exp_part : exp_part;
+    }
+    if (!any || p != end) {
+        return filter_parse_float_slow(text, len, value);
+    }
+
+    // From 19 digits on, the integer may have been truncated.
+    if (digits >= 19 || mantissa > (UINT64_C(1) << 53) || exp10 < -22 || exp10 > 22) {
+        return filter_parse_float_slow(text, len, value);
+    }
+    result = (exp10 < 0) ? (double)mantissa / s_pow10[-exp10] : (double)mantissa * s_pow10[exp10];
+    bits.d = result;
+    if (mantissa != 0 && (result < FLT_MIN || result > FLT_MAX || (bits.u & 0x1FFFFFFFu) == 0x10000000u)) {
+        return filter_parse_float_slow(text, len, value);
+    }
+    *value = (float)(negative ? -result : result);
+    return true;
+}
+
+/**
+ * @brief Hashes a channel name with FNV-1a.
+ */
+static size_t filter_hash(const char *name, size_t len)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * UINT64_C(1099511628211);
+    }
+    return (size_t)hash;
+}
+
+/**
+ * @brief Finds a channel, adding it on first sight.
+ *
+ * @return filter_channel_t* The channel, or NULL if the table is full or out of memory.
+ */
+static filter_channel_t *filter_channel(filter_csv_t *csv, const char *name, size_t len)
+{
+    filter_channel_t *channel = NULL;
+
+    for (size_t slot = filter_hash(name, len) & csv->mask;; slot = (slot + 1) & csv->mask) {
+        channel = &csv->table[slot];
+        if (channel->name == NULL) {
+            break;
+        }
+        if (channel->len == len && memcmp(channel->name, name, len) == 0) {
+            return channel;
+        }
+    }
+
+    if (csv->used == csv->opts->channels) {
+        return NULL;
+    }
+    channel->window = malloc(csv->opts->num * sizeof(float));
+    channel->name   = malloc(len + 1);
+    if (channel->window == NULL || channel->name == NULL) {
+        free(channel->window);
+        free(channel->name);
+        channel->window = NULL;
+        channel->name   = NULL;
+        return NULL;
+    }
+    memcpy(channel->name, name, len);
+    channel->name[len] = '\0';
+    channel->len       = len;
+    csv->used++;
+    return channel;
+}
+
+/**
+ * @brief Runs windows [begin, end) of a batch on one worker of the pool.
+ */
+static void filter_csv_windows(glbs_ctx_t *ctx, void *arg, size_t begin, size_t end)
+{
+    filter_csv_t *csv = arg;
+
+    // Each window is a column of the batch, so a range of columns is an
+    // interleaved buffer of end - begin channels with the batch as stride.
+    if (!glbs_ctx_process_interleaved(ctx, csv->batch + begin, csv->opts->num, end - begin, csv->capacity,
+                                      csv->results + begin)) {
+        __atomic_store_n(&csv->failed, true, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Processes the collected windows and writes their rows.
+ */
+static bool filter_csv_flush(filter_csv_t *csv)
+{
+    if (csv->windows == 0) {
+        return true;
+    }
+    if (!glbs_pool_run(csv->pool, &csv->ctx, csv->windows, FILTER_CSV_CHUNK_WINDOWS, filter_csv_windows, csv) ||
+        csv->failed) {
+        fprintf(stderr, "a batch of windows failed\n");
+        return false;
+    }
+    for (size_t w = 0; w < csv->windows; w++) {
+        fprintf(csv->out, "%s,%zu,%.9g\n", csv->owner[w]->name, csv->index[w], csv->results[w]);
+    }
+    csv->done += csv->windows;
+    csv->windows = 0;
+    return true;
+}
+
+/**
+ * @brief Adds one sample to its channel, moving a full window into the batch.
+ */
+static bool filter_csv_push(filter_csv_t *csv, filter_channel_t *channel, float value)
+{
+    size_t num  = csv->opts->num;
+    size_t step = csv->opts->step;
+    size_t slot = csv->windows;
+
+    if (channel->skip > 0) {
+        channel->skip--;
+        return true;
+    }
+    channel->window[channel->fill++] = value;
+    if (channel->fill < num) {
+        return true;
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        csv->batch[i * csv->capacity + slot] = channel->window[i];
+    }
+    csv->owner[slot] = channel;
+    csv->index[slot] = channel->count++;
+    csv->windows++;
+
+    // Keep the overlap of the next window, or drop the gap before it.
+    if (step < num) {
+        memmove(channel->window, channel->window + step, (num - step) * sizeof(float));
+        channel->fill = num - step;
+    } else {
+        channel->fill = 0;
+        channel->skip = step - num;
+    }
+    return (csv->windows < csv->capacity) ? true : filter_csv_flush(csv);
+}
+
+/**
+ * @brief Returns true for the blanks trimmed around CSV fields.
+ */
+static bool filter_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Parses one "timestamp,channel,value" row.
+ *
+ * @return bool Returns false only on a fatal error; malformed rows are counted.
+ */
+static bool filter_csv_row(filter_csv_t *csv, const char *row, const char *end)
+{
+    const char       *name     = memchr(row, ',', (size_t)(end - row));
+    const char       *value    = NULL;
+    const char       *name_end = NULL;
+    filter_channel_t *channel  = NULL;
+    float             sample   = 0.0f;
+
+    csv->rows++;
+    while (end > row && filter_blank(end[-1])) {
+        end--;
+    }
+    if (end == row) {
+        return true;
+    }
+    if (name != NULL) {
+        name++;
+        value = memchr(name, ',', (size_t)(end - name));
+    }
+    if (value == NULL) {
+        csv->bad += (csv->rows > 1);
+        return true;
+    }
+    name_end = value++;
+    while (name < name_end && filter_blank(*name)) {
+        name++;
+    }
+    while (name_end > name && filter_blank(name_end[-1])) {
+        name_end--;
+    }
+    while (value < end && filter_blank(*value)) {
+        value++;
+    }
+    if (!filter_parse_float(value, (size_t)(end - value), &sample)) {
+        // A first row that is not a sample is the header.
+        csv->bad += (csv->rows > 1);
+        return true;
+    }
+
+    channel = filter_channel(csv, name, (size_t)(name_end - name));
+    if (channel == NULL) {
+        fprintf(stderr, "more than %zu channels\n", csv->opts->channels);
+        return false;
+    }
+    return filter_csv_push(csv, channel, sample);
+}
+
+/**
+ * @brief Streams a CSV input through the batched engine.
+ *
+ * @return int The exit status.
+ */
+static int filter_run_csv(const filter_opts_t *opts)
+{
+    filter_csv_t csv     = {0};
+    size_t       size    = 1;
+    size_t       pending = 0;
+    size_t       partial = 0;
+    ssize_t      got     = 0;
+    char        *buffer  = NULL;
+    char        *row     = NULL;
+    char        *newline = NULL;
+    int          fd      = -1;
+    int          status  = 1;
+
+    csv.opts     = opts;
+    csv.out      = stdout;
+    csv.capacity = FILTER_CSV_BATCH_SAMPLES / opts->num;
+    csv.capacity = (csv.capacity < GLBS_BATCH_LANES) ? GLBS_BATCH_LANES : csv.capacity;
+    while (size < 2 * opts->channels) {
+        size *= 2;
+    }
+    csv.mask = size - 1;
+
+    fd = (strcmp(opts->input, "-") == 0) ? STDIN_FILENO : open(opts->input, O_RDONLY);
+    if (fd < 0) {
+        perror(opts->input);
+        return 1;
+    }
+    if (fd != STDIN_FILENO) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    if (opts->out != NULL) {
+        csv.out = fopen(opts->out, "w");
+        if (csv.out == NULL) {
+            perror(opts->out);
+            goto out;
+        }
+    }
+
+    buffer      = malloc(FILTER_CSV_CHUNK);
+    csv.table   = calloc(size, sizeof(filter_channel_t));
+    csv.batch   = malloc(opts->num * csv.capacity * sizeof(float));
+    csv.results = malloc(csv.capacity * sizeof(float));
+    csv.owner   = malloc(csv.capacity * sizeof(filter_channel_t *));
+    csv.index   = malloc(csv.capacity * sizeof(size_t));
+    csv.pool    = glbs_pool_create(opts->threads, (opts->num > MAX_SAMPLE_NUM) ? GLBS_SCRATCH_SIZE(opts->num) : 0);
+    if (buffer == NULL || csv.table == NULL || csv.batch == NULL || csv.results == NULL || csv.owner == NULL ||
+        csv.index == NULL || csv.pool == NULL) {
+        fprintf(stderr, "out of memory\n");
+        goto out;
+    }
+    glbs_ctx_init(&csv.ctx, opts->mode);
+
+    // Complete rows are parsed in place; the unfinished tail of a chunk moves
+    // to the front of the buffer and the next read appends to it.
+    while (1) {
+        got = read(fd, buffer + pending, FILTER_CSV_CHUNK - pending);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror(opts->input);
+            goto out;
+        }
+        pending += (size_t)got;
+        row = buffer;
+        while ((newline = memchr(row, '\n', pending - (size_t)(row - buffer))) != NULL) {
+            if (!filter_csv_row(&csv, row, newline)) {
+                goto out;
+            }
+            row = newline + 1;
+        }
+        pending -= (size_t)(row - buffer);
+        if (got == 0) {
+            // Last row without a newline.
+            if (pending > 0 && !filter_csv_row(&csv, row, row + pending)) {
+                goto out;
+            }
+            break;
+        }
+        if (pending == FILTER_CSV_CHUNK) {
+            fprintf(stderr, "%s: row longer than %u bytes\n", opts->input, FILTER_CSV_CHUNK);
+            goto out;
+        }
+        memmove(buffer, row, pending);
+    }
+    if (!filter_csv_flush(&csv)) {
+        goto out;
+    }
+
+    for (size_t c = 0; c < size; c++) {
+        partial += (csv.table[c].name != NULL) ? csv.table[c].fill : 0;
+    }
+    if (csv.bad > 0) {
+        fprintf(stderr, "%s: %zu malformed rows skipped\n", opts->input, csv.bad);
+    }
+    if (partial > 0) {
+        fprintf(stderr, "%s: %zu trailing samples do not fill a window and are skipped\n", opts->input, partial);
+    }
+    fprintf(stderr, "%zu rows, %zu channels, %zu windows of %zu samples, %zu threads\n", csv.rows, csv.used, csv.done,
+            opts->num, glbs_pool_threads(csv.pool));
+    status = 0;
+
+out:
+    if (csv.table != NULL) {
+        for (size_t c = 0; c < size; c++) {
+            free(csv.table[c].name);
+            free(csv.table[c].window);
+        }
+    }
+    glbs_pool_destroy(csv.pool);
+    free(csv.index);
+    free(csv.owner);
+    free(csv.results);
+    free(csv.batch);
+    free(csv.table);
+    free(buffer);
+    if (csv.out != NULL && csv.out != stdout) {
+        fclose(csv.out);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return status;
+}
+
+static void filter_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-f bin|csv] [-n num] [-s step] [-l level] [-t threads] [-c channels] [-o out] [-m masks] "
+            "input\n"
+            "  -f  Input format (default csv for a .csv name or -, bin otherwise)\n"
+            "  -n  Samples per window (default %d)\n"
+            "  -s  Samples between window starts (default num: consecutive windows)\n"
+            "  -l  Confidence level: 99, 95, 90 or 80 (default 95)\n"
+            "  -t  Worker threads (default one per online processor)\n"
+            "  -c  Most distinct channels of a CSV input (default %d)\n"
+            "  -o  Output: float32 means for bin, channel,window,mean rows for csv (default stdout)\n"
+            "  -m  Write the kept-sample mask of each window to this file (bin only)\n",
+            prog, FILTER_DEFAULT_NUM, FILTER_DEFAULT_CHANNELS);
+}
+
+int main(int argc, char **argv)
+{
+    filter_opts_t opts = {FILTER_FORMAT_AUTO, FILTER_DEFAULT_NUM, 0, 0, FILTER_DEFAULT_CHANNELS, GPN_95, NULL,
+                          NULL, NULL};
+    size_t        len  = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+            i++;
+            if (strcmp(argv[i], "bin") == 0) {
+                opts.format = FILTER_FORMAT_BIN;
+            } else if (strcmp(argv[i], "csv") == 0) {
+                opts.format = FILTER_FORMAT_CSV;
+            } else {
+                filter_usage(argv[0]);
+                return 1;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            opts.num = strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            opts.step = strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+            if (!filter_parse_level(argv[++i], &opts.mode)) {
+                filter_usage(argv[0]);
+                return 1;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+            opts.threads = strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+            opts.channels = strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+            opts.out = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+            opts.masks = argv[++i];
+        } else if ((argv[i][0] != '-' || strcmp(argv[i], "-") == 0) && opts.input == NULL) {
+            opts.input = argv[i];
+        } else {
+            filter_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.input == NULL || opts.num < MIN_SAMPLE_NUM || opts.num > UINT32_MAX || opts.channels == 0) {
+        filter_usage(argv[0]);
+        return 1;
+    }
+    opts.step = (opts.step == 0) ? opts.num : opts.step;
+
+    if (opts.format == FILTER_FORMAT_AUTO) {
+        len         = strlen(opts.input);
+        opts.format = (strcmp(opts.input, "-") == 0 || (len > 4 && strcmp(opts.input + len - 4, ".csv") == 0))
+                          ? FILTER_FORMAT_CSV
+                          : FILTER_FORMAT_BIN;
+    }
+    if (opts.format == FILTER_FORMAT_CSV) {
+        if (opts.masks != NULL) {
+            fprintf(stderr, "-m is only supported for binary input\n");
+            return 1;
+        }
+        return filter_run_csv(&opts);
+    }
+    if (opts.out == NULL && opts.masks == NULL) {
+        fprintf(stderr, "neither -o nor -m given, nothing is written\n");
+    }
+    return filter_run_bin(&opts);
+}
@@ -0,0 +1,418 @@
+/**
+ * @file glbs_profile.c
+ * @author wdfk-prog
+ * @brief Per-stage hardware counter profile of glbs_ctx_process().
+ * @version 1.0
+ * @date 2021-10-30
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Splits glbs_ctx_process() into its stages (copy, sort, sums, test) and runs
+ * each stage over a pool of windows with Linux perf_event_open counters
+ * (cycles, instructions, branch-misses, cache-misses) enabled only around that
+ * stage. Where the counters are unavailable, e.g. in containers or with
+ * perf_event_paranoid > 2, only clock_gettime timings are reported. The "total"
+ * row is the unsplit call for comparison. Output is CSV, one row per stage and
+ * window size, normalized per window.
+ *
+ * Build against the library compiled with GLBS_PROFILE defined:
+ *
+ *     cc -O2 -DGLBS_PROFILE -I. tools/glbs_profile.c glbs.c glbs_simd.c -lm -o glbs_profile
+ *
+ * Usage: glbs_profile [-n num[,num...]] [-r reps] [-c fraction] [-o file]
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "glbs.h"
+#include "glbs_internal.h"
+
+/**
+ * @brief Samples generated per window pool.
+ */
+#define PROFILE_POOL_SAMPLES (1u << 20)
+
+/**
+ * @brief Upper bound on the windows per pool.
+ */
+#define PROFILE_POOL_WINDOWS 4096
+
+/**
+ * @brief Largest number of window sizes on the command line.
+ */
+#define PROFILE_MAX_SIZES 32
+
+/**
+ * @brief Hardware counters, in group order.
+ */
+typedef enum profile_counter_e {
+    PROFILE_CYCLES = 0,
+    PROFILE_INSTRUCTIONS,
+    PROFILE_BRANCH_MISSES,
+    PROFILE_CACHE_MISSES,
+    PROFILE_COUNTER_NUM,
+} profile_counter_t;
+
+/**
+ * @brief Measured stages.
+ */
+typedef enum profile_stage_e {
+    PROFILE_STAGE_COPY = 0, /*!< Copy of the window into the working buffer. */
+    PROFILE_STAGE_SORT,     /*!< glbs_sort(). */
+    PROFILE_STAGE_SUMS,     /*!< glbs_trim_init(): sum and sum of squares. */
+    PROFILE_STAGE_TEST,     /*!< glbs_trim_step() loop and the mean. */
+    PROFILE_STAGE_TOTAL,    /*!< glbs_ctx_process() end to end. */
+    PROFILE_STAGE_NUM,
+} profile_stage_t;
+
+static const char *const s_stage_names[PROFILE_STAGE_NUM] = {"copy", "sort", "sums", "test", "total"};
+
+static const uint64_t s_counter_configs[PROFILE_COUNTER_NUM] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+
+/**
+ * @brief Counter group shared by all stages.
+ */
+typedef struct profile_counters_s {
+    int    fd[PROFILE_COUNTER_NUM];  /**< Event descriptors, -1 if unavailable. */
+    size_t slot[PROFILE_COUNTER_NUM]; /**< Position of each event in a group read. */
+    size_t opened;                    /**< Number of events in the group. */
+} profile_counters_t;
+
+/**
+ * @brief Accumulated measurements of one stage.
+ */
+typedef struct profile_totals_s {
+    double   ns;                         /**< Wall time in nanoseconds. */
+    uint64_t count[PROFILE_COUNTER_NUM]; /**< Counter totals. */
+} profile_totals_t;
+
+/**
+ * @brief Window pool and working state.
+ */
+typedef struct profile_pool_s {
+    size_t       num;     /**< Samples per window. */
+    size_t       windows; /**< Number of windows. */
+    float       *input;   /**< Windows back to back. */
+    float       *work;    /**< Working copies. */
+    glbs_trim_t *trims;   /**< Trim state of each window. */
+    glbs_ctx_t   ctx;     /**< Context under test. */
+    void        *scratch; /**< Scratch buffer attached to ctx. */
+} profile_pool_t;
+
+static volatile float s_sink;
+
+static uint64_t s_rng = UINT64_C(0x2545F4914F6CDD1D);
+
+static double profile_uniform(void)
+{
+    s_rng ^= s_rng >> 12;
+    s_rng ^= s_rng << 25;
+    s_rng ^= s_rng >> 27;
+    return (((s_rng * UINT64_C(2685821657736338717)) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+static double profile_normal(void)
+{
+    return sqrt(-2.0 * log(profile_uniform())) * cos(6.283185307179586 * profile_uniform());
+}
+
+static long profile_perf_open(struct perf_event_attr *attr, int group)
+{
+    return syscall(SYS_perf_event_open, attr, 0, -1, group, 0);
+}
+
+/**
+ * @brief Opens the counter group, leaving out events the CPU does not have.
+ *
+ * @return bool Returns true if at least the cycle counter is available.
+ */
+static bool profile_counters_open(profile_counters_t *pc)
+{
+    struct perf_event_attr attr;
+
+    pc->opened = 0;
+    for (int c = 0; c < PROFILE_COUNTER_NUM; c++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.size           = sizeof(attr);
+        attr.config         = s_counter_configs[c];
+        attr.disabled       = (c == PROFILE_CYCLES);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP;
+
+        pc->fd[c] = (int)profile_perf_open(&attr, (c == PROFILE_CYCLES) ? -1 : pc->fd[PROFILE_CYCLES]);
+        if (pc->fd[c] < 0) {
+            if (c == PROFILE_CYCLES) {
+                return false;
+            }
+            continue;
+        }
+        pc->slot[c] = pc->opened++;
+    }
+    return true;
+}
+
+static void profile_counters_close(profile_counters_t *pc)
+{
+    for (int c = 0; c < PROFILE_COUNTER_NUM; c++) {
+        if (pc->fd[c] >= 0) {
+            close(pc->fd[c]);
+        }
+    }
+}
+
+static double profile_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Runs one stage over every window of the pool.
+ */
+static void profile_stage_run(profile_pool_t *pool, profile_stage_t stage)
+{
+    float result = 0.0f;
+
+    for (size_t w = 0; w < pool->windows; w++) {
+        float *work = pool->work + w * pool->num;
+
+        switch (stage) {
+        case PROFILE_STAGE_COPY:
+            memcpy(work, pool->input + w * pool->num, pool->num * sizeof(float));
+            break;
+        case PROFILE_STAGE_SORT:
+            glbs_profile_sort(work, pool->num);
+            break;
+        case PROFILE_STAGE_SUMS:
+            glbs_profile_sums(&pool->trims[w], work, pool->num);
+            break;
+        case PROFILE_STAGE_TEST:
+            s_sink = glbs_profile_test(&pool->trims[w], &pool->ctx, work);
+            break;
+        default:
+            glbs_ctx_process(&pool->ctx, pool->input + w * pool->num, pool->num, &result);
+            s_sink = result;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Measures one stage and adds the result to its totals.
+ */
+static void profile_stage_measure(profile_pool_t *pool, profile_stage_t stage, const profile_counters_t *pc,
+                                  profile_totals_t *totals)
+{
+    uint64_t values[1 + PROFILE_COUNTER_NUM];
+    double   start = 0.0;
+
+    if (pc != NULL) {
+        ioctl(pc->fd[PROFILE_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(pc->fd[PROFILE_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    start = profile_now();
+    profile_stage_run(pool, stage);
+    totals->ns += profile_now() - start;
+    if (pc == NULL) {
+        return;
+    }
+    ioctl(pc->fd[PROFILE_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // Group read: the number of events, then one value per event.
+    if (read(pc->fd[PROFILE_CYCLES], values, sizeof(values)) < (ssize_t)((1 + pc->opened) * sizeof(uint64_t))) {
+        return;
+    }
+    for (int c = 0; c < PROFILE_COUNTER_NUM; c++) {
+        if (pc->fd[c] >= 0) {
+            totals->count[c] += values[1 + pc->slot[c]];
+        }
+    }
+}
+
+static bool profile_pool_init(profile_pool_t *pool, size_t num, double contamination)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->num     = num;
+    pool->windows = PROFILE_POOL_SAMPLES / num;
+    if (pool->windows > PROFILE_POOL_WINDOWS) {
+        pool->windows = PROFILE_POOL_WINDOWS;
+    }
+    if (pool->windows == 0) {
+        pool->windows = 1;
+    }
+
+    pool->input   = malloc(pool->windows * num * sizeof(float));
+    pool->work    = malloc(pool->windows * num * sizeof(float));
+    pool->trims   = malloc(pool->windows * sizeof(glbs_trim_t));
+    pool->scratch = malloc(GLBS_SCRATCH_SIZE(num));
+    if (pool->input == NULL || pool->work == NULL || pool->trims == NULL || pool->scratch == NULL) {
+        return false;
+    }
+
+    glbs_ctx_init(&pool->ctx, GPN_95);
+    glbs_ctx_set_scratch(&pool->ctx, pool->scratch, GLBS_SCRATCH_SIZE(num));
+    for (size_t k = 0; k < pool->windows * num; k++) {
+        pool->input[k] = (float)(100.0 + profile_normal());
+        if (profile_uniform() < contamination) {
+            pool->input[k] += (profile_uniform() < 0.5) ? 10.0f : -10.0f;
+        }
+    }
+    return true;
+}
+
+static void profile_pool_free(profile_pool_t *pool)
+{
+    free(pool->input);
+    free(pool->work);
+    free(pool->trims);
+    free(pool->scratch);
+}
+
+static void profile_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n num[,num...]] [-r reps] [-c fraction] [-o file]\n"
+            "  -n  Window sizes (default 8,20,64,1000,100000)\n"
+            "  -r  Repetitions per size (default 20)\n"
+            "  -c  Fraction of samples made outliers (default 0.05)\n"
+            "  -o  Write CSV to file instead of stdout\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    size_t             sizes[PROFILE_MAX_SIZES] = {8, 20, 64, 1000, 100000};
+    size_t             size_num                 = 5;
+    size_t             reps                     = 20;
+    double             contamination            = 0.05;
+    FILE              *out                      = stdout;
+    profile_counters_t counters;
+    profile_counters_t *pc                      = NULL;
+    profile_pool_t     pool;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            char *p   = argv[++i];
+            char *end = NULL;
+            size_num  = 0;
+            while (*p != '\0' && size_num < PROFILE_MAX_SIZES) {
+                sizes[size_num] = strtoul(p, &end, 0);
+                if (end == p || (*end != ',' && *end != '\0')) {
+                    fprintf(stderr, "invalid window size list: %s\n", argv[i]);
+                    return 1;
+                }
+                if (sizes[size_num] >= MIN_SAMPLE_NUM) {
+                    size_num++;
+                }
+                p = end + (*end == ',');
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+            char *end = NULL;
+            reps      = strtoul(argv[++i], &end, 0);
+            if (end == argv[i] || *end != '\0' || reps == 0) {
+                fprintf(stderr, "invalid repetition count: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+            char *end     = NULL;
+            contamination = strtod(argv[++i], &end);
+            if (end == argv[i] || *end != '\0' || !(contamination >= 0.0 && contamination <= 1.0)) {
+                fprintf(stderr, "invalid contamination fraction: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+            out = fopen(argv[++i], "w");
+            if (out == NULL) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else {
+            profile_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (profile_counters_open(&counters)) {
+        pc = &counters;
+    } else {
+        fprintf(stderr, "perf_event_open unavailable, reporting clock_gettime only\n");
+    }
+
+    fprintf(out, "stage,n,windows,reps,source,ns_per_window,cycles_per_window,instructions_per_window,ipc,"
+                 "branch_misses_per_window,cache_misses_per_window\n");
+
+    for (size_t s = 0; s < size_num; s++) {
+        profile_totals_t totals[PROFILE_STAGE_NUM];
+
+        if (!profile_pool_init(&pool, sizes[s], contamination)) {
+            fprintf(stderr, "out of memory at n=%zu\n", sizes[s]);
+            return 1;
+        }
+        memset(totals, 0, sizeof(totals));
+
+        // The stages run in pipeline order, so each one sees the output of the
+        // previous one; an untimed round warms caches first.
+        for (size_t r = 0; r <= reps; r++) {
+            for (int st = 0; st < PROFILE_STAGE_NUM; st++) {
+                profile_totals_t scratch_totals;
+
+                memset(&scratch_totals, 0, sizeof(scratch_totals));
+                profile_stage_measure(&pool, (profile_stage_t)st, pc, (r == 0) ? &scratch_totals : &totals[st]);
+            }
+        }
+
+        for (int st = 0; st < PROFILE_STAGE_NUM; st++) {
+            double calls = (double)pool.windows * reps;
+
+            fprintf(out, "%s,%zu,%zu,%zu,%s,%.2f", s_stage_names[st], pool.num, pool.windows, reps,
+                    (pc != NULL) ? "perf" : "clock", totals[st].ns / calls);
+            if (pc == NULL) {
+                fprintf(out, ",,,,,\n");
+                continue;
+            }
+            for (int c = 0; c < PROFILE_COUNTER_NUM; c++) {
+                if (c == PROFILE_BRANCH_MISSES) {
+                    // IPC sits between the instruction and branch-miss columns.
+                    if (totals[st].count[PROFILE_CYCLES] > 0 && pc->fd[PROFILE_INSTRUCTIONS] >= 0) {
+                        fprintf(out, ",%.3f",
+                                (double)totals[st].count[PROFILE_INSTRUCTIONS] / totals[st].count[PROFILE_CYCLES]);
+                    } else {
+                        fprintf(out, ",");
+                    }
+                }
+                if (pc->fd[c] >= 0) {
+                    fprintf(out, ",%.2f", totals[st].count[c] / calls);
+                } else {
+                    fprintf(out, ",");
+                }
+            }
+            fprintf(out, "\n");
+        }
+        profile_pool_free(&pool);
+    }
+
+    if (pc != NULL) {
+        profile_counters_close(pc);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}